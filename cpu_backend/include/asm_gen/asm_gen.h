@@ -0,0 +1,35 @@
+#ifndef ASM_GEN_H
+#define ASM_GEN_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define ASM_GEN_DEFAULT_INSTRUCTIONS 60000
+#define ASM_GEN_DEFAULT_LABEL_DENSITY 0.05
+#define ASM_GEN_DEFAULT_FORWARD_RATIO 0.5
+#define ASM_GEN_DEFAULT_COMMENT_RATIO 0.1
+#define ASM_GEN_DEFAULT_BRANCH_RATIO 0.2
+#define ASM_GEN_DEFAULT_SEED 1
+
+// Label names are letters only, LABEL_NAME_DIGITS base 26 digits give 26^5 unique labels
+#define ASM_GEN_LABEL_NAME_DIGITS 5
+
+typedef struct AsmGenConfig{
+    uint32_t instructions;
+    // Labels per instruction
+    double label_density;
+    // Part of label references, which point to labels defined later in file
+    double forward_ratio;
+    // Part of lines with comments, half of them are separate comment lines
+    double comment_ratio;
+    // Part of instructions, which reference labels (branches and calls)
+    double branch_ratio;
+    uint64_t seed;
+}AsmGenConfig;
+
+void asm_gen_config_init(AsmGenConfig* config);
+
+// Generated program assembles, but it isn't meant to be executed. Returns number of written lines.
+uint64_t asm_gen_write(FILE* output_file, AsmGenConfig* config);
+
+#endif // ASM_GEN_H
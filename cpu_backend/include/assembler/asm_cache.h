@@ -0,0 +1,17 @@
+#ifndef ASM_CACHE_H
+#define ASM_CACHE_H
+
+#include <stdbool.h>
+
+// Assembled programs are stored in $XDG_CACHE_HOME/cpu_emulator (or ~/.cache/cpu_emulator) as
+// <sha256>.bin and <sha256>.bin.sym, hash is taken over ASSEMBLER_VERSION and source text.
+#define ASM_CACHE_DIR_NAME "cpu_emulator"
+#define ASM_SOURCE_SUFFIX ".myasm"
+
+bool asm_cache_is_source(const char* file_name);
+
+// Path of cached bin for source, source is assembled in memory and stored on miss.
+// Returned path is allocated and must be freed.
+char* asm_cache_get(const char* source_file_name);
+
+#endif // ASM_CACHE_H
@@ -0,0 +1,65 @@
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+
+#include "instructions/instructions.h"
+#include "text_asm_parser/text_asm_parser.h"
+#include "symbols/symbols.h"
+#include "object/object.h"
+#include "binary_format/binary_format.h"
+
+// Must be changed with every change of assembler output, assembly cache is keyed by it
+#define ASSEMBLER_VERSION "myasm-2"
+
+// Stages of assembler after parsing, shared by assembler executable and benchmarks
+
+void assemble_text_instruction(BinInstruction* bin_instruction, TextInstruction* text_instruction);
+
+// bin_instructions_array must have room for text_instructions_array->count instructions
+void assemble_text_instructions_array(BinInstructionArray* bin_instructions_array,
+                                      TextInstructionArray* text_instructions_array);
+
+// Program options stored in bin container, shared by assembler and linker
+typedef struct ProgramOptions{
+    // Code is stored in compact variable length encoding
+    bool compact;
+    // Program starts from this label instead of first instruction
+    const char* entry_label;
+    // File with initial content of data stack
+    const char* data_file;
+    // Hints, which are 0, are found by stack depth analysis
+    StackHints stack_hints;
+    // Bounds of stacks and reasons of unbounded ones are printed
+    bool stack_report;
+}ProgramOptions;
+
+#define PROGRAM_OPTIONS_USAGE "[--compact] [--entry label] [--data file] [--stack-hints data_bytes:call_depth] " \
+                              "[--stack-report]"
+
+void program_options_init(ProgramOptions* options);
+
+// Consumes argv[*arg_count] and its value, if it is program option
+bool parse_program_option(int argc, char* argv[], int* arg_count, ProgramOptions* options);
+
+// Bin container with embedded symbols and stack hints, symbol_map must already contain labels
+void write_program_file(BinInstructionArray* bin_instructions_array, SymbolMap* symbol_map,
+                        const ProgramOptions* options, const char* output_bin_file);
+
+// Raw array of fixed instructions without container header
+void write_bin_file(BinInstructionArray* bin_instructions_array, const char* output_bin_file);
+
+// Symbol sidecar is written to output_bin_file + SYMBOL_FILE_SUFFIX
+void write_symbol_file(LabelTable* label_table, TextInstructionArray* text_instructions_array,
+                       const char* output_bin_file);
+
+// Same for single pass assembler, symbol_map already contains source lines
+void write_symbol_map_file(LabelTable* label_table, SymbolMap* symbol_map, const char* output_bin_file);
+
+// Symbol map already contains all labels and lines, used by linker
+void write_symbol_sidecar(SymbolMap* symbol_map, const char* output_bin_file);
+
+// Relocatable object: all defined labels are exported, undefined ones are imported and every
+// label arg gets relocation entry. Sections are allocated here and freed by object_file_free.
+void assemble_object_file(ObjectFile* object_file, TextInstructionArray* text_instructions_array,
+                          LabelTable* label_table);
+
+#endif // ASSEMBLER_H
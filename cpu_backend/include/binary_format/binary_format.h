@@ -0,0 +1,115 @@
+#ifndef BINARY_FORMAT_H
+#define BINARY_FORMAT_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "instructions/instructions.h"
+#include "symbols/symbols.h"
+
+// Bin file is container written by assembler and linker:
+//   ContainerHeader, then sections_count ContainerSection entries, then section contents.
+//   Code section holds code_size / 16 instructions in encoding from header, other sections are optional
+//   and unknown kinds are skipped, so new sections don't break old loaders.
+// Raw bin file without header (array of fixed 16 byte BinInstruction) and standalone compact file
+// (CompactHeader and compact stream) are still accepted by loader.
+#define CONTAINER_MAGIC "MYBN"
+#define CONTAINER_VERSION 1
+
+// Compact stream: instruction is op code byte, mode byte with '*' and 'x' flags of arg i in bits 2i and 2i + 1,
+// then num_of_args args as unsigned LEB128: registers and small immediates take 1-2 bytes.
+#define COMPACT_MAGIC "MYCE"
+#define COMPACT_MAX_INSTRUCTION_SIZE (2 + 3 * 5)
+
+typedef enum BinaryEncoding{
+    ENCODING_FIXED,
+    ENCODING_COMPACT,
+    // Not stored in files, returned by binary_detect_encoding for container
+    ENCODING_CONTAINER
+}BinaryEncoding;
+
+typedef enum ContainerSectionKind{
+    SECTION_CODE = 1,
+    // Initial content of data stack
+    SECTION_DATA = 2,
+    // Labels and source lines, delta encoded
+    SECTION_SYMBOLS = 3,
+    // StackHints
+    SECTION_STACK_HINTS = 4
+}ContainerSectionKind;
+
+typedef struct ContainerHeader{
+    char magic[4];
+    uint16_t version;
+    uint16_t encoding;
+    // Address of first executed instruction
+    uint32_t entry_point;
+    // Size of decoded code in bytes
+    uint32_t code_size;
+    uint32_t sections_count;
+}ContainerHeader;
+
+// Offset is counted from file start
+typedef struct ContainerSection{
+    uint32_t kind;
+    uint32_t offset;
+    uint32_t size;
+}ContainerSection;
+
+typedef struct CompactHeader{
+    char magic[4];
+    uint32_t instructions_count;
+}CompactHeader;
+
+// Upper bounds of stacks program needs, 0 if unknown. Loader allocates stacks of this size once
+typedef struct StackHints{
+    // Bytes
+    uint32_t data_stack_size;
+    // Return addresses
+    uint32_t call_stack_size;
+}StackHints;
+
+// Loaded program. Arrays are allocated by binary_image_read and freed by binary_image_free,
+// for binary_image_write they are owned by caller.
+typedef struct BinaryImage{
+    BinaryEncoding encoding;
+    uint32_t entry_point;
+    BinInstructionArray code;
+
+    // NULL if program starts with empty data stack
+    uint8_t* data;
+    uint32_t data_size;
+
+    StackHints stack_hints;
+
+    // Only written, loader skips symbols section: see binary_read_symbols
+    SymbolMap* symbol_map;
+}BinaryImage;
+
+// Every instruction produced by assembler can be encoded, others make encoder abort.
+// stream must have room for count * COMPACT_MAX_INSTRUCTION_SIZE bytes, returns used size.
+size_t compact_encode(const BinInstruction* instruction_list, uint32_t count, uint8_t* stream);
+
+// Decodes count instructions into fixed form, returns consumed size or 0 for malformed stream
+size_t compact_decode(const uint8_t* stream, size_t stream_size, BinInstruction* instruction_list, uint32_t count);
+
+BinaryEncoding binary_detect_encoding(const uint8_t* data, size_t size);
+
+// Empty fixed width image starting from address 0
+void binary_image_init(BinaryImage* image);
+
+// Reads bin file of any format, code is expanded into fixed instructions, aborts on malformed file
+void binary_image_read(const char* file_name, BinaryImage* image);
+
+void binary_image_write(const BinaryImage* image, const char* file_name);
+
+void binary_image_free(BinaryImage* image);
+
+// Only code of bin file of any format, aborts on error
+void binary_read_file(const char* file_name, BinInstructionArray* bin_instructions_array);
+
+// Symbols section of container or text symbol file, returns false if there are no symbols
+bool binary_read_symbols(const char* file_name, SymbolMap* symbol_map);
+
+#endif // BINARY_FORMAT_H
@@ -0,0 +1,54 @@
+#include <stdint.h>
+
+#include "./cpu.h"
+#include "symbols/symbols.h"
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#define CACHE_MAX_LEVELS 4
+#define CACHE_PC_SLOTS MAX_INSTRUCTIONS
+
+// Levels are given as comma separated size:associativity:line_size, sizes accept K and M suffixes
+#define CACHE_DEFAULT_CONFIG "32K:8:64,256K:8:64"
+
+typedef struct CacheLevel{
+    uint32_t size;
+    uint32_t associativity;
+    uint32_t line_size;
+
+    uint32_t line_bits;
+    uint32_t sets_mask;
+
+    // tags[set * associativity + way], last_use[] holds LRU stamps of the same ways
+    uint64_t* tags;
+    uint64_t* last_use;
+    uint64_t clock;
+
+    uint64_t hits;
+    uint64_t misses;
+}CacheLevel;
+
+typedef struct CacheSimulator{
+    uint32_t levels_count;
+    CacheLevel levels[CACHE_MAX_LEVELS];
+
+    // Indexed by instruction address / BIN_INSTRUCTION_SIZE:
+    // accesses reaching first level and misses on every level
+    uint64_t* pc_accesses;
+    uint64_t* pc_misses[CACHE_MAX_LEVELS];
+
+    SymbolMap symbol_map;
+}CacheSimulator;
+
+// Aborts on malformed config, symbol file is optional
+void cache_simulator_init(CacheSimulator* cache, const char* config, const char* symbol_file_name);
+
+// Guest data access of size bytes at address, attributed to instruction at pc
+void cache_simulator_access(CacheSimulator* cache, uint32_t pc, uint32_t address, uint32_t size);
+
+void cache_simulator_write_report(CacheSimulator* cache, const char* report_file_name);
+
+void cache_simulator_free(CacheSimulator* cache);
+
+#endif // CACHE_H
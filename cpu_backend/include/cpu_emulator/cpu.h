@@ -11,7 +11,7 @@
 
 #define BIN_INSTRUCTION_SIZE 16
 #define MAX_INSTRUCTIONS 65536   // 64K instructions max
-#define CODE_MEM_SIZE (MAX_INSTRUCTIONS * INSTRUCTION_SIZE) 
+#define CODE_MEM_SIZE (MAX_INSTRUCTIONS * BIN_INSTRUCTION_SIZE)
 
 #define CALL_STACK_INIT_SIZE 8192
 //#define DATA_STACK_INIT_SIZE 65536
@@ -38,7 +38,42 @@ typedef struct Cpu{
     // Stack implementation
     Stack* data_stack;
     Stack* call_stack;
+
+    // I/O volume
+    uint64_t input_values;
+    uint64_t output_values;
+    uint64_t output_bytes;
+
+    // Optional latency histograms of memory operations, NULL if disabled
+    struct LatencyRecorder* latency;
+
+    // Optional cache model fed with every data access, NULL if disabled
+    struct CacheSimulator* cache;
+
+    // Native functions called by hcl, NULL if program can't call host
+    const struct HostCallTable* host_calls;
+
+    // Results of vector instructions, grows to the longest vector and is reused
+    uint32_t* vector_scratch;
+    uint32_t vector_scratch_count;
 }Cpu;
 
+// Allocates program buffer and stacks, program is loaded separately
+void cpu_init(Cpu* cpu, Stack* data_stack, Stack* call_stack);
+
+// Allocates everything once with stack sizes from image hints, then loads code and initial data.
+// Execution starts from image entry point.
+void cpu_init_image(Cpu* cpu, Stack* data_stack, Stack* call_stack, const struct BinaryImage* image);
+
+// Stacks sized by image hints, default sizes if image is NULL or has no hints
+void cpu_stacks_init(Stack* data_stack, Stack* call_stack, const struct BinaryImage* image);
+
+void cpu_load_program(Cpu* cpu, const uint8_t* program, size_t program_size);
+
+// Runs until hlt, metrics are updated every METRICS_UPDATE_PERIOD instructions
+void cpu_execute(Cpu* cpu, struct Metrics* metrics);
+
+void cpu_free(Cpu* cpu);
+
 
 #endif 
@@ -2,6 +2,7 @@
 
 #include "stack/stack.h"
 #include "./cpu.h"
+#include "instructions/instructions.h"
 
 #ifndef CPU_INSTRUCTIONS
 #define CPU_INSTRUCTIONS
@@ -19,6 +20,25 @@ typedef struct CpuInstructionArgs{
 
 void cpu_critical_error(Cpu* cpu, const char* error_message);
 
+// Inline, so execution loops in different files don't pay for extra call
+static inline void instruction_execute(Cpu* cpu){
+    uint32_t op_code = *(uint32_t*)(cpu->program_buffer + cpu->regs[RPC]);
+    op_code = (op_code >> 24) & 0xFF;
+    if(DEBUG)
+        printf("Instruction: %s\n\n", instruction_set[op_code].op_name);
+
+    instruction_set[op_code].cpu_instruction_pointer(cpu);
+}
+
+void parse_instruction_operands(Cpu* cpu, CpuInstructionArgs* cpu_instruction_args, int num_of_args);
+
+uint32_t get_runtime_operand_value(Cpu* cpu, CpuInstructionArg* cpu_instruction_arg);
+
+void set_runtime_operand_value(Cpu* cpu, CpuInstructionArg* cpu_instruction_arg, uint32_t value);
+
+// Address of memory operand: immediate or value of register
+uint32_t get_runtime_operand_address(Cpu* cpu, CpuInstructionArg* cpu_instruction_arg);
+
 void inp(Cpu* cpu);
 
 void out(Cpu* cpu);
@@ -67,4 +87,34 @@ void ret(Cpu* cpu);
 
 void hlt(Cpu* cpu);
 
+// --------------------------------------------------------------------
+// Vector instructions over arg 2 words of memory at arg 0 and arg 1 addresses,
+// all words are read before result is written
+
+// *dst[i] += *src[i]
+void vad(Cpu* cpu);
+
+// *dst[i] *= *src[i]
+void vml(Cpu* cpu);
+
+// *dst[i] = *dst[i] == *src[i] ? 1 : 0
+void vcm(Cpu* cpu);
+
+// dst = sum of *src[i]
+void vsm(Cpu* cpu);
+
+// --------------------------------------------------------------------
+// Bulk memory instructions over arg 2 bytes, destination range may extend stack like mov
+
+// Copies bytes from *src to *dst, ranges may overlap
+void bmv(Cpu* cpu);
+
+// Sets bytes from *dst to low byte of value
+void bfl(Cpu* cpu);
+
+// --------------------------------------------------------------------
+
+// Calls native function by index from cpu host call table, see host_calls.h
+void hcl(Cpu* cpu);
+
 #endif
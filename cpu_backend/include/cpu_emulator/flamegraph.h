@@ -0,0 +1,62 @@
+#include <stdint.h>
+
+#include "./cpu.h"
+#include "symbols/symbols.h"
+
+#ifndef FLAMEGRAPH_H
+#define FLAMEGRAPH_H
+
+#define FLAME_DEFAULT_SAMPLE_PERIOD 1000
+#define FLAME_TABLE_INIT_SIZE 1024
+#define FLAME_FRAMES_INIT_SIZE 4096
+
+// Unique guest call chain and number of samples, that hit it
+typedef struct FlameStack{
+    uint64_t hash;
+    uint64_t samples;
+    uint32_t frames_offset;
+    uint32_t depth;
+}FlameStack;
+
+typedef struct FlameSampler{
+    uint64_t sample_period;
+    uint64_t countdown;
+
+    // Open addressing table of unique stacks, indexes in stack_list (0 - empty slot)
+    uint32_t* table;
+    uint32_t table_capacity;
+
+    FlameStack* stack_list;
+    uint32_t stacks_count;
+    uint32_t stacks_capacity;
+
+    // Frames of all stacks, each frame is address of label, which contains call site
+    uint32_t* frames;
+    uint32_t frames_count;
+    uint32_t frames_capacity;
+
+    // Scratch buffer for current chain
+    uint32_t* chain;
+    uint32_t chain_capacity;
+
+    SymbolMap symbol_map;
+}FlameSampler;
+
+void flame_sampler_init(FlameSampler* sampler, uint64_t sample_period, const char* symbol_file_name);
+
+// Captures current guest call chain: call sites from call stack and current pc
+void flame_sampler_sample(FlameSampler* sampler, Cpu* cpu);
+
+static inline void flame_sampler_tick(FlameSampler* sampler, Cpu* cpu){
+    if(-- sampler->countdown == 0){
+        flame_sampler_sample(sampler, cpu);
+        sampler->countdown = sampler->sample_period;
+    }
+}
+
+// Writes folded stacks ("frame;frame;frame samples"), accepted by flamegraph.pl and similar tools
+void flame_sampler_write(FlameSampler* sampler, const char* folded_file_name);
+
+void flame_sampler_free(FlameSampler* sampler);
+
+#endif // FLAMEGRAPH_H
@@ -0,0 +1,48 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "./cpu.h"
+
+#ifndef HOST_CALLS_H
+#define HOST_CALLS_H
+
+// hcl index calls native function number index from table, which is set in Cpu before execution.
+// Functions read arguments from x1, x2, ... and write results to x0, x1, ..., any of x0-xf may be changed.
+// Memory arguments are addresses in data stack, functions access them only through host_memory_read
+// and host_memory_write, which check that range is inside stack.
+
+// Returns NULL on success or error message, which stops execution
+typedef const char* (*HostFunction)(Cpu* cpu);
+
+typedef struct HostCall{
+    const char* name;
+    HostFunction function;
+}HostCall;
+
+typedef struct HostCallTable{
+    const HostCall* call_list;
+    uint32_t count;
+}HostCallTable;
+
+// Indexes of routines in standard_host_calls
+enum StandardHostCall{
+    // x0 = 32 bit FNV-1a hash of x2 bytes at *x1
+    HOST_CALL_FNV1A,
+    // SHA-256 digest of x2 bytes at *x1 is written into 32 bytes at *x3
+    HOST_CALL_SHA256,
+    // x2 words at *x1 are sorted in ascending unsigned order
+    HOST_CALL_SORT,
+    // x0 = hex number from start of x2 bytes of text at *x1, x1 = number of its digits
+    HOST_CALL_PARSE_HEX,
+    STANDARD_HOST_CALLS_NUMBER
+};
+
+extern const HostCallTable standard_host_calls;
+
+// Range of size bytes at address, NULL if it isn't inside data stack
+const uint8_t* host_memory_read(Cpu* cpu, uint32_t address, uint32_t size);
+
+// Range is written with one stack update, returns false if it isn't inside data stack
+bool host_memory_write(Cpu* cpu, uint32_t address, const void* data, uint32_t size);
+
+#endif // HOST_CALLS_H
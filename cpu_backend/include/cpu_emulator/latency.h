@@ -0,0 +1,89 @@
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+// Histograms are log-scale: every power of two is split into LATENCY_SUB_BUCKETS buckets
+#define LATENCY_SUB_BUCKETS_BITS 2
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BUCKETS_BITS)
+#define LATENCY_BUCKETS (64 * LATENCY_SUB_BUCKETS)
+
+#define LATENCY_OP_SLOTS 256
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LATENCY_UNIT "tsc ticks"
+#else
+#define LATENCY_UNIT "ns"
+#endif
+
+enum LatencyMemoryOp{
+    LATENCY_GET_UINT,
+    LATENCY_WRITE_UINT,
+    LATENCY_STACK_PUSH,
+    LATENCY_STACK_POP,
+    LATENCY_GET_RANGE,
+    LATENCY_WRITE_RANGE,
+    LATENCY_MEMORY_OPS
+};
+
+typedef struct LatencyHistogram{
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+    uint64_t buckets[LATENCY_BUCKETS];
+}LatencyHistogram;
+
+typedef struct LatencyRecorder{
+    LatencyHistogram op_histograms[LATENCY_OP_SLOTS];
+    LatencyHistogram memory_histograms[LATENCY_MEMORY_OPS];
+}LatencyRecorder;
+
+static inline uint64_t latency_clock(){
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec time_spec;
+    clock_gettime(CLOCK_MONOTONIC, &time_spec);
+    return (uint64_t)time_spec.tv_sec * 1000000000ull + (uint64_t)time_spec.tv_nsec;
+#endif
+}
+
+static inline uint32_t latency_bucket(uint64_t value){
+    if(value < LATENCY_SUB_BUCKETS)
+        return (uint32_t)value;
+
+    uint32_t msb = 63 - __builtin_clzll(value);
+    uint32_t sub_bucket = (uint32_t)(value >> (msb - LATENCY_SUB_BUCKETS_BITS)) & (LATENCY_SUB_BUCKETS - 1);
+    return msb * LATENCY_SUB_BUCKETS + sub_bucket;
+}
+
+static inline void latency_histogram_add(LatencyHistogram* histogram, uint64_t value){
+    histogram->count ++;
+    histogram->sum += value;
+    if(value > histogram->max)
+        histogram->max = value;
+    histogram->buckets[latency_bucket(value)] ++;
+}
+
+// Helpers for optional recorder: do nothing if recorder is NULL
+static inline uint64_t latency_start(LatencyRecorder* recorder){
+    return recorder ? latency_clock() : 0;
+}
+
+static inline void latency_finish_memory_op(LatencyRecorder* recorder, uint32_t memory_op, uint64_t start_time){
+    if(recorder)
+        latency_histogram_add(&recorder->memory_histograms[memory_op], latency_clock() - start_time);
+}
+
+LatencyRecorder* latency_recorder_create();
+
+void latency_recorder_write_report(LatencyRecorder* recorder, const char* report_file_name);
+
+void latency_recorder_free(LatencyRecorder* recorder);
+
+#endif // LATENCY_H
@@ -0,0 +1,79 @@
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "./cpu.h"
+
+#ifndef METRICS_H
+#define METRICS_H
+
+// Metrics are updated every METRICS_UPDATE_PERIOD retired instructions, must be power of two
+#define METRICS_UPDATE_PERIOD (1 << 16)
+#define METRICS_UPDATE_MASK (METRICS_UPDATE_PERIOD - 1)
+
+// Shared memory segment name is METRICS_SHM_PREFIX<pid>
+#define METRICS_SHM_PREFIX "/cpu_emulator."
+#define METRICS_SHM_NAME_SIZE 64
+#define METRICS_MAGIC 0x4d455452u
+#define METRICS_VERSION 1
+
+typedef struct StackMetrics{
+    uint64_t high_water;
+    uint64_t capacity_bytes;
+    uint64_t reallocs;
+    uint64_t hash_count;
+    uint64_t hash_ns;
+}StackMetrics;
+
+// Layout of shared memory segment, read by cpu_top
+typedef struct MetricsSnapshot{
+    uint32_t magic;
+    uint32_t version;
+
+    // Seqlock: odd while snapshot is being updated
+    uint64_t sequence;
+
+    int64_t pid;
+    uint32_t running;
+    uint32_t reserved;
+
+    uint64_t instructions_retired;
+    uint64_t elapsed_ns;
+    double instructions_per_second;
+
+    // Data stack high water is in bytes, call stack one is in return addresses
+    StackMetrics data_stack;
+    StackMetrics call_stack;
+
+    uint64_t input_values;
+    uint64_t output_values;
+    uint64_t output_bytes;
+}MetricsSnapshot;
+
+typedef struct Metrics{
+    uint64_t start_ns;
+
+    // RCC is 32 bit, so retired instructions are accumulated here
+    uint64_t instructions_retired;
+    uint32_t last_rcc;
+
+    // Shared memory segment, NULL if publishing disabled
+    MetricsSnapshot* shared;
+    char shm_name[METRICS_SHM_NAME_SIZE];
+}Metrics;
+
+void metrics_init(Metrics* metrics, bool publish);
+
+// Called at least once per METRICS_UPDATE_PERIOD instructions
+void metrics_update(Metrics* metrics, Cpu* cpu);
+
+void metrics_snapshot(Metrics* metrics, Cpu* cpu, MetricsSnapshot* snapshot);
+
+void metrics_write_json(Metrics* metrics, Cpu* cpu, const char* json_file_name);
+
+// Marks shared segment as finished and removes it
+void metrics_finish(Metrics* metrics, Cpu* cpu);
+
+// Used by cpu_top: copies consistent snapshot from shared segment
+bool metrics_read_shared(const MetricsSnapshot* shared, MetricsSnapshot* snapshot);
+
+#endif // METRICS_H
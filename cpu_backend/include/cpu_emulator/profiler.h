@@ -0,0 +1,50 @@
+#include <stdint.h>
+#include <time.h>
+
+#include "./cpu.h"
+#include "symbols/symbols.h"
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#define PROFILER_OP_SLOTS 256
+#define PROFILER_PC_SLOTS MAX_INSTRUCTIONS
+
+typedef struct ProfilerCounter{
+    uint64_t executions;
+    uint64_t host_ns;
+}ProfilerCounter;
+
+typedef struct Profiler{
+    // Counters indexed by instruction address / BIN_INSTRUCTION_SIZE
+    ProfilerCounter* pc_counters;
+    ProfilerCounter op_counters[PROFILER_OP_SLOTS];
+
+    SymbolMap symbol_map;
+}Profiler;
+
+static inline uint64_t profiler_clock(){
+    struct timespec time_spec;
+    clock_gettime(CLOCK_MONOTONIC, &time_spec);
+    return (uint64_t)time_spec.tv_sec * 1000000000ull + (uint64_t)time_spec.tv_nsec;
+}
+
+static inline void profiler_record(Profiler* profiler, uint32_t pc, uint32_t op_code, uint64_t host_ns){
+    uint32_t pc_index = pc / BIN_INSTRUCTION_SIZE;
+    if(pc_index < PROFILER_PC_SLOTS){
+        profiler->pc_counters[pc_index].executions ++;
+        profiler->pc_counters[pc_index].host_ns += host_ns;
+    }
+
+    profiler->op_counters[op_code & 0xFF].executions ++;
+    profiler->op_counters[op_code & 0xFF].host_ns += host_ns;
+}
+
+// Symbol file is optional, without it report contains only addresses
+void profiler_init(Profiler* profiler, const char* symbol_file_name);
+
+void profiler_write_report(Profiler* profiler, const char* report_file_name, const uint8_t* program_buffer);
+
+void profiler_free(Profiler* profiler);
+
+#endif // PROFILER_H
@@ -0,0 +1,48 @@
+#include <stdio.h>
+#include <stdint.h>
+
+#include "stack/stack.h"
+#include "./cpu.h"
+
+#ifndef SPMD_H
+#define SPMD_H
+
+// Number of program instances executed in lockstep.
+// One AVX-512 vector, two AVX2 vectors or 16 iterations of scalar fallback.
+#define SPMD_LANES 16
+#define SPMD_ALL_LANES 0xFFFFu
+
+#define SPMD_LANE_IO_INIT_SIZE 16
+
+typedef struct SpmdLaneIo{
+    uint32_t* values;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t cursor;
+} SpmdLaneIo;
+
+typedef struct SpmdCpu{
+    // Lanes which are not halted yet
+    uint32_t running_mask;
+
+    // Every register is a vector of lanes: regs[reg_num][lane]
+    alignas(64) uint32_t regs[NUM_OF_REGISTERS][SPMD_LANES];
+
+    // Program buffer shared by all lanes
+    uint8_t* program_buffer;
+
+    // Scalar view of each lane, used for instructions without vector kernel
+    Cpu lanes[SPMD_LANES];
+    Stack data_stacks[SPMD_LANES];
+    Stack call_stacks[SPMD_LANES];
+
+    // Values consumed by inp and produced by out, per lane
+    SpmdLaneIo input[SPMD_LANES];
+    SpmdLaneIo output[SPMD_LANES];
+} SpmdCpu;
+
+// Runs one program instance per input line in batches of SPMD_LANES.
+// Each line holds hex values consumed by inp, each output line holds values printed by out.
+void spmd_execute_file(const char* bin_file_name, FILE* input_file, FILE* output_file);
+
+#endif // SPMD_H
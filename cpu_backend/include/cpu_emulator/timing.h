@@ -0,0 +1,68 @@
+#include <stdint.h>
+
+#include "./cpu.h"
+
+#ifndef TIMING_H
+#define TIMING_H
+
+#define TIMING_OP_SLOTS 256
+
+#define TIMING_DEFAULT_MISPREDICT_PENALTY 12
+#define TIMING_DEFAULT_TABLE_BITS 12
+#define TIMING_MAX_TABLE_BITS 24
+#define TIMING_DEFAULT_RAS_DEPTH 16
+#define TIMING_MAX_RAS_DEPTH 256
+
+enum PredictorKind{
+    // Backward branches taken, forward not taken
+    PREDICTOR_STATIC,
+    // Table of 2-bit counters indexed by branch address
+    PREDICTOR_BIMODAL,
+    // Table of 2-bit counters indexed by branch address xor global history
+    PREDICTOR_GSHARE
+};
+
+typedef struct TimingOpCounter{
+    uint64_t executions;
+    uint64_t cycles;
+}TimingOpCounter;
+
+typedef struct TimingModel{
+    // Configuration
+    uint32_t op_latency[TIMING_OP_SLOTS];
+    uint32_t mispredict_penalty;
+    PredictorKind predictor;
+    uint32_t table_bits;
+    uint32_t ras_depth;
+
+    // Predictor state
+    uint8_t* counters;
+    uint32_t history;
+    uint32_t return_stack[TIMING_MAX_RAS_DEPTH];
+    uint32_t return_stack_top;
+    uint32_t return_stack_count;
+
+    // Results
+    uint64_t cycles;
+    uint64_t instructions;
+    uint64_t branches;
+    uint64_t branches_taken;
+    uint64_t branch_mispredicts;
+    uint64_t returns;
+    uint64_t return_mispredicts;
+    TimingOpCounter op_counters[TIMING_OP_SLOTS];
+}TimingModel;
+
+// Config file is optional, it contains lines "<op name> <cycles>", "predictor static|bimodal|gshare",
+// "mispredict_penalty <cycles>", "table_bits <n>" and "ras_depth <n>"; '#' starts comment.
+// Predictor given in command line overrides config file one, NULL keeps it.
+void timing_model_init(TimingModel* timing, const char* config_file_name, const char* predictor_name);
+
+// Called after instruction at pc was executed, cpu->regs[RPC] is already next pc
+void timing_model_record(TimingModel* timing, Cpu* cpu, uint32_t pc, uint32_t op_code);
+
+void timing_model_write_report(TimingModel* timing, const char* report_file_name);
+
+void timing_model_free(TimingModel* timing);
+
+#endif // TIMING_H
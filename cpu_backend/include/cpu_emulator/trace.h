@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "./cpu.h"
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#define TRACE_MAGIC "MYTR"
+#define TRACE_VERSION 1
+
+// Ring buffer size in records, must be power of two
+#define TRACE_RING_RECORDS (1 << 16)
+
+// Writer thread sleeps this long, when there is nothing to write
+#define TRACE_WRITER_IDLE_NS 100000
+
+// TraceRecord flags
+#define TRACE_HAS_OPERANDS 1
+#define TRACE_HAS_MEMORY   2
+
+#define TRACE_NO_MEMORY_ADDRESS UINT32_MAX
+
+// Short records contain only pc and op code (TRACE_SHORT_RECORD_SIZE bytes),
+// full records also contain operands values before execution and memory address.
+typedef struct TraceRecord{
+    uint32_t pc;
+    uint8_t op_code;
+    uint8_t flags;
+    uint16_t reserved;
+
+    uint32_t operand_values[3];
+    uint32_t memory_address;
+}TraceRecord;
+
+#define TRACE_SHORT_RECORD_SIZE 8
+#define TRACE_FULL_RECORD_SIZE sizeof(TraceRecord)
+
+// Trace file: header followed by records_count records of record_size bytes
+typedef struct TraceFileHeader{
+    char magic[4];
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t reserved;
+    // Index of first record in file, not zero if ring buffer dropped oldest records
+    uint64_t first_record;
+}TraceFileHeader;
+
+typedef struct Tracer{
+    uint8_t* buffer;
+    uint32_t record_size;
+    uint64_t capacity;
+
+    // Records written by cpu and records flushed by writer thread
+    uint64_t head;
+    uint64_t tail;
+
+    // In streaming mode every record is written to file by writer thread,
+    // otherwise only last TRACE_RING_RECORDS records are written at exit
+    bool streaming;
+    bool operands;
+    bool finished;
+
+    FILE* trace_file;
+    pthread_t writer_thread;
+}Tracer;
+
+void tracer_init(Tracer* tracer, const char* trace_file_name, bool streaming, bool operands);
+
+// Waits until writer thread frees space in ring buffer
+void tracer_wait_space(Tracer* tracer);
+
+void tracer_capture_operands(Tracer* tracer, Cpu* cpu, TraceRecord* record);
+
+// Appends record about instruction, which is going to be executed
+static inline void tracer_record(Tracer* tracer, Cpu* cpu, uint32_t pc, uint32_t op_code){
+    if(tracer->streaming && tracer->head - __atomic_load_n(&tracer->tail, __ATOMIC_ACQUIRE) == tracer->capacity)
+        tracer_wait_space(tracer);
+
+    TraceRecord* record = (TraceRecord*)(tracer->buffer + (tracer->head & (tracer->capacity - 1)) * tracer->record_size);
+    record->pc = pc;
+    record->op_code = (uint8_t)op_code;
+    record->flags = 0;
+    record->reserved = 0;
+
+    if(tracer->operands)
+        tracer_capture_operands(tracer, cpu, record);
+
+    __atomic_store_n(&tracer->head, tracer->head + 1, __ATOMIC_RELEASE);
+}
+
+// Flushes rest of records, stops writer thread and closes trace file
+void tracer_finish(Tracer* tracer);
+
+#endif // TRACE_H
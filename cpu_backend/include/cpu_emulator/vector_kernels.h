@@ -0,0 +1,20 @@
+#include <stdint.h>
+
+#ifndef VECTOR_KERNELS_H
+#define VECTOR_KERNELS_H
+
+// Kernels of vector instructions over words of data stack.
+// AVX2 handles 8 words per step, SSE2 4 words, tail and builds without them use scalar loop.
+// Pointers may be unaligned, result may be the same buffer as one of sources.
+
+void vector_add(uint32_t* result, const uint32_t* src1, const uint32_t* src2, uint32_t count);
+
+void vector_mul(uint32_t* result, const uint32_t* src1, const uint32_t* src2, uint32_t count);
+
+// Word of result is 1 if words of sources are equal, 0 otherwise
+void vector_compare(uint32_t* result, const uint32_t* src1, const uint32_t* src2, uint32_t count);
+
+// Sum modulo 2^32
+uint32_t vector_sum(const uint32_t* src, uint32_t count);
+
+#endif // VECTOR_KERNELS_H
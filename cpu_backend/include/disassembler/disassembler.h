@@ -0,0 +1,12 @@
+#ifndef DISASSEMBLER_H
+#define DISASSEMBLER_H
+
+#include <stdint.h>
+#include "instructions/instructions.h"
+
+void instruction_disassemble(BinInstruction* bin_instruction, TextInstruction* text_instruction);
+
+// Prints address, operation name and args with fixed widths, without new line
+void print_text_instruction(TextInstruction* text_instruction, uint32_t address);
+
+#endif // DISASSEMBLER_H
@@ -32,6 +32,9 @@ enum error{
     WRONG_ARG_NUM,
     UNKNOWN_TOKEN,
     NULL_PTR_TEXT_INSTRUCTION_ARRAY,
+    TEXT_INSTRUCTION_ARRAY_REALLOC_FAILURE,
+    BIN_INSTRUCTION_ARRAY_REALLOC_FAILURE,
+    FIXUP_LIST_REALLOC_FAILURE,
 
     FILE_OPENING_FAILURE
 };
@@ -3,7 +3,7 @@
 
 #define INSTRUCTION_SIZE 3
 #define ARG_SIZE 2
-#define INSTRUCTIONS_SET_NUMBER 20
+#define INSTRUCTIONS_SET_NUMBER 27
 #define MAX_INSTRUCTIONS_NUMBER 256
 #define INSTRUCTIONS_FLAGS_NUMBER 2
 #define MAX_FLAG_NUMBER 8
@@ -22,6 +22,13 @@ typedef struct BinInstruction{
     uint32_t arg_list[3];
 } BinInstruction;
 
+// Operation is op code in top byte and flags of arg in byte at ARG_FLAGS_SHIFT(arg),
+// bit i of them is set for instruction_flag[i]
+#define ARG_FLAGS_SHIFT(arg) (16 - (arg) * 8)
+#define ARG_FLAGS_MASK ((1u << INSTRUCTIONS_FLAGS_NUMBER) - 1)
+#define ARG_FLAG_MEMORY(arg) (1u << (ARG_FLAGS_SHIFT(arg) + 0))
+#define ARG_FLAG_REGISTER(arg) (1u << (ARG_FLAGS_SHIFT(arg) + 1))
+
 typedef struct BinInstructionArray{
     BinInstruction* bin_instruction_list;
     uint32_t count;
@@ -33,6 +40,8 @@ typedef struct BinInstructionArray{
 typedef struct TextInstructionArg{
     char imm_flag [3];
     int32_t imm;
+    // Index + 1 of referenced label in label table, 0 if arg isn't label
+    uint32_t label;
 }TextInstructionArg;
 
 typedef struct TextInstructionOp{
@@ -44,6 +53,7 @@ typedef struct TextInstructionOp{
 typedef struct TextInstruction{
     TextInstructionOp operation;
     TextInstructionArg imm [3];
+    uint32_t line;
 }TextInstruction;
 
 typedef struct TextInstructionArray{
@@ -54,10 +64,74 @@ typedef struct TextInstructionArray{
 
 //-------------------------------------------------------
 
+// Op codes, indexes in instruction_set
+enum OpCode{
+    OP_INP,
+    OP_OUT,
+    OP_MOV,
+    OP_ADD,
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_SQR,
+    OP_BNE,
+    OP_BEQ,
+    OP_BGT,
+    OP_BLT,
+    OP_BGE,
+    OP_BLE,
+    OP_BAW,
+    OP_STR,
+    OP_LDR,
+    OP_CFN,
+    OP_RET,
+    OP_HLT,
+    OP_VAD,
+    OP_VML,
+    OP_VCM,
+    OP_VSM,
+    OP_BMV,
+    OP_BFL,
+    OP_HCL
+};
+
+// How instruction uses its arg, programs are checked against it once at load
+typedef enum ArgRole{
+    ARG_NONE,
+    // Read value: immediate, register, memory or memory addressed by register
+    ARG_SOURCE,
+    // Written value: register except rpc, memory or memory addressed by register
+    ARG_DESTINATION,
+    // Number of register, which is read
+    ARG_SOURCE_REGISTER,
+    // Number of register except rpc, which is written
+    ARG_DESTINATION_REGISTER,
+    // Immediate address of instruction
+    ARG_TARGET,
+    // Address of memory range, which is read: memory or memory addressed by register
+    ARG_SOURCE_ADDRESS,
+    // Address of memory range, which is written
+    ARG_DESTINATION_ADDRESS
+}ArgRole;
+
+// Where execution goes after instruction
+typedef enum InstructionFlow{
+    FLOW_NEXT,
+    // Conditional branch to target or next instruction
+    FLOW_BRANCH,
+    FLOW_JUMP,
+    // Target, then next instruction on return
+    FLOW_CALL,
+    FLOW_RETURN,
+    FLOW_HALT
+}InstructionFlow;
+
 typedef struct InstructionSet {
     const char* op_name;  
     const int8_t num_of_args;
     void (*cpu_instruction_pointer)(Cpu* cpu);
+    const ArgRole arg_roles[3];
+    const InstructionFlow flow;
 } InstructionSet; 
 
 extern const char parse_stoping_symbols[PARSE_STOPING_SYMB_NUMBER];
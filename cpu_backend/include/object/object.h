@@ -0,0 +1,71 @@
+#ifndef OBJECT_H
+#define OBJECT_H
+
+#include <stdint.h>
+
+#include "instructions/instructions.h"
+#include "symbols/symbols.h"
+
+#define OBJECT_FILE_MAGIC "MYOB"
+#define OBJECT_FILE_VERSION 1
+#define OBJECT_FILE_SUFFIX ".myo"
+
+// Relocatable object file is written by assembler -c and combined into bin by linker.
+// Layout: ObjectFileHeader, then sections in order of header counters:
+//   BinInstruction   code, label args hold module relative addresses
+//   ObjectSymbol     labels of module in order of first appearance
+//   ObjectRelocation label args, which linker patches
+//   SourceLine       module relative addresses of source lines
+//   char             null terminated symbol names
+
+// Symbol is defined in module and exported, otherwise it is imported
+#define OBJECT_SYMBOL_DEFINED (1 << 0)
+
+typedef struct ObjectFileHeader{
+    char magic[4];
+    uint32_t version;
+    uint32_t instructions_count;
+    uint32_t symbols_count;
+    uint32_t relocations_count;
+    uint32_t lines_count;
+    uint32_t names_size;
+}ObjectFileHeader;
+
+typedef struct ObjectSymbol{
+    uint32_t name_offset;
+    uint32_t name_size;
+    uint32_t address;
+    uint32_t flags;
+}ObjectSymbol;
+
+// Field arg_list[arg] of instruction is replaced by final address of symbol
+typedef struct ObjectRelocation{
+    uint32_t instruction;
+    uint32_t arg;
+    uint32_t symbol;
+}ObjectRelocation;
+
+typedef struct ObjectFile{
+    ObjectFileHeader header;
+    BinInstruction* instruction_list;
+    ObjectSymbol* symbol_list;
+    ObjectRelocation* relocation_list;
+    SourceLine* line_list;
+    char* names;
+}ObjectFile;
+
+// Allocates sections for counters set in object_file->header
+void object_file_alloc(ObjectFile* object_file);
+
+void object_file_free(ObjectFile* object_file);
+
+void object_file_write(ObjectFile* object_file, const char* file_name);
+
+// Validates layout and indexes of object file, aborts on malformed file
+void object_file_read(ObjectFile* object_file, const char* file_name);
+
+static inline const char* object_symbol_name(const ObjectFile* object_file, const ObjectSymbol* symbol){
+    return object_file->names + symbol->name_offset;
+}
+
+#endif // OBJECT_H
@@ -0,0 +1,31 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <stdint.h>
+
+#include "instructions/instructions.h"
+#include "text_asm_parser/label_table.h"
+
+// Optimizer rewrites parsed program before assembling, output retires fewer instructions with the same
+// inputs, outputs and memory. Rounds are repeated while they change program:
+//   calls of short leaf functions are inlined, tail calls become jumps;
+//   constant propagation over CFG, folding and resolving of branches on constants, unreachable code removal,
+//   str/ldr pairs inside block become mov;
+//   branch threading, merging of compare pairs on the same operands and of branches over jump,
+//   jumps to loop condition are replaced by condition itself;
+//   removal of dead register writes by liveness.
+// Label addresses in label_table and source lines of instructions follow optimized code.
+// Programs, which read rpc or rcc or are rejected by verifier, are left as is.
+
+#define OPTIMIZER_MAX_ROUNDS 8
+
+// Longest function body, which is inlined, ret isn't counted
+#define OPTIMIZER_INLINE_MAX_SIZE 8
+// Inlining stops, when program becomes this many times longer than source
+#define OPTIMIZER_INLINE_MAX_GROWTH 2
+
+// entry_label is additional root of CFG, NULL if program starts from first instruction only
+void optimize_text_instructions(TextInstructionArray* text_instructions_array, LabelTable* label_table,
+                                const char* entry_label);
+
+#endif // OPTIMIZER_H
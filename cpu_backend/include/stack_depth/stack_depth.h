@@ -0,0 +1,43 @@
+#ifndef STACK_DEPTH_H
+#define STACK_DEPTH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "instructions/instructions.h"
+
+// Static upper bounds of data stack size and call depth over CFG of bin program.
+// Every function (cfn target and program entries) gets summary: peak and range of data stack size change
+// by str, ldr and its calls relative to its start, and change at ret. Summaries are built callees first,
+// so recursion, which makes call depth unbounded, is found as cycle of calls. Loops, which change data
+// stack size on every iteration, make data stack unbounded. Writes into memory by address extend data
+// stack up to address, writes by address in register make its size unknown.
+
+// Updates of one instruction, after which its data stack range is considered growing without bound
+#define STACK_DEPTH_MAX_UPDATES 64
+// Analysis visits at most this many instructions per program instruction, then gives up: bodies of functions,
+// which aren't separated by ret, are walked once per function
+#define STACK_DEPTH_MAX_STEPS 32
+
+typedef struct StackDepth{
+    bool data_bounded;
+    // Bytes, including initial data
+    uint32_t data_stack_size;
+    // Why data stack isn't bounded, NULL if it is
+    const char* data_reason;
+
+    bool calls_bounded;
+    // Return addresses
+    uint32_t call_stack_size;
+    // Why calls aren't bounded, NULL if they are
+    const char* calls_reason;
+    // Address of function, which calls itself, if calls are unbounded by recursion
+    bool recursion;
+    uint32_t recursion_address;
+}StackDepth;
+
+// Program must pass verifier, otherwise nothing is bounded
+void stack_depth_analyze(const BinInstruction* instruction_list, uint32_t count, uint32_t entry_point,
+                         uint32_t data_size, StackDepth* depth);
+
+#endif // STACK_DEPTH_H
@@ -0,0 +1,62 @@
+#ifndef SYMBOLS_H
+#define SYMBOLS_H
+
+#include <stdint.h>
+
+#define SYMBOL_MAP_INIT_SIZE 64
+#define SYMBOL_FILE_SUFFIX ".sym"
+
+// Symbol map is written by assembler next to bin file (program.bin.sym) as text:
+//   label <hex address> <label name>
+//   line  <hex address> <source line number>
+
+typedef struct Symbol{
+    uint32_t address;
+    uint32_t name_size;
+    char* name;
+}Symbol;
+
+typedef struct SourceLine{
+    uint32_t address;
+    uint32_t line;
+}SourceLine;
+
+typedef struct SymbolMap{
+    uint32_t symbols_count;
+    uint32_t symbols_capacity;
+    Symbol* symbol_list;
+
+    uint32_t lines_count;
+    uint32_t lines_capacity;
+    SourceLine* line_list;
+}SymbolMap;
+
+void symbol_map_init(SymbolMap* symbol_map);
+
+void symbol_map_free(SymbolMap* symbol_map);
+
+void symbol_map_add_symbol(SymbolMap* symbol_map, const char* name, uint32_t name_size, uint32_t address);
+
+void symbol_map_add_line(SymbolMap* symbol_map, uint32_t address, uint32_t line);
+
+// Makes room for lines_count more lines, so line_list can be filled directly
+void symbol_map_reserve_lines(SymbolMap* symbol_map, uint32_t lines_count);
+
+// Sorts symbols and lines by address, must be called before lookups
+void symbol_map_sort(SymbolMap* symbol_map);
+
+void symbol_map_write(SymbolMap* symbol_map, const char* file_name);
+
+// Returns false if file doesn't exist
+bool symbol_map_read(SymbolMap* symbol_map, const char* file_name);
+
+// Symbol with given null terminated name, NULL if there no such symbol
+const Symbol* symbol_map_find_name(const SymbolMap* symbol_map, const char* name);
+
+// Nearest symbol with address less or equal to given one, NULL if there no such symbol
+const Symbol* symbol_map_find(const SymbolMap* symbol_map, uint32_t address);
+
+// Source line of instruction, 0 if unknown
+uint32_t symbol_map_find_line(const SymbolMap* symbol_map, uint32_t address);
+
+#endif // SYMBOLS_H
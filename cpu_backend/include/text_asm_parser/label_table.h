@@ -0,0 +1,54 @@
+#ifndef LABEL_TABLE_H
+#define LABEL_TABLE_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#define LABEL_TABLE_INIT_SIZE 1024
+#define LABEL_ARENA_BLOCK_SIZE (64 * 1024)
+
+// Address of label, which is referenced, but not defined yet
+#define LABEL_UNDEFINED UINT32_MAX
+
+typedef struct Label{
+    // Name lives in label table arena, it is null terminated
+    const char* name;
+    uint32_t label_size;
+    uint32_t hash;
+    uint32_t address;
+
+    // Head of list of unresolved uses (fixup index + 1), used by single pass assembler
+    uint32_t fixups;
+}Label;
+
+typedef struct LabelArenaBlock{
+    struct LabelArenaBlock* next;
+    size_t used;
+    size_t capacity;
+    char data[];
+}LabelArenaBlock;
+
+typedef struct LabelTable{
+    // Labels in order of first appearance
+    uint32_t count;
+    uint32_t capacity;
+    Label* label_list;
+
+    // Open addressing hash table, slot holds label index + 1, 0 is empty slot
+    uint32_t* slots;
+    uint32_t slots_capacity;
+
+    // All label names are freed at once with table
+    LabelArenaBlock* arena;
+}LabelTable;
+
+void label_table_init(LabelTable* label_table);
+
+void free_label_table(LabelTable* label_table);
+
+Label* label_table_find(LabelTable* label_table, const char* name, uint32_t name_size);
+
+// Returns existing label or adds new one with LABEL_UNDEFINED address
+Label* label_table_insert(LabelTable* label_table, const char* name, uint32_t name_size);
+
+#endif // LABEL_TABLE_H
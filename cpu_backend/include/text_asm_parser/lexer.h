@@ -0,0 +1,83 @@
+#ifndef LEXER_H
+#define LEXER_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+//----------------------------CHARACTER_CLASSES-----------------------------
+
+// Bits of char_classes table entries
+#define CHAR_IGNORABLE (1 << 0)
+#define CHAR_STOPING   (1 << 1)
+#define CHAR_FLAG      (1 << 2)
+#define CHAR_HEX_DIGIT (1 << 3)
+#define CHAR_LETTER    (1 << 4)
+#define CHAR_LABEL     (1 << 5)
+
+#define HEX_DIGIT_INVALID 0xff
+
+// Built from ignorable_symbols, parse_stoping_symbols and instruction_flag once at program start
+extern uint8_t char_classes[256];
+extern uint8_t hex_digit_values[256];
+
+static inline bool char_is(char symbol, uint8_t char_class){
+    return char_classes[(uint8_t)symbol] & char_class;
+}
+
+//----------------------------SOURCE-----------------------------
+
+// Whole source file mapped into memory, tokens point into mapping
+typedef struct SourceFile{
+    const char* data;
+    size_t size;
+}SourceFile;
+
+typedef struct StringView{
+    const char* data;
+    uint32_t size;
+}StringView;
+
+void source_file_open(SourceFile* source_file, const char* file_name);
+
+void source_file_close(SourceFile* source_file);
+
+//----------------------------LINES-----------------------------
+
+typedef struct Lexer{
+    const char* position;
+    const char* end;
+    uint32_t line_number;
+}Lexer;
+
+void lexer_init(Lexer* lexer, SourceFile* source_file);
+
+// Lexer over part of source, begin must be start of line
+void lexer_init_range(Lexer* lexer, const char* begin, const char* end);
+
+// Next source line without line feed and comment, false at end of file
+bool lexer_next_line(Lexer* lexer, StringView* line);
+
+//----------------------------TOKENS-----------------------------
+
+// Position inside of line, end of line reads as '\0'
+typedef struct LineCursor{
+    const char* position;
+    const char* end;
+}LineCursor;
+
+static inline char line_cursor_peek(const LineCursor* cursor){
+    return cursor->position < cursor->end ? *cursor->position : '\0';
+}
+
+// Skips symbols of char_class, returns token, which was skipped
+static inline StringView line_cursor_span(LineCursor* cursor, uint8_t char_class){
+    StringView token = {cursor->position, 0};
+    while(cursor->position < cursor->end && char_is(*cursor->position, char_class)){
+        cursor->position ++;
+    }
+    token.size = (uint32_t)(cursor->position - token.data);
+    return token;
+}
+
+#endif // LEXER_H
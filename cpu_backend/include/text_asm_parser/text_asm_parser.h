@@ -4,29 +4,21 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include "instructions/instructions.h"
+#include "text_asm_parser/label_table.h"
+#include "symbols/symbols.h"
 
 #define LINE_SIZE 300
-#define LABEL_SIZE 100
-#define LABEL_TABLE_INIT_SIZE 1000
 
-typedef struct Label{
-    uint label_size;
-    char label[LABEL_SIZE];
-    uint32_t address;
-}Label;
-
-typedef struct LabelTable{
-    uint32_t count;
-    uint32_t capacity;
-    Label* label_list;
-}LabelTable;
+// Parallel assembler doesn't split sources into chunks smaller than this
+#define PARALLEL_CHUNK_MIN_SIZE (64 * 1024)
 
 typedef struct ParserState{
     bool flag_seted;
     bool  arg_seted;
 }ParserState;
 
-void free_label_table(LabelTable* label_table);
+// Label name is null terminated, its length is label_size
+const char* get_label_name(Label* label);
 
 void free_text_instruction_list(TextInstructionArray* text_instruction_array);
 
@@ -36,4 +28,21 @@ void parser_critical_error(TextInstructionArray* text_instruction_array,
 void parse_text_asm_file(const char* file_name,
                          TextInstructionArray* text_instruction_array,
                          LabelTable* label_table);
+
+// Single pass: instructions are assembled while reading source, uses of labels, which are not
+// defined yet, are kept in per-label fixup lists and patched on definition.
+// Source lines of instructions are added to symbol_map.
+void assemble_text_asm_file(const char* file_name,
+                            BinInstructionArray* bin_instructions_array,
+                            LabelTable* label_table,
+                            SymbolMap* symbol_map);
+
+// Source is cut into jobs_count chunks at line boundaries, which are parsed in parallel with local
+// label tables. Label addresses are merged by prefix sum over chunk instruction counts and label
+// uses are patched in parallel afterwards. Output is the same as of assemble_text_asm_file.
+void assemble_text_asm_file_parallel(const char* file_name,
+                                     BinInstructionArray* bin_instructions_array,
+                                     LabelTable* label_table,
+                                     SymbolMap* symbol_map,
+                                     uint32_t jobs_count);
 #endif // TEXT_ASM_PARSER_H
@@ -0,0 +1,23 @@
+#ifndef VERIFIER_H
+#define VERIFIER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "instructions/instructions.h"
+
+// Program is verified once at load, so interpreter doesn't check instructions on every step.
+// Verified program has only known op codes and flags of used args, registers in range, rpc written only by
+// control flow, immediate branch and call targets on instructions, and no way to run past its last instruction.
+// Memory addresses, stack depth and division by zero depend on data and are still checked at run time.
+
+typedef struct VerifierError{
+    // Address of first rejected instruction
+    uint32_t address;
+    const char* message;
+}VerifierError;
+
+// Returns false and fills error, if program can't be run without per step checks
+bool program_verify(const BinInstruction* instruction_list, uint32_t count, VerifierError* error);
+
+#endif // VERIFIER_H
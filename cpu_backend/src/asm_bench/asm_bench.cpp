@@ -0,0 +1,373 @@
+#include "instructions/instructions.h"
+#include "exceptions/exceptions.h"
+#include "text_asm_parser/text_asm_parser.h"
+#include "assembler/assembler.h"
+#include "asm_gen/asm_gen.h"
+#include "symbols/symbols.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#define BENCH_DEFAULT_REPS 3
+#define BENCH_MAX_REPS 100
+#define BENCH_JSON_VERSION 1
+
+enum AsmBenchStage{
+    STAGE_PARSE,
+    STAGE_ASSEMBLE,
+    STAGE_WRITE,
+    // Parsing and assembling by single pass assembler
+    STAGE_SINGLE_PASS,
+    // Single pass assembler split across options.jobs threads
+    STAGE_PARALLEL,
+    STAGES_NUMBER
+};
+
+static const char* const stage_names[STAGES_NUMBER] = {
+    "parse",
+    "assemble",
+    "write",
+    "single_pass",
+    "parallel"
+};
+
+typedef struct AsmBenchOptions{
+    uint32_t reps;
+    uint32_t jobs;
+    const char* input_file_name;
+    const char* output_file_name;
+    AsmGenConfig gen_config;
+}AsmBenchOptions;
+
+typedef struct StageResult{
+    uint64_t ns[BENCH_MAX_REPS];
+    // Heap bytes allocated by stage and still in use after it
+    int64_t heap_bytes;
+    long peak_rss_kb;
+}StageResult;
+
+//-------------------------MEASUREMENT-------------------------
+
+static uint64_t bench_clock_ns(){
+    struct timespec time_spec;
+    clock_gettime(CLOCK_MONOTONIC, &time_spec);
+    return (uint64_t)time_spec.tv_sec * 1000000000ull + (uint64_t)time_spec.tv_nsec;
+}
+
+static int64_t heap_in_use(){
+    // Large blocks are mmapped by malloc and accounted separately
+    struct mallinfo2 info = mallinfo2();
+    return (int64_t)(info.uordblks + info.hblkhd);
+}
+
+static long peak_rss_kb(){
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+typedef struct StageMeasurement{
+    uint64_t start_ns;
+    int64_t start_heap;
+}StageMeasurement;
+
+static void stage_start(StageMeasurement* measurement){
+    measurement->start_heap = heap_in_use();
+    measurement->start_ns = bench_clock_ns();
+}
+
+static void stage_finish(StageMeasurement* measurement, StageResult* result, uint32_t rep){
+    result->ns[rep] = bench_clock_ns() - measurement->start_ns;
+    result->heap_bytes = heap_in_use() - measurement->start_heap;
+    result->peak_rss_kb = peak_rss_kb();
+}
+
+//-------------------------STAGES-------------------------
+
+static uint64_t count_lines(const char* file_name){
+    FILE* file = fopen(file_name, "r");
+    if(!file){
+        fprintf(stderr, "Error opening %s!\n", file_name);
+        abort();
+    }
+
+    uint64_t lines = 0;
+    int symbol = 0;
+    while((symbol = fgetc(file)) != EOF){
+        if(symbol == '\n')
+            lines ++;
+    }
+
+    fclose(file);
+    return lines;
+}
+
+static void run_once(const char* source_file_name, const char* bin_file_name, StageResult* results, uint32_t rep,
+                     uint32_t jobs){
+    StageMeasurement measurement;
+
+    TextInstructionArray text_instructions_array;
+    LabelTable label_table;
+
+    stage_start(&measurement);
+    TRY{
+        parse_text_asm_file(source_file_name, &text_instructions_array, &label_table);
+    }
+    CATCH_ALL{
+        parser_critical_error(&text_instructions_array, &label_table);
+    }
+    END_TRY;
+    stage_finish(&measurement, &results[STAGE_PARSE], rep);
+
+    BinInstructionArray bin_instructions_array;
+
+    stage_start(&measurement);
+    bin_instructions_array.count = text_instructions_array.count;
+    bin_instructions_array.bin_instruction_list = (BinInstruction*)calloc(text_instructions_array.count,
+                                                                          sizeof(BinInstruction));
+    assemble_text_instructions_array(&bin_instructions_array, &text_instructions_array);
+    stage_finish(&measurement, &results[STAGE_ASSEMBLE], rep);
+
+    stage_start(&measurement);
+    write_bin_file(&bin_instructions_array, bin_file_name);
+    write_symbol_file(&label_table, &text_instructions_array, bin_file_name);
+    stage_finish(&measurement, &results[STAGE_WRITE], rep);
+
+    free(bin_instructions_array.bin_instruction_list);
+    free_text_instruction_list(&text_instructions_array);
+    free_label_table(&label_table);
+
+    SymbolMap symbol_map;
+    symbol_map_init(&symbol_map);
+
+    stage_start(&measurement);
+    TRY{
+        assemble_text_asm_file(source_file_name, &bin_instructions_array, &label_table, &symbol_map);
+    }
+    CATCH_ALL{
+        free(bin_instructions_array.bin_instruction_list);
+        parser_critical_error(NULL, &label_table);
+    }
+    END_TRY;
+    stage_finish(&measurement, &results[STAGE_SINGLE_PASS], rep);
+
+    symbol_map_free(&symbol_map);
+    free(bin_instructions_array.bin_instruction_list);
+    free_label_table(&label_table);
+
+    symbol_map_init(&symbol_map);
+
+    stage_start(&measurement);
+    TRY{
+        assemble_text_asm_file_parallel(source_file_name, &bin_instructions_array, &label_table, &symbol_map, jobs);
+    }
+    CATCH_ALL{
+        free(bin_instructions_array.bin_instruction_list);
+        parser_critical_error(NULL, &label_table);
+    }
+    END_TRY;
+    stage_finish(&measurement, &results[STAGE_PARALLEL], rep);
+
+    symbol_map_free(&symbol_map);
+    free(bin_instructions_array.bin_instruction_list);
+    free_label_table(&label_table);
+}
+
+//-------------------------REPORT-------------------------
+
+static int uint64_compare(const void* first, const void* second){
+    uint64_t value_1 = *(const uint64_t*)first;
+    uint64_t value_2 = *(const uint64_t*)second;
+    return value_1 < value_2 ? -1 : (value_1 > value_2 ? 1 : 0);
+}
+
+static double per_second(uint64_t count, uint64_t ns){
+    return ns ? (double)count * 1e9 / (double)ns : 0.0;
+}
+
+static void write_json(FILE* json_file, const char* source_file_name, uint64_t lines, AsmBenchOptions* options,
+                       StageResult* results){
+    for(uint32_t stage = 0; stage < STAGES_NUMBER; stage ++){
+        qsort(results[stage].ns, options->reps, sizeof(uint64_t), uint64_compare);
+    }
+
+    // Totals are parse to bin instructions, writing is the same for both assemblers
+    uint64_t two_pass_ns = results[STAGE_PARSE].ns[options->reps / 2] + results[STAGE_ASSEMBLE].ns[options->reps / 2];
+    uint64_t single_pass_ns = results[STAGE_SINGLE_PASS].ns[options->reps / 2];
+
+    fprintf(json_file,
+            "{\n"
+            "  \"version\": %d,\n"
+            "  \"source\": \"%s\",\n"
+            "  \"lines\": %lu,\n"
+            "  \"reps\": %u,\n"
+            "  \"jobs\": %u,\n"
+            "  \"two_pass_median_ns\": %lu,\n"
+            "  \"two_pass_lines_per_second\": %.1f,\n"
+            "  \"single_pass_median_ns\": %lu,\n"
+            "  \"single_pass_lines_per_second\": %.1f,\n"
+            "  \"stages\": [\n",
+            BENCH_JSON_VERSION, source_file_name, lines, options->reps, options->jobs, two_pass_ns, per_second(lines, two_pass_ns),
+            single_pass_ns, per_second(lines, single_pass_ns));
+
+    for(uint32_t stage = 0; stage < STAGES_NUMBER; stage ++){
+        StageResult* result = &results[stage];
+        uint64_t median_ns = result->ns[options->reps / 2];
+
+        fprintf(json_file,
+                "    {\n"
+                "      \"name\": \"%s\",\n"
+                "      \"min_ns\": %lu,\n"
+                "      \"median_ns\": %lu,\n"
+                "      \"lines_per_second\": %.1f,\n"
+                "      \"heap_bytes\": %ld,\n"
+                "      \"peak_rss_kb\": %ld\n"
+                "    }%s\n",
+                stage_names[stage], result->ns[0], median_ns, per_second(lines, median_ns),
+                result->heap_bytes, result->peak_rss_kb, stage + 1 == STAGES_NUMBER ? "" : ",");
+    }
+
+    fprintf(json_file, "  ]\n}\n");
+}
+
+//-------------------------OPTIONS-------------------------
+
+static void print_usage(){
+    fprintf(stderr, "Usage: asm_bench [options] [program.myasm]\n"
+                    "  Without program source is generated, see asm_gen for generator options\n"
+                    "  --reps <n>            Measured runs, 1..%d (default: %d)\n"
+                    "  --output <json>       Write results to file instead of stdout\n"
+                    "  --jobs <n>            Threads of parallel assembler (default: online cores)\n"
+                    "  --instructions <n>    Generated instructions (default: %d)\n"
+                    "  --label-density <d>   Generated labels per instruction (default: %.2f)\n"
+                    "  --forward-ratio <r>   Part of forward label references (default: %.2f)\n"
+                    "  --comment-ratio <r>   Part of lines with comments (default: %.2f)\n"
+                    "  --branch-ratio <r>    Part of instructions referencing labels (default: %.2f)\n"
+                    "  --seed <n>            Generator seed (default: %d)\n",
+                    BENCH_MAX_REPS, BENCH_DEFAULT_REPS, ASM_GEN_DEFAULT_INSTRUCTIONS, ASM_GEN_DEFAULT_LABEL_DENSITY,
+                    ASM_GEN_DEFAULT_FORWARD_RATIO, ASM_GEN_DEFAULT_COMMENT_RATIO, ASM_GEN_DEFAULT_BRANCH_RATIO,
+                    ASM_GEN_DEFAULT_SEED);
+}
+
+static void parse_options(int argc, char* argv[], AsmBenchOptions* options){
+    options->reps = BENCH_DEFAULT_REPS;
+    options->jobs = (uint32_t)sysconf(_SC_NPROCESSORS_ONLN);
+    options->input_file_name = NULL;
+    options->output_file_name = NULL;
+    asm_gen_config_init(&options->gen_config);
+
+    AsmGenConfig* gen_config = &options->gen_config;
+
+    for(int arg_count = 1; arg_count < argc; arg_count ++){
+        const char* arg = argv[arg_count];
+        bool has_value = arg_count + 1 < argc;
+
+        if(strcmp(arg, "--reps") == 0 && has_value){
+            options->reps = (uint32_t)strtoul(argv[++ arg_count], NULL, 10);
+        }
+        else if(strcmp(arg, "--jobs") == 0 && has_value){
+            options->jobs = (uint32_t)strtoul(argv[++ arg_count], NULL, 10);
+        }
+        else if(strcmp(arg, "--output") == 0 && has_value){
+            options->output_file_name = argv[++ arg_count];
+        }
+        else if(strcmp(arg, "--instructions") == 0 && has_value){
+            gen_config->instructions = (uint32_t)strtoul(argv[++ arg_count], NULL, 10);
+        }
+        else if(strcmp(arg, "--label-density") == 0 && has_value){
+            gen_config->label_density = strtod(argv[++ arg_count], NULL);
+        }
+        else if(strcmp(arg, "--forward-ratio") == 0 && has_value){
+            gen_config->forward_ratio = strtod(argv[++ arg_count], NULL);
+        }
+        else if(strcmp(arg, "--comment-ratio") == 0 && has_value){
+            gen_config->comment_ratio = strtod(argv[++ arg_count], NULL);
+        }
+        else if(strcmp(arg, "--branch-ratio") == 0 && has_value){
+            gen_config->branch_ratio = strtod(argv[++ arg_count], NULL);
+        }
+        else if(strcmp(arg, "--seed") == 0 && has_value){
+            gen_config->seed = strtoull(argv[++ arg_count], NULL, 10);
+        }
+        else if(arg[0] != '-' && !options->input_file_name){
+            options->input_file_name = arg;
+        }
+        else{
+            fprintf(stderr, "Unknown option %s!\n", arg);
+            print_usage();
+            abort();
+        }
+    }
+
+    if(options->reps == 0 || options->reps > BENCH_MAX_REPS){
+        fprintf(stderr, "Error: Number of reps must be in range 1..%d!\n", BENCH_MAX_REPS);
+        abort();
+    }
+}
+
+//-------------------------MAIN-------------------------
+
+int main(int argc, char* argv[]){
+    AsmBenchOptions options;
+    parse_options(argc, argv, &options);
+
+    char source_file_name[] = "/tmp/asm_bench_XXXXXX";
+    const char* bench_source_file_name = options.input_file_name;
+
+    if(!bench_source_file_name){
+        int fd = mkstemp(source_file_name);
+        FILE* source_file = fd == -1 ? NULL : fdopen(fd, "w");
+        if(!source_file){
+            fprintf(stderr, "Error: Cannot create temporary source file!\n");
+            abort();
+        }
+
+        asm_gen_write(source_file, &options.gen_config);
+        fclose(source_file);
+        bench_source_file_name = source_file_name;
+    }
+
+    char bin_file_name[] = "/tmp/asm_bench_bin_XXXXXX";
+    int bin_fd = mkstemp(bin_file_name);
+    if(bin_fd == -1){
+        fprintf(stderr, "Error: Cannot create temporary bin file!\n");
+        abort();
+    }
+    close(bin_fd);
+
+    uint64_t lines = count_lines(bench_source_file_name);
+
+    StageResult* results = (StageResult*)calloc(STAGES_NUMBER, sizeof(StageResult));
+    for(uint32_t rep = 0; rep < options.reps; rep ++)
+        run_once(bench_source_file_name, bin_file_name, results, rep, options.jobs);
+
+    FILE* json_file = stdout;
+    if(options.output_file_name){
+        json_file = fopen(options.output_file_name, "w");
+        if(!json_file){
+            fprintf(stderr, "Error opening output file %s!\n", options.output_file_name);
+            abort();
+        }
+    }
+
+    write_json(json_file, options.input_file_name ? options.input_file_name : "generated", lines, &options, results);
+
+    if(json_file != stdout)
+        fclose(json_file);
+
+    // Remove temporary files together with symbol sidecar
+    char symbol_file_name[sizeof(bin_file_name) + sizeof(SYMBOL_FILE_SUFFIX)];
+    snprintf(symbol_file_name, sizeof(symbol_file_name), "%s%s", bin_file_name, SYMBOL_FILE_SUFFIX);
+    unlink(symbol_file_name);
+    unlink(bin_file_name);
+    if(!options.input_file_name)
+        unlink(source_file_name);
+
+    free(results);
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include "asm_gen/asm_gen.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//-------------------------OPTIONS-------------------------
+
+static void print_usage(){
+    fprintf(stderr, "Usage: asm_gen [options] output.myasm\n"
+                    "  --instructions <n>    Number of instructions (default: %d)\n"
+                    "  --label-density <d>   Labels per instruction (default: %.2f)\n"
+                    "  --forward-ratio <r>   Part of label references pointing forward (default: %.2f)\n"
+                    "  --comment-ratio <r>   Part of lines with comments (default: %.2f)\n"
+                    "  --branch-ratio <r>    Part of instructions referencing labels (default: %.2f)\n"
+                    "  --seed <n>            Random seed (default: %d)\n",
+                    ASM_GEN_DEFAULT_INSTRUCTIONS, ASM_GEN_DEFAULT_LABEL_DENSITY, ASM_GEN_DEFAULT_FORWARD_RATIO,
+                    ASM_GEN_DEFAULT_COMMENT_RATIO, ASM_GEN_DEFAULT_BRANCH_RATIO, ASM_GEN_DEFAULT_SEED);
+}
+
+static void parse_options(int argc, char* argv[], AsmGenConfig* config, const char** output_file_name){
+    asm_gen_config_init(config);
+    *output_file_name = NULL;
+
+    for(int arg_count = 1; arg_count < argc; arg_count ++){
+        const char* arg = argv[arg_count];
+        bool has_value = arg_count + 1 < argc;
+
+        if(strcmp(arg, "--instructions") == 0 && has_value){
+            config->instructions = (uint32_t)strtoul(argv[++ arg_count], NULL, 10);
+        }
+        else if(strcmp(arg, "--label-density") == 0 && has_value){
+            config->label_density = strtod(argv[++ arg_count], NULL);
+        }
+        else if(strcmp(arg, "--forward-ratio") == 0 && has_value){
+            config->forward_ratio = strtod(argv[++ arg_count], NULL);
+        }
+        else if(strcmp(arg, "--comment-ratio") == 0 && has_value){
+            config->comment_ratio = strtod(argv[++ arg_count], NULL);
+        }
+        else if(strcmp(arg, "--branch-ratio") == 0 && has_value){
+            config->branch_ratio = strtod(argv[++ arg_count], NULL);
+        }
+        else if(strcmp(arg, "--seed") == 0 && has_value){
+            config->seed = strtoull(argv[++ arg_count], NULL, 10);
+        }
+        else if(arg[0] != '-' && !*output_file_name){
+            *output_file_name = arg;
+        }
+        else{
+            fprintf(stderr, "Unknown option %s!\n", arg);
+            print_usage();
+            abort();
+        }
+    }
+
+    if(!*output_file_name){
+        fprintf(stderr, "Wrong number of args!\n");
+        print_usage();
+        abort();
+    }
+}
+
+//-------------------------MAIN-------------------------
+
+int main(int argc, char* argv[]){
+    AsmGenConfig config;
+    const char* output_file_name = NULL;
+    parse_options(argc, argv, &config, &output_file_name);
+
+    FILE* output_file = fopen(output_file_name, "w");
+    if(!output_file){
+        fprintf(stderr, "Error opening output file %s!\n", output_file_name);
+        abort();
+    }
+
+    uint64_t lines = asm_gen_write(output_file, &config);
+    fclose(output_file);
+
+    fprintf(stderr, "Written %lu lines, %u instructions\n", lines, config.instructions);
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "asm_gen/asm_gen.h"
+
+static const char* const alu_ops[] = {"add", "sub", "mul", "mov"};
+static const char* const branch_ops[] = {"bne", "beq", "bgt", "blt", "bge", "ble"};
+
+#define ALU_OPS_NUMBER (sizeof(alu_ops) / sizeof(alu_ops[0]))
+#define BRANCH_OPS_NUMBER (sizeof(branch_ops) / sizeof(branch_ops[0]))
+#define GEN_REGISTERS 16
+
+//-------------------------RANDOM-------------------------
+
+// xorshift64*, so generated files are the same for given seed on every platform
+static uint64_t next_random(uint64_t* state){
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1Dull;
+}
+
+static double random_unit(uint64_t* state){
+    return (double)(next_random(state) >> 11) / (double)(1ull << 53);
+}
+
+static uint32_t random_below(uint64_t* state, uint32_t bound){
+    return (uint32_t)(next_random(state) % bound);
+}
+
+//-------------------------GENERATION-------------------------
+
+void asm_gen_config_init(AsmGenConfig* config){
+    config->instructions = ASM_GEN_DEFAULT_INSTRUCTIONS;
+    config->label_density = ASM_GEN_DEFAULT_LABEL_DENSITY;
+    config->forward_ratio = ASM_GEN_DEFAULT_FORWARD_RATIO;
+    config->comment_ratio = ASM_GEN_DEFAULT_COMMENT_RATIO;
+    config->branch_ratio = ASM_GEN_DEFAULT_BRANCH_RATIO;
+    config->seed = ASM_GEN_DEFAULT_SEED;
+}
+
+static void write_label_name(FILE* output_file, uint32_t label_index){
+    char name[ASM_GEN_LABEL_NAME_DIGITS + 1];
+    for(int digit = ASM_GEN_LABEL_NAME_DIGITS - 1; digit >= 0; digit --){
+        name[digit] = (char)('a' + label_index % 26);
+        label_index /= 26;
+    }
+    name[ASM_GEN_LABEL_NAME_DIGITS] = '\0';
+
+    fprintf(output_file, "lbl%s", name);
+}
+
+static void write_operand(FILE* output_file, uint64_t* random_state){
+    uint32_t kind = random_below(random_state, 4);
+    if(kind == 0)
+        fprintf(output_file, " %x", random_below(random_state, 0x10000));
+    else
+        fprintf(output_file, " x%x", random_below(random_state, GEN_REGISTERS));
+}
+
+// Label, which is referenced from instruction placed after label with index current_label
+static uint32_t pick_target(AsmGenConfig* config, uint64_t* random_state, uint32_t current_label,
+                            uint32_t labels_count){
+    bool has_backward = current_label > 0;
+    bool has_forward = current_label < labels_count;
+
+    bool forward = random_unit(random_state) < config->forward_ratio;
+    if(forward && !has_forward)
+        forward = false;
+    if(!forward && !has_backward)
+        forward = true;
+
+    if(forward)
+        return current_label + random_below(random_state, labels_count - current_label);
+    return random_below(random_state, current_label);
+}
+
+uint64_t asm_gen_write(FILE* output_file, AsmGenConfig* config){
+    uint64_t random_state = config->seed ? config->seed : ASM_GEN_DEFAULT_SEED;
+
+    // Last instruction is hlt, labels are spread evenly over the rest
+    uint32_t body_instructions = config->instructions > 0 ? config->instructions - 1 : 0;
+    uint32_t labels_count = (uint32_t)(body_instructions * config->label_density);
+    if(labels_count > body_instructions)
+        labels_count = body_instructions;
+
+    uint64_t lines = 0;
+    uint32_t defined_labels = 0;
+
+    for(uint32_t instruction = 0; instruction < body_instructions; instruction ++){
+        // Label i is placed before instruction i * body_instructions / labels_count
+        while(defined_labels < labels_count &&
+              (uint64_t)defined_labels * body_instructions / labels_count <= instruction){
+            fprintf(output_file, ":");
+            write_label_name(output_file, defined_labels);
+            fprintf(output_file, "\n");
+            defined_labels ++;
+            lines ++;
+        }
+
+        double comment = random_unit(&random_state);
+        if(comment < config->comment_ratio / 2){
+            fprintf(output_file, "; generated comment line %u\n", instruction);
+            lines ++;
+        }
+
+        if(labels_count != 0 && random_unit(&random_state) < config->branch_ratio){
+            uint32_t target = pick_target(config, &random_state, defined_labels, labels_count);
+
+            if(random_below(&random_state, 8) == 0){
+                fprintf(output_file, "cfn :");
+            }
+            else{
+                fprintf(output_file, "%s", branch_ops[random_below(&random_state, BRANCH_OPS_NUMBER)]);
+                write_operand(output_file, &random_state);
+                write_operand(output_file, &random_state);
+                fprintf(output_file, " :");
+            }
+            write_label_name(output_file, target);
+        }
+        else{
+            uint32_t op_index = random_below(&random_state, ALU_OPS_NUMBER);
+            fprintf(output_file, "%s x%x", alu_ops[op_index], random_below(&random_state, GEN_REGISTERS));
+
+            // mov has one source, others have two
+            write_operand(output_file, &random_state);
+            if(op_index != ALU_OPS_NUMBER - 1)
+                write_operand(output_file, &random_state);
+        }
+
+        if(comment >= config->comment_ratio / 2 && comment < config->comment_ratio)
+            fprintf(output_file, " ; trailing comment");
+
+        fprintf(output_file, "\n");
+        lines ++;
+    }
+
+    // Labels which didn't get instruction are placed before hlt
+    for(; defined_labels < labels_count; defined_labels ++){
+        fprintf(output_file, ":");
+        write_label_name(output_file, defined_labels);
+        fprintf(output_file, "\n");
+        lines ++;
+    }
+
+    fprintf(output_file, "hlt\n");
+    return lines + 1;
+}
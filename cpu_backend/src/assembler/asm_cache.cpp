@@ -0,0 +1,169 @@
+#include "instructions/instructions.h"
+#include "exceptions/exceptions.h"
+#include "text_asm_parser/text_asm_parser.h"
+#include "text_asm_parser/lexer.h"
+#include "assembler/assembler.h"
+#include "assembler/asm_cache.h"
+#include "symbols/symbols.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <openssl/evp.h>
+
+#define ASM_CACHE_KEY_SIZE (2 * 32)
+
+bool asm_cache_is_source(const char* file_name){
+    size_t name_size = strlen(file_name);
+    size_t suffix_size = strlen(ASM_SOURCE_SUFFIX);
+    return name_size > suffix_size && strcmp(file_name + name_size - suffix_size, ASM_SOURCE_SUFFIX) == 0;
+}
+
+//-------------------------------KEY-------------------------------
+
+// Hex sha256 of assembler version and source text
+static void compute_cache_key(const char* source_file_name, char key[ASM_CACHE_KEY_SIZE + 1]){
+    SourceFile source_file;
+    source_file_open(&source_file, source_file_name);
+
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digest_size = 0;
+
+    EVP_MD_CTX* context = EVP_MD_CTX_new();
+    if(!context || !EVP_DigestInit_ex(context, EVP_sha256(), NULL) ||
+       !EVP_DigestUpdate(context, ASSEMBLER_VERSION, sizeof(ASSEMBLER_VERSION)) ||
+       !EVP_DigestUpdate(context, source_file.data, source_file.size) ||
+       !EVP_DigestFinal_ex(context, digest, &digest_size)){
+        fprintf(stderr, "Error: Cannot hash source %s!\n", source_file_name);
+        abort();
+    }
+    EVP_MD_CTX_free(context);
+    source_file_close(&source_file);
+
+    for(unsigned int i = 0; i < digest_size && 2 * i < ASM_CACHE_KEY_SIZE; i ++){
+        snprintf(&key[2 * i], 3, "%02x", digest[i]);
+    }
+    key[ASM_CACHE_KEY_SIZE] = '\0';
+}
+
+//-------------------------------DIRECTORY-------------------------------
+
+static void make_directory(const char* path){
+    if(mkdir(path, 0755) == -1 && errno != EEXIST){
+        fprintf(stderr, "Error: Cannot create cache directory %s!\n", path);
+        abort();
+    }
+}
+
+// Allocated path of cache directory, which is created if needed
+static char* cache_directory(){
+    const char* xdg_cache_home = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+
+    char* directory = NULL;
+    int length = 0;
+
+    if(xdg_cache_home && xdg_cache_home[0] == '/'){
+        length = asprintf(&directory, "%s/" ASM_CACHE_DIR_NAME, xdg_cache_home);
+    }
+    else if(home && home[0] != '\0'){
+        char* cache_home = NULL;
+        if(asprintf(&cache_home, "%s/.cache", home) == -1){
+            fprintf(stderr, "Error: Cannot allocate memory!\n");
+            abort();
+        }
+        make_directory(cache_home);
+        free(cache_home);
+
+        length = asprintf(&directory, "%s/.cache/" ASM_CACHE_DIR_NAME, home);
+    }
+    else{
+        length = asprintf(&directory, "/tmp/" ASM_CACHE_DIR_NAME "-%u", (unsigned)getuid());
+    }
+
+    if(length == -1){
+        fprintf(stderr, "Error: Cannot allocate memory!\n");
+        abort();
+    }
+
+    make_directory(directory);
+    return directory;
+}
+
+//-------------------------------STORE-------------------------------
+
+static void rename_cache_file(const char* old_name, const char* new_name){
+    if(rename(old_name, new_name) == -1){
+        fprintf(stderr, "Error: Cannot store cache file %s!\n", new_name);
+        abort();
+    }
+}
+
+// Files are written under temporary names and renamed, so concurrent runs never see partial entry.
+// Symbol file is renamed first: if bin exists, its symbols exist too.
+static void store_program(const char* source_file_name, const char* bin_file_name){
+    BinInstructionArray bin_instructions_array;
+    LabelTable label_table;
+
+    SymbolMap symbol_map;
+    symbol_map_init(&symbol_map);
+
+    TRY{
+        assemble_text_asm_file(source_file_name, &bin_instructions_array, &label_table, &symbol_map);
+    }
+    CATCH_ALL{
+        free(bin_instructions_array.bin_instruction_list);
+        symbol_map_free(&symbol_map);
+        parser_critical_error(NULL, &label_table);
+    }
+    END_TRY;
+
+    char* temp_bin_file_name = NULL;
+    char* temp_symbol_file_name = NULL;
+    char* symbol_file_name = NULL;
+    if(asprintf(&temp_bin_file_name, "%s.%d.tmp", bin_file_name, (int)getpid()) == -1 ||
+       asprintf(&temp_symbol_file_name, "%s" SYMBOL_FILE_SUFFIX, temp_bin_file_name) == -1 ||
+       asprintf(&symbol_file_name, "%s" SYMBOL_FILE_SUFFIX, bin_file_name) == -1){
+        fprintf(stderr, "Error: Cannot allocate memory!\n");
+        abort();
+    }
+
+    // Cached bin is the same container as assembler output, with stack hints
+    ProgramOptions program_options;
+    program_options_init(&program_options);
+
+    write_symbol_map_file(&label_table, &symbol_map, temp_bin_file_name);
+    write_program_file(&bin_instructions_array, &symbol_map, &program_options, temp_bin_file_name);
+
+    rename_cache_file(temp_symbol_file_name, symbol_file_name);
+    rename_cache_file(temp_bin_file_name, bin_file_name);
+
+    free(temp_bin_file_name);
+    free(temp_symbol_file_name);
+    free(symbol_file_name);
+
+    symbol_map_free(&symbol_map);
+    free_label_table(&label_table);
+    free(bin_instructions_array.bin_instruction_list);
+}
+
+char* asm_cache_get(const char* source_file_name){
+    char key[ASM_CACHE_KEY_SIZE + 1];
+    compute_cache_key(source_file_name, key);
+
+    char* directory = cache_directory();
+    char* bin_file_name = NULL;
+    if(asprintf(&bin_file_name, "%s/%s.bin", directory, key) == -1){
+        fprintf(stderr, "Error: Cannot allocate memory!\n");
+        abort();
+    }
+    free(directory);
+
+    if(access(bin_file_name, R_OK) != 0)
+        store_program(source_file_name, bin_file_name);
+
+    return bin_file_name;
+}
@@ -0,0 +1,336 @@
+#include "instructions/instructions.h"
+#include "text_asm_parser/text_asm_parser.h"
+#include "assembler/assembler.h"
+#include "symbols/symbols.h"
+#include "object/object.h"
+#include "binary_format/binary_format.h"
+#include "stack_depth/stack_depth.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+//-----------------------DEBUG-----------------------
+static void print_bin_instruction(BinInstruction* bin_instruction){
+    printf("%b %b %b %b\n", bin_instruction->operation, bin_instruction->arg_list[0],
+           bin_instruction->arg_list[1], bin_instruction->arg_list[2]);
+}
+
+//--------------------ASSEMBLER----------------------
+static void assemble_flag(uint32_t* bin_operation, const char* text_flag, int arg_count) {
+    int byte_position = ARG_FLAGS_SHIFT(arg_count);
+
+    for (int flag_idx = 0; flag_idx < INSTRUCTIONS_FLAGS_NUMBER && text_flag[flag_idx] != '\0'; flag_idx++) {
+        if (text_flag[flag_idx] == ' ') {
+            continue;  
+        }
+        
+        for (int i = 0; i < INSTRUCTIONS_FLAGS_NUMBER; i++) {
+            if (text_flag[flag_idx] == instruction_flag[i]) {
+                *bin_operation |= (1 << (byte_position + i));
+                break;
+            }
+        }
+    }
+}
+
+void assemble_text_instruction(BinInstruction* bin_instruction, TextInstruction* text_instruction){
+    bin_instruction->operation = 0;
+    
+    bin_instruction->operation |= (text_instruction->operation.op_code << 24);
+    
+    if(DEBUG){
+    printf("op code: %d  arg list: %s  bin rep: %b\n", text_instruction->operation.op_code,
+           instruction_set[text_instruction->operation.op_code].op_name,
+           (bin_instruction->operation >> 24) & 0xFF);
+    }
+
+    for(uint32_t arg_count = 0; arg_count < text_instruction->operation.num_of_args; arg_count++){
+        bin_instruction->arg_list[arg_count] = text_instruction->imm[arg_count].imm;
+        
+        assemble_flag(&bin_instruction->operation,
+                      text_instruction->imm[arg_count].imm_flag,
+                      arg_count);
+    }
+}
+
+void assemble_text_instructions_array(BinInstructionArray* bin_instructions_array,
+                                      TextInstructionArray* text_instructions_array){
+    for(uint32_t instructions_count = 0; instructions_count < text_instructions_array->count; instructions_count ++){
+        assemble_text_instruction(&bin_instructions_array->bin_instruction_list[instructions_count],
+                                  &text_instructions_array->text_instruction_list[instructions_count]);
+        if(DEBUG)
+            print_bin_instruction(&bin_instructions_array->bin_instruction_list[instructions_count]);
+    }
+}
+
+
+void write_bin_file(BinInstructionArray* bin_instructions_array, const char* output_bin_file){
+    int fd = open(output_bin_file, O_RDWR | O_CREAT | O_TRUNC, 0644);  
+    if(fd == -1){
+        fprintf(stderr, "Error opening output file!");
+        abort();
+    }
+
+    size_t bin_file_size = bin_instructions_array->count * sizeof(BinInstruction);
+
+    if(ftruncate(fd, bin_file_size) == -1){
+        close(fd);
+        fprintf(stderr, "Error truncating file!");
+        abort();
+    }
+
+    BinInstruction* mapped_mem = (BinInstruction*)mmap(NULL, bin_file_size, PROT_WRITE,
+                                                       MAP_SHARED, fd, 0);
+    if(mapped_mem == MAP_FAILED){
+        close(fd);
+        fprintf(stderr, "Cannot map memory for bin file!");
+        abort();
+    }
+
+    memcpy(mapped_mem, bin_instructions_array->bin_instruction_list, bin_file_size);
+    
+    // Ensure data is written to disk
+    msync(mapped_mem, bin_file_size, MS_SYNC);
+    
+    munmap(mapped_mem, bin_file_size);
+    close(fd);
+}
+
+//--------------------PROGRAM----------------------
+
+void program_options_init(ProgramOptions* options){
+    options->compact = false;
+    options->entry_label = NULL;
+    options->data_file = NULL;
+    options->stack_hints.data_stack_size = 0;
+    options->stack_hints.call_stack_size = 0;
+    options->stack_report = false;
+}
+
+bool parse_program_option(int argc, char* argv[], int* arg_count, ProgramOptions* options){
+    const char* arg = argv[*arg_count];
+    bool has_value = *arg_count + 1 < argc;
+
+    if(strcmp(arg, "--compact") == 0){
+        options->compact = true;
+    }
+    else if(strcmp(arg, "--entry") == 0 && has_value){
+        options->entry_label = argv[++ *arg_count];
+    }
+    else if(strcmp(arg, "--data") == 0 && has_value){
+        options->data_file = argv[++ *arg_count];
+    }
+    else if(strcmp(arg, "--stack-hints") == 0 && has_value){
+        const char* value = argv[++ *arg_count];
+        if(sscanf(value, "%u:%u", &options->stack_hints.data_stack_size, &options->stack_hints.call_stack_size) != 2){
+            fprintf(stderr, "Error: Stack hints must be given as data_bytes:call_depth, not %s!\n", value);
+            abort();
+        }
+    }
+    else if(strcmp(arg, "--stack-report") == 0){
+        options->stack_report = true;
+    }
+    else{
+        return false;
+    }
+    return true;
+}
+
+static uint8_t* read_data_file(const char* data_file, uint32_t* data_size){
+    FILE* file = fopen(data_file, "rb");
+    if(!file){
+        fprintf(stderr, "Error opening data file %s!\n", data_file);
+        abort();
+    }
+
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    uint8_t* data = (uint8_t*)malloc((size_t)file_size + 1);
+    if(!data || file_size < 0 || (uint64_t)file_size > UINT32_MAX ||
+       fread(data, 1, (size_t)file_size, file) != (size_t)file_size){
+        fprintf(stderr, "Error reading data file %s!\n", data_file);
+        abort();
+    }
+    fclose(file);
+
+    *data_size = (uint32_t)file_size;
+    return data;
+}
+
+static void print_stack_report(const StackDepth* depth, const SymbolMap* symbol_map){
+    if(depth->data_bounded)
+        printf("Data stack: %u bytes\n", depth->data_stack_size);
+    else
+        printf("Data stack: unbounded, %s\n", depth->data_reason);
+
+    if(depth->calls_bounded){
+        printf("Call stack: %u return addresses\n", depth->call_stack_size);
+        return;
+    }
+
+    if(!depth->recursion){
+        printf("Call stack: unbounded, %s\n", depth->calls_reason);
+        return;
+    }
+
+    const Symbol* symbol = symbol_map_find(symbol_map, depth->recursion_address);
+    if(symbol && symbol->address == depth->recursion_address)
+        printf("Call stack: unbounded, recursion through :%s\n", symbol->name);
+    else
+        printf("Call stack: unbounded, recursion through %08x\n", depth->recursion_address);
+}
+
+// Hints, which aren't given in options, are bounds found by stack depth analysis, 0 if there is no bound
+static void fill_stack_hints(BinaryImage* image, const ProgramOptions* options){
+    StackDepth depth;
+    stack_depth_analyze(image->code.bin_instruction_list, image->code.count, image->entry_point, image->data_size,
+                        &depth);
+
+    if(options->stack_report)
+        print_stack_report(&depth, image->symbol_map);
+
+    // Zero hint means unknown size, so empty stacks get one spare element
+    if(image->stack_hints.data_stack_size == 0 && depth.data_bounded)
+        image->stack_hints.data_stack_size = depth.data_stack_size > 0 ? depth.data_stack_size : 1;
+    if(image->stack_hints.call_stack_size == 0 && depth.calls_bounded)
+        image->stack_hints.call_stack_size = depth.call_stack_size > 0 ? depth.call_stack_size : 1;
+}
+
+void write_program_file(BinInstructionArray* bin_instructions_array, SymbolMap* symbol_map,
+                        const ProgramOptions* options, const char* output_bin_file){
+    BinaryImage image;
+    binary_image_init(&image);
+
+    image.encoding = options->compact ? ENCODING_COMPACT : ENCODING_FIXED;
+    image.code = *bin_instructions_array;
+    image.stack_hints = options->stack_hints;
+    image.symbol_map = symbol_map;
+
+    if(options->entry_label){
+        // Label may be given as it is written in source
+        const char* entry_name = options->entry_label + (options->entry_label[0] == ':');
+        const Symbol* entry = symbol_map_find_name(symbol_map, entry_name);
+        if(!entry){
+            fprintf(stderr, "Error: Entry label %s is not defined!\n", options->entry_label);
+            abort();
+        }
+        image.entry_point = entry->address;
+    }
+
+    if(options->data_file)
+        image.data = read_data_file(options->data_file, &image.data_size);
+
+    fill_stack_hints(&image, options);
+
+    binary_image_write(&image, output_bin_file);
+    free(image.data);
+}
+
+static void add_label_symbols(SymbolMap* symbol_map, LabelTable* label_table){
+    for(uint32_t i = 0; i < label_table->count; i ++){
+        Label* label = &label_table->label_list[i];
+        if(label->address == LABEL_UNDEFINED)
+            continue;
+
+        symbol_map_add_symbol(symbol_map, get_label_name(label), label->label_size, label->address);
+    }
+}
+
+// Symbol sidecar maps label names and source lines to addresses for profiling tools
+void write_symbol_map_file(LabelTable* label_table, SymbolMap* symbol_map, const char* output_bin_file){
+    add_label_symbols(symbol_map, label_table);
+    write_symbol_sidecar(symbol_map, output_bin_file);
+}
+
+void write_symbol_sidecar(SymbolMap* symbol_map, const char* output_bin_file){
+    symbol_map_sort(symbol_map);
+
+    size_t output_name_size = strlen(output_bin_file);
+    char* symbol_file_name = (char*)calloc(output_name_size + sizeof(SYMBOL_FILE_SUFFIX), sizeof(char));
+    memcpy(symbol_file_name, output_bin_file, output_name_size);
+    strcat(symbol_file_name, SYMBOL_FILE_SUFFIX);
+
+    symbol_map_write(symbol_map, symbol_file_name);
+
+    free(symbol_file_name);
+}
+
+void write_symbol_file(LabelTable* label_table, TextInstructionArray* text_instructions_array,
+                       const char* output_bin_file){
+    SymbolMap symbol_map;
+    symbol_map_init(&symbol_map);
+
+    for(uint32_t i = 0; i < text_instructions_array->count; i ++){
+        symbol_map_add_line(&symbol_map, i * BIN_INSTRUCTION_SIZE,
+                            text_instructions_array->text_instruction_list[i].line);
+    }
+
+    write_symbol_map_file(label_table, &symbol_map, output_bin_file);
+    symbol_map_free(&symbol_map);
+}
+
+//--------------------OBJECT----------------------
+
+void assemble_object_file(ObjectFile* object_file, TextInstructionArray* text_instructions_array,
+                          LabelTable* label_table){
+    ObjectFileHeader* header = &object_file->header;
+    header->instructions_count = text_instructions_array->count;
+    header->symbols_count = label_table->count;
+    header->lines_count = text_instructions_array->count;
+
+    header->relocations_count = 0;
+    for(uint32_t i = 0; i < text_instructions_array->count; i ++){
+        TextInstruction* text_instruction = &text_instructions_array->text_instruction_list[i];
+        for(uint32_t arg_count = 0; arg_count < text_instruction->operation.num_of_args; arg_count ++){
+            if(text_instruction->imm[arg_count].label)
+                header->relocations_count ++;
+        }
+    }
+
+    header->names_size = 0;
+    for(uint32_t i = 0; i < label_table->count; i ++){
+        header->names_size += label_table->label_list[i].label_size + 1;
+    }
+
+    object_file_alloc(object_file);
+
+    BinInstructionArray bin_instructions_array = {object_file->instruction_list, text_instructions_array->count};
+    assemble_text_instructions_array(&bin_instructions_array, text_instructions_array);
+
+    uint32_t name_offset = 0;
+    for(uint32_t i = 0; i < label_table->count; i ++){
+        Label* label = &label_table->label_list[i];
+        ObjectSymbol* symbol = &object_file->symbol_list[i];
+
+        symbol->name_offset = name_offset;
+        symbol->name_size = label->label_size;
+        symbol->address = label->address != LABEL_UNDEFINED ? label->address : 0;
+        symbol->flags = label->address != LABEL_UNDEFINED ? OBJECT_SYMBOL_DEFINED : 0;
+
+        memcpy(object_file->names + name_offset, get_label_name(label), label->label_size + 1);
+        name_offset += label->label_size + 1;
+    }
+
+    uint32_t relocations_count = 0;
+    for(uint32_t i = 0; i < text_instructions_array->count; i ++){
+        TextInstruction* text_instruction = &text_instructions_array->text_instruction_list[i];
+
+        for(uint32_t arg_count = 0; arg_count < text_instruction->operation.num_of_args; arg_count ++){
+            if(!text_instruction->imm[arg_count].label)
+                continue;
+
+            ObjectRelocation* relocation = &object_file->relocation_list[relocations_count ++];
+            relocation->instruction = i;
+            relocation->arg = arg_count;
+            relocation->symbol = text_instruction->imm[arg_count].label - 1;
+        }
+
+        object_file->line_list[i].address = i * BIN_INSTRUCTION_SIZE;
+        object_file->line_list[i].line = text_instruction->line;
+    }
+}
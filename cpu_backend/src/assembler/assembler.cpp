@@ -1,155 +1,202 @@
 #include "instructions/instructions.h"
 #include "exceptions/exceptions.h"
 #include "text_asm_parser/text_asm_parser.h"
-#include "stack/stack.h"
+#include "assembler/assembler.h"
+#include "symbols/symbols.h"
+#include "optimizer/optimizer.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/mman.h>
-#include <fcntl.h>
 #include <unistd.h>
 
-//-----------------------DEBUG-----------------------
-static void print_bin_instruction(BinInstruction* bin_instruction){
-    printf("%b %b %b %b\n", bin_instruction->operation, bin_instruction->arg_list[0],
-           bin_instruction->arg_list[1], bin_instruction->arg_list[2]);
-}
+typedef struct AssemblerOptions{
+    const char* text_asm_file;
+    const char* output_bin_file;
+    bool two_pass;
+    // Parsed program is optimized before assembling, implies two pass
+    bool optimize;
+    // Relocatable object is written instead of bin
+    bool object;
+    // More than one job selects parallel assembler
+    uint32_t jobs_count;
+    ProgramOptions program;
+}AssemblerOptions;
+
+//--------------------TWO_PASS----------------------
+
+// Whole source is parsed into text instructions first, then assembled
+static void assemble_two_pass(AssemblerOptions* options){
+    TextInstructionArray text_instr_arr;
+    TextInstructionArray* text_instructions_array = & text_instr_arr;
 
-//--------------------ASSEMBLER----------------------
-static void assemble_flag(uint32_t* bin_operation, const char* text_flag, int arg_count) {
-    int byte_position = 16 - (arg_count * 8);
 
-    for (int flag_idx = 0; flag_idx < INSTRUCTIONS_FLAGS_NUMBER && text_flag[flag_idx] != '\0'; flag_idx++) {
-        if (text_flag[flag_idx] == ' ') {
-            continue;  
-        }
-        
-        for (int i = 0; i < INSTRUCTIONS_FLAGS_NUMBER; i++) {
-            if (text_flag[flag_idx] == instruction_flag[i]) {
-                *bin_operation |= (1 << (byte_position + i));
-                break;
-            }
-        }
-    }
-}
+    LabelTable lab_tab;
+    LabelTable* label_table = &lab_tab;
 
-static void assemble_text_instruction(BinInstruction* bin_instruction, TextInstruction* text_instruction){
-    bin_instruction->operation = 0;
-    
-    bin_instruction->operation |= (text_instruction->operation.op_code << 24);
-    
-    if(DEBUG){
-    printf("op code: %d  arg list: %s  bin rep: %b\n", text_instruction->operation.op_code,
-           instruction_set[text_instruction->operation.op_code].op_name,
-           (bin_instruction->operation >> 24) & 0xFF);
-    }
 
-    for(uint32_t arg_count = 0; arg_count < text_instruction->operation.num_of_args; arg_count++){
-        bin_instruction->arg_list[arg_count] = text_instruction->imm[arg_count].imm;
-        
-        assemble_flag(&bin_instruction->operation,
-                      text_instruction->imm[arg_count].imm_flag,
-                      arg_count);
-    }
-}
+    // TODO: In text_instructions_array reallocation handle case, when capacity * 1.5 > UINT_MAX
 
-static void assemble_text_instructions_array(BinInstructionArray* bin_instructions_array,
-                                             TextInstructionArray* text_instructions_array){
-    for(uint32_t instructions_count = 0; instructions_count < text_instructions_array->count; instructions_count ++){
-        assemble_text_instruction(&bin_instructions_array->bin_instruction_list[instructions_count],
-                                  &text_instructions_array->text_instruction_list[instructions_count]);
-        if(DEBUG)
-            print_bin_instruction(&bin_instructions_array->bin_instruction_list[instructions_count]);
+    // Parse assembler file into text instruction representation
+    TRY{
+        parse_text_asm_file(options->text_asm_file, text_instructions_array, label_table);
     }
-}
+    CATCH_ALL{
+        parser_critical_error(text_instructions_array, label_table);
+    }
+    END_TRY;
 
+    if(options->optimize)
+        optimize_text_instructions(text_instructions_array, label_table, options->program.entry_label);
 
-static void write_bin_file(BinInstructionArray* bin_instructions_array, const char* output_bin_file){
-    int fd = open(output_bin_file, O_RDWR | O_CREAT | O_TRUNC, 0644);  
-    if(fd == -1){
-        fprintf(stderr, "Error opening output file!");
-        abort();
-    }
+    BinInstructionArray bin_inst_arr;
+    BinInstructionArray* bin_instructions_array = & bin_inst_arr;
 
-    size_t bin_file_size = bin_instructions_array->count * sizeof(BinInstruction);
+    bin_instructions_array->count = text_instructions_array->count;
+    bin_instructions_array->bin_instruction_list = (BinInstruction*)calloc( text_instructions_array->count,
+                                                                           sizeof(BinInstruction));
 
-    if(ftruncate(fd, bin_file_size) == -1){
-        close(fd);
-        fprintf(stderr, "Error truncating file!");
-        abort();
-    }
+    assemble_text_instructions_array(bin_instructions_array, text_instructions_array);
 
-    BinInstruction* mapped_mem = (BinInstruction*)mmap(NULL, bin_file_size, PROT_WRITE,
-                                                       MAP_SHARED, fd, 0);
-    if(mapped_mem == MAP_FAILED){
-        close(fd);
-        fprintf(stderr, "Cannot map memory for bin file!");
-        abort();
+
+    SymbolMap symbol_map;
+    symbol_map_init(&symbol_map);
+    for(uint32_t i = 0; i < text_instructions_array->count; i ++){
+        symbol_map_add_line(&symbol_map, i * BIN_INSTRUCTION_SIZE,
+                            text_instructions_array->text_instruction_list[i].line);
     }
 
-    memcpy(mapped_mem, bin_instructions_array->bin_instruction_list, bin_file_size);
-    
-    // Ensure data is written to disk
-    msync(mapped_mem, bin_file_size, MS_SYNC);
-    
-    munmap(mapped_mem, bin_file_size);
-    close(fd);
-}
+    write_symbol_map_file(label_table, &symbol_map, options->output_bin_file);
+    write_program_file(bin_instructions_array, &symbol_map, &options->program, options->output_bin_file);
 
+    symbol_map_free(&symbol_map);
+    free_text_instruction_list(text_instructions_array);
+    free_label_table(label_table);
 
-int main(int argc, char* argv[]){
-    const char* text_asm_file = NULL;
-    const char* output_bin_file = NULL;
+    free(bin_instructions_array->bin_instruction_list);
+}
 
-    if(argc == 2){
-        text_asm_file = argv[1];
-    }
+//--------------------SINGLE_PASS----------------------
 
-    if(argc == 3){
-        text_asm_file = argv[1];
-        output_bin_file = argv[2];
-    }
+static void assemble_single_pass(AssemblerOptions* options){
+    BinInstructionArray bin_instructions_array;
+    LabelTable label_table;
 
-    else{
+    SymbolMap symbol_map;
+    symbol_map_init(&symbol_map);
 
-        fprintf(stderr,"Wrong num of args!");
-        abort();
+    TRY{
+        if(options->jobs_count > 1)
+            assemble_text_asm_file_parallel(options->text_asm_file, &bin_instructions_array, &label_table,
+                                            &symbol_map, options->jobs_count);
+        else
+            assemble_text_asm_file(options->text_asm_file, &bin_instructions_array, &label_table, &symbol_map);
     }
+    CATCH_ALL{
+        free(bin_instructions_array.bin_instruction_list);
+        symbol_map_free(&symbol_map);
+        parser_critical_error(NULL, &label_table);
+    }
+    END_TRY;
 
-    TextInstructionArray text_instr_arr;
-    TextInstructionArray* text_instructions_array = & text_instr_arr;
-
+    write_symbol_map_file(&label_table, &symbol_map, options->output_bin_file);
+    write_program_file(&bin_instructions_array, &symbol_map, &options->program, options->output_bin_file);
 
-    LabelTable lab_tab;
-    LabelTable* label_table = &lab_tab;
+    symbol_map_free(&symbol_map);
+    free_label_table(&label_table);
+    free(bin_instructions_array.bin_instruction_list);
+}
 
+//--------------------OBJECT----------------------
 
-    // TODO: In text_instructions_array reallocation handle case, when capacity * 1.5 > UINT_MAX
+static void assemble_object(AssemblerOptions* options){
+    TextInstructionArray text_instructions_array;
+    LabelTable label_table;
 
-    // Parse assembler file into text instruction representation
     TRY{
-        parse_text_asm_file(text_asm_file, text_instructions_array, label_table);
+        parse_text_asm_file(options->text_asm_file, &text_instructions_array, &label_table);
     }
     CATCH_ALL{
-        parser_critical_error(text_instructions_array, label_table);
+        parser_critical_error(&text_instructions_array, &label_table);
     }
     END_TRY;
 
-    BinInstructionArray bin_inst_arr;
-    BinInstructionArray* bin_instructions_array = & bin_inst_arr;
+    ObjectFile object_file;
+    assemble_object_file(&object_file, &text_instructions_array, &label_table);
+    object_file_write(&object_file, options->output_bin_file);
 
-    bin_instructions_array->count = text_instructions_array->count;
-    bin_instructions_array->bin_instruction_list = (BinInstruction*)calloc( text_instructions_array->count,
-                                                                           sizeof(BinInstruction));
+    object_file_free(&object_file);
+    free_text_instruction_list(&text_instructions_array);
+    free_label_table(&label_table);
+}
 
-    assemble_text_instructions_array(bin_instructions_array, text_instructions_array);
+//--------------------MAIN----------------------
 
+static void parse_options(int argc, char* argv[], AssemblerOptions* options){
+    options->text_asm_file = NULL;
+    options->output_bin_file = NULL;
+    options->two_pass = false;
+    options->optimize = false;
+    options->object = false;
+    options->jobs_count = 1;
+    program_options_init(&options->program);
 
-    write_bin_file(bin_instructions_array, output_bin_file);
+    for(int arg_count = 1; arg_count < argc; arg_count ++){
+        const char* arg = argv[arg_count];
 
-    free_text_instruction_list(text_instructions_array);
-    free_label_table(label_table);
+        if(parse_program_option(argc, argv, &arg_count, &options->program))
+            continue;
+
+        if(strcmp(arg, "--two-pass") == 0){
+            options->two_pass = true;
+        }
+        else if(strcmp(arg, "-O") == 0){
+            options->optimize = true;
+        }
+        else if(strcmp(arg, "-c") == 0){
+            options->object = true;
+        }
+        else if(strcmp(arg, "-j") == 0 && arg_count + 1 < argc){
+            // -j 0 uses all online cores
+            options->jobs_count = (uint32_t)strtoul(argv[++ arg_count], NULL, 10);
+            if(options->jobs_count == 0)
+                options->jobs_count = (uint32_t)sysconf(_SC_NPROCESSORS_ONLN);
+        }
+        else if(arg[0] != '-' && !options->text_asm_file){
+            options->text_asm_file = arg;
+        }
+        else if(arg[0] != '-' && !options->output_bin_file){
+            options->output_bin_file = arg;
+        }
+        else{
+            fprintf(stderr, "Unknown option %s!\n", arg);
+            options->text_asm_file = NULL;
+            break;
+        }
+    }
+
+    if(options->object && options->optimize){
+        fprintf(stderr, "Optimizer needs whole program, it can't be used with -c!\n");
+        abort();
+    }
+
+    if(!options->text_asm_file || !options->output_bin_file){
+        fprintf(stderr, "Wrong num of args!\n"
+                        "Usage: assembler [--two-pass | -j jobs | -O] " PROGRAM_OPTIONS_USAGE " program.myasm program.bin\n"
+                        "       assembler -c module.myasm module.myo\n");
+        abort();
+    }
+}
+
+int main(int argc, char* argv[]){
+    AssemblerOptions options;
+    parse_options(argc, argv, &options);
+
+    if(options.object)
+        assemble_object(&options);
+    else if(options.two_pass || options.optimize)
+        assemble_two_pass(&options);
+    else
+        assemble_single_pass(&options);
 
-    free(bin_instructions_array->bin_instruction_list);
     return 0;
 }
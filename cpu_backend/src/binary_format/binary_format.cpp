@@ -0,0 +1,551 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "binary_format/binary_format.h"
+
+//-------------------------------FLAGS-------------------------------
+
+// Flags of arg take this many bits in compact mode byte
+#define FLAGS_BITS_PER_ARG 2
+
+//-------------------------------ENCODING-------------------------------
+
+static inline uint8_t* write_varint(uint8_t* stream, uint32_t value){
+    while(value >= 0x80){
+        *stream ++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *stream ++ = (uint8_t)value;
+    return stream;
+}
+
+static void compact_encode_error(uint32_t instruction, const char* message){
+    fprintf(stderr, "Error: Instruction %u can't be encoded compactly: %s!\n", instruction, message);
+    abort();
+}
+
+size_t compact_encode(const BinInstruction* instruction_list, uint32_t count, uint8_t* stream){
+    uint8_t* stream_begin = stream;
+
+    for(uint32_t i = 0; i < count; i ++){
+        const BinInstruction* instruction = &instruction_list[i];
+        uint32_t op_code = instruction->operation >> 24;
+
+        if(op_code >= INSTRUCTIONS_SET_NUMBER)
+            compact_encode_error(i, "unknown op code");
+
+        uint32_t num_of_args = instruction_set[op_code].num_of_args;
+        uint32_t operation = instruction->operation & 0x00ffffff;
+        uint8_t mode = 0;
+
+        for(uint32_t arg = 0; arg < num_of_args; arg ++){
+            uint32_t flags = (operation >> ARG_FLAGS_SHIFT(arg)) & ARG_FLAGS_MASK;
+            mode |= (uint8_t)(flags << (arg * FLAGS_BITS_PER_ARG));
+            operation &= ~(ARG_FLAGS_MASK << ARG_FLAGS_SHIFT(arg));
+        }
+
+        // Decoder restores only op code, flags of used args and used args
+        if(operation != 0)
+            compact_encode_error(i, "unsupported header bits");
+        for(uint32_t arg = num_of_args; arg < 3; arg ++){
+            if(instruction->arg_list[arg] != 0)
+                compact_encode_error(i, "unused arg isn't zero");
+        }
+
+        *stream ++ = (uint8_t)op_code;
+        *stream ++ = mode;
+        for(uint32_t arg = 0; arg < num_of_args; arg ++){
+            stream = write_varint(stream, instruction->arg_list[arg]);
+        }
+    }
+
+    return (size_t)(stream - stream_begin);
+}
+
+//-------------------------------DECODING-------------------------------
+
+static inline const uint8_t* read_varint(const uint8_t* stream, const uint8_t* stream_end, uint32_t* value){
+    uint32_t result = 0;
+
+    for(uint32_t shift = 0; shift < 35 && stream < stream_end; shift += 7){
+        uint8_t byte = *stream ++;
+
+        // Fifth byte may carry only 4 remaining bits
+        if(shift == 28 && byte > 0x0f)
+            return NULL;
+
+        result |= (uint32_t)(byte & 0x7f) << shift;
+        if(!(byte & 0x80)){
+            *value = result;
+            return stream;
+        }
+    }
+    return NULL;
+}
+
+size_t compact_decode(const uint8_t* stream, size_t stream_size, BinInstruction* instruction_list, uint32_t count){
+    const uint8_t* stream_begin = stream;
+    const uint8_t* stream_end = stream + stream_size;
+
+    for(uint32_t i = 0; i < count; i ++){
+        if(stream_end - stream < 2)
+            return 0;
+
+        uint32_t op_code = *stream ++;
+        uint8_t mode = *stream ++;
+        if(op_code >= INSTRUCTIONS_SET_NUMBER)
+            return 0;
+
+        uint32_t num_of_args = instruction_set[op_code].num_of_args;
+        if(mode >> (num_of_args * FLAGS_BITS_PER_ARG))
+            return 0;
+
+        BinInstruction* instruction = &instruction_list[i];
+        instruction->operation = op_code << 24;
+        instruction->arg_list[0] = 0;
+        instruction->arg_list[1] = 0;
+        instruction->arg_list[2] = 0;
+
+        for(uint32_t arg = 0; arg < num_of_args; arg ++){
+            uint32_t flags = (mode >> (arg * FLAGS_BITS_PER_ARG)) & ARG_FLAGS_MASK;
+            instruction->operation |= flags << ARG_FLAGS_SHIFT(arg);
+
+            stream = read_varint(stream, stream_end, &instruction->arg_list[arg]);
+            if(!stream)
+                return 0;
+        }
+    }
+
+    return (size_t)(stream - stream_begin);
+}
+
+//-------------------------------SYMBOLS-------------------------------
+
+// Deltas of sorted addresses and lines are small, zigzag keeps unsorted ones valid
+static inline uint32_t zigzag_encode(uint32_t delta){
+    return (delta << 1) ^ (uint32_t)-(int32_t)(delta >> 31);
+}
+
+static inline uint32_t zigzag_decode(uint32_t value){
+    return (value >> 1) ^ (uint32_t)-(int32_t)(value & 1);
+}
+
+static size_t symbols_encoded_size_bound(const SymbolMap* symbol_map){
+    size_t size = 2 * 5 + (size_t)symbol_map->lines_count * 2 * 5;
+    for(uint32_t i = 0; i < symbol_map->symbols_count; i ++){
+        size += 2 * 5 + symbol_map->symbol_list[i].name_size;
+    }
+    return size;
+}
+
+// Symbols section: symbols and lines counts, then symbols as address delta, name size and name,
+// then lines as address and line deltas, all numbers are LEB128
+static size_t symbols_encode(const SymbolMap* symbol_map, uint8_t* stream){
+    uint8_t* stream_begin = stream;
+
+    stream = write_varint(stream, symbol_map->symbols_count);
+    stream = write_varint(stream, symbol_map->lines_count);
+
+    uint32_t address = 0;
+    for(uint32_t i = 0; i < symbol_map->symbols_count; i ++){
+        const Symbol* symbol = &symbol_map->symbol_list[i];
+
+        stream = write_varint(stream, zigzag_encode(symbol->address - address));
+        stream = write_varint(stream, symbol->name_size);
+        memcpy(stream, symbol->name, symbol->name_size);
+        stream += symbol->name_size;
+        address = symbol->address;
+    }
+
+    address = 0;
+    uint32_t line = 0;
+    for(uint32_t i = 0; i < symbol_map->lines_count; i ++){
+        const SourceLine* source_line = &symbol_map->line_list[i];
+
+        stream = write_varint(stream, zigzag_encode(source_line->address - address));
+        stream = write_varint(stream, zigzag_encode(source_line->line - line));
+        address = source_line->address;
+        line = source_line->line;
+    }
+
+    return (size_t)(stream - stream_begin);
+}
+
+static bool symbols_decode(const uint8_t* stream, size_t stream_size, SymbolMap* symbol_map){
+    const uint8_t* stream_end = stream + stream_size;
+    uint32_t symbols_count = 0;
+    uint32_t lines_count = 0;
+
+    if(!(stream = read_varint(stream, stream_end, &symbols_count)) ||
+       !(stream = read_varint(stream, stream_end, &lines_count)))
+        return false;
+
+    uint32_t address = 0;
+    for(uint32_t i = 0; i < symbols_count; i ++){
+        uint32_t delta = 0;
+        uint32_t name_size = 0;
+        if(!(stream = read_varint(stream, stream_end, &delta)) ||
+           !(stream = read_varint(stream, stream_end, &name_size)) ||
+           name_size > (size_t)(stream_end - stream))
+            return false;
+
+        address += zigzag_decode(delta);
+        symbol_map_add_symbol(symbol_map, (const char*)stream, name_size, address);
+        stream += name_size;
+    }
+
+    // Every line takes at least two bytes
+    if(lines_count > (size_t)(stream_end - stream) / 2)
+        return false;
+    symbol_map_reserve_lines(symbol_map, lines_count);
+
+    address = 0;
+    uint32_t line = 0;
+    for(uint32_t i = 0; i < lines_count; i ++){
+        uint32_t address_delta = 0;
+        uint32_t line_delta = 0;
+        if(!(stream = read_varint(stream, stream_end, &address_delta)) ||
+           !(stream = read_varint(stream, stream_end, &line_delta)))
+            return false;
+
+        address += zigzag_decode(address_delta);
+        line += zigzag_decode(line_delta);
+        symbol_map_add_line(symbol_map, address, line);
+    }
+
+    symbol_map_sort(symbol_map);
+    return stream == stream_end;
+}
+
+//-------------------------------DETECTION-------------------------------
+
+BinaryEncoding binary_detect_encoding(const uint8_t* data, size_t size){
+    // Raw file can't start with magic: its last byte would be op code out of instruction set
+    if(size >= sizeof(ContainerHeader) && memcmp(data, CONTAINER_MAGIC, 4) == 0)
+        return ENCODING_CONTAINER;
+    if(size >= sizeof(CompactHeader) && memcmp(data, COMPACT_MAGIC, 4) == 0)
+        return ENCODING_COMPACT;
+    return ENCODING_FIXED;
+}
+
+//-------------------------------READING-------------------------------
+
+static void binary_file_error(const char* file_name, const char* message){
+    fprintf(stderr, "Error: %s is not a valid bin file: %s!\n", file_name, message);
+    abort();
+}
+
+static uint8_t* read_whole_file(const char* file_name, size_t* file_size){
+    FILE* file = fopen(file_name, "rb");
+    if(!file){
+        fprintf(stderr, "Error: Failed to open bin file %s!\n", file_name);
+        abort();
+    }
+
+    fseek(file, 0, SEEK_END);
+    *file_size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    uint8_t* data = (uint8_t*)malloc(*file_size + 1);
+    if(!data){
+        fprintf(stderr, "Error: Cannot allocate memory for bin file %s!\n", file_name);
+        abort();
+    }
+
+    size_t readed = fread(data, 1, *file_size, file);
+    fclose(file);
+
+    if(readed != *file_size){
+        fprintf(stderr, "Error: Something went wrong while reading bin file %s!\n", file_name);
+        abort();
+    }
+    return data;
+}
+
+static void code_alloc(BinInstructionArray* code, uint32_t count, const char* file_name){
+    code->count = count;
+    code->bin_instruction_list = (BinInstruction*)calloc((size_t)count + 1, sizeof(BinInstruction));
+    if(!code->bin_instruction_list){
+        fprintf(stderr, "Error: Cannot allocate memory for bin file %s!\n", file_name);
+        abort();
+    }
+}
+
+static void decode_code(BinInstructionArray* code, BinaryEncoding encoding, const uint8_t* stream, size_t stream_size,
+                        uint32_t count, const char* file_name){
+    if(encoding == ENCODING_COMPACT){
+        // Every encoded instruction takes at least two bytes
+        if(count > stream_size / 2)
+            binary_file_error(file_name, "code is truncated");
+
+        code_alloc(code, count, file_name);
+        if(compact_decode(stream, stream_size, code->bin_instruction_list, count) != stream_size)
+            binary_file_error(file_name, "code is malformed");
+    }
+    else{
+        if((size_t)count * sizeof(BinInstruction) != stream_size)
+            binary_file_error(file_name, "code size mismatch");
+
+        code_alloc(code, count, file_name);
+        memcpy(code->bin_instruction_list, stream, stream_size);
+    }
+}
+
+// Section of given kind or NULL, sections were checked to be inside file
+static const ContainerSection* find_section(const ContainerSection* section_list, uint32_t sections_count,
+                                            uint32_t kind){
+    for(uint32_t i = 0; i < sections_count; i ++){
+        if(section_list[i].kind == kind)
+            return &section_list[i];
+    }
+    return NULL;
+}
+
+static const ContainerSection* read_section_table(const uint8_t* data, size_t size, const char* file_name){
+    const ContainerHeader* header = (const ContainerHeader*)data;
+
+    if(header->version != CONTAINER_VERSION)
+        binary_file_error(file_name, "unsupported container version");
+
+    if(header->sections_count > (size - sizeof(ContainerHeader)) / sizeof(ContainerSection))
+        binary_file_error(file_name, "section table is truncated");
+
+    const ContainerSection* section_list = (const ContainerSection*)(data + sizeof(ContainerHeader));
+    for(uint32_t i = 0; i < header->sections_count; i ++){
+        if((uint64_t)section_list[i].offset + section_list[i].size > size)
+            binary_file_error(file_name, "section is out of file");
+    }
+    return section_list;
+}
+
+static void read_container(const uint8_t* data, size_t size, BinaryImage* image, const char* file_name){
+    ContainerHeader header;
+    memcpy(&header, data, sizeof(ContainerHeader));
+    const ContainerSection* section_list = read_section_table(data, size, file_name);
+
+    if(header.encoding != ENCODING_FIXED && header.encoding != ENCODING_COMPACT)
+        binary_file_error(file_name, "unknown code encoding");
+    if(header.code_size % sizeof(BinInstruction) != 0)
+        binary_file_error(file_name, "code size isn't multiple of instruction size");
+    if(header.entry_point % sizeof(BinInstruction) != 0 ||
+       (header.code_size != 0 && header.entry_point >= header.code_size))
+        binary_file_error(file_name, "entry point is out of code");
+
+    const ContainerSection* code = find_section(section_list, header.sections_count, SECTION_CODE);
+    if(!code)
+        binary_file_error(file_name, "no code section");
+
+    image->encoding = (BinaryEncoding)header.encoding;
+    image->entry_point = header.entry_point;
+    decode_code(&image->code, image->encoding, data + code->offset, code->size,
+                (uint32_t)(header.code_size / sizeof(BinInstruction)), file_name);
+
+    const ContainerSection* initial_data = find_section(section_list, header.sections_count, SECTION_DATA);
+    if(initial_data && initial_data->size != 0){
+        image->data = (uint8_t*)malloc(initial_data->size);
+        if(!image->data){
+            fprintf(stderr, "Error: Cannot allocate memory for bin file %s!\n", file_name);
+            abort();
+        }
+        memcpy(image->data, data + initial_data->offset, initial_data->size);
+        image->data_size = initial_data->size;
+    }
+
+    const ContainerSection* stack_hints = find_section(section_list, header.sections_count, SECTION_STACK_HINTS);
+    if(stack_hints){
+        if(stack_hints->size != sizeof(StackHints))
+            binary_file_error(file_name, "stack hints size mismatch");
+        memcpy(&image->stack_hints, data + stack_hints->offset, sizeof(StackHints));
+    }
+}
+
+void binary_image_init(BinaryImage* image){
+    image->encoding = ENCODING_FIXED;
+    image->entry_point = 0;
+    image->code.bin_instruction_list = NULL;
+    image->code.count = 0;
+    image->data = NULL;
+    image->data_size = 0;
+    image->stack_hints.data_stack_size = 0;
+    image->stack_hints.call_stack_size = 0;
+    image->symbol_map = NULL;
+}
+
+void binary_image_read(const char* file_name, BinaryImage* image){
+    binary_image_init(image);
+
+    size_t file_size = 0;
+    uint8_t* data = read_whole_file(file_name, &file_size);
+
+    switch(binary_detect_encoding(data, file_size)){
+        case ENCODING_CONTAINER:
+            read_container(data, file_size, image, file_name);
+            break;
+
+        case ENCODING_COMPACT:{
+            CompactHeader header;
+            memcpy(&header, data, sizeof(CompactHeader));
+
+            image->encoding = ENCODING_COMPACT;
+            decode_code(&image->code, ENCODING_COMPACT, data + sizeof(CompactHeader), file_size - sizeof(CompactHeader),
+                        header.instructions_count, file_name);
+            break;
+        }
+
+        case ENCODING_FIXED:
+            // Tail of incomplete instruction is kept zero padded
+            code_alloc(&image->code, (uint32_t)((file_size + sizeof(BinInstruction) - 1) / sizeof(BinInstruction)),
+                       file_name);
+            memcpy(image->code.bin_instruction_list, data, file_size);
+            break;
+    }
+
+    free(data);
+}
+
+void binary_image_free(BinaryImage* image){
+    free(image->code.bin_instruction_list);
+    free(image->data);
+
+    image->code.bin_instruction_list = NULL;
+    image->code.count = 0;
+    image->data = NULL;
+    image->data_size = 0;
+}
+
+void binary_read_file(const char* file_name, BinInstructionArray* bin_instructions_array){
+    BinaryImage image;
+    binary_image_read(file_name, &image);
+
+    *bin_instructions_array = image.code;
+    image.code.bin_instruction_list = NULL;
+    binary_image_free(&image);
+}
+
+bool binary_read_symbols(const char* file_name, SymbolMap* symbol_map){
+    FILE* file = fopen(file_name, "rb");
+    if(!file)
+        return false;
+
+    char magic[4] = {};
+    bool is_container = fread(magic, sizeof(magic), 1, file) == 1 && memcmp(magic, CONTAINER_MAGIC, 4) == 0;
+    fclose(file);
+
+    if(!is_container)
+        return symbol_map_read(symbol_map, file_name);
+
+    size_t file_size = 0;
+    uint8_t* data = read_whole_file(file_name, &file_size);
+    if(file_size < sizeof(ContainerHeader))
+        binary_file_error(file_name, "header is truncated");
+
+    const ContainerSection* section_list = read_section_table(data, file_size, file_name);
+    const ContainerSection* symbols = find_section(section_list, ((const ContainerHeader*)data)->sections_count,
+                                                   SECTION_SYMBOLS);
+    if(symbols && !symbols_decode(data + symbols->offset, symbols->size, symbol_map))
+        binary_file_error(file_name, "symbols are malformed");
+
+    free(data);
+    return symbols != NULL;
+}
+
+//-------------------------------WRITING-------------------------------
+
+static void binary_write_error(const char* file_name){
+    fprintf(stderr, "Error writing bin file %s!\n", file_name);
+    abort();
+}
+
+// Appends section at current end of file and fills its table entry
+static void write_section(FILE* file, ContainerSection* section, uint32_t kind, const void* data, size_t size,
+                          const char* file_name){
+    section->kind = kind;
+    section->offset = (uint32_t)ftell(file);
+    section->size = (uint32_t)size;
+
+    if(size != 0 && fwrite(data, 1, size, file) != size)
+        binary_write_error(file_name);
+}
+
+static void write_code_section(FILE* file, ContainerSection* section, const BinaryImage* image,
+                               const char* file_name){
+    const BinInstructionArray* code = &image->code;
+
+    if(image->encoding != ENCODING_COMPACT){
+        write_section(file, section, SECTION_CODE, code->bin_instruction_list, code->count * sizeof(BinInstruction),
+                      file_name);
+        return;
+    }
+
+    uint8_t* stream = (uint8_t*)malloc((size_t)code->count * COMPACT_MAX_INSTRUCTION_SIZE + 1);
+    if(!stream){
+        fprintf(stderr, "Error: Cannot allocate memory for compact bin!\n");
+        abort();
+    }
+
+    size_t stream_size = compact_encode(code->bin_instruction_list, code->count, stream);
+    write_section(file, section, SECTION_CODE, stream, stream_size, file_name);
+    free(stream);
+}
+
+void binary_image_write(const BinaryImage* image, const char* file_name){
+    if((uint64_t)image->code.count * sizeof(BinInstruction) > UINT32_MAX){
+        fprintf(stderr, "Error: Program is too large for bin file %s!\n", file_name);
+        abort();
+    }
+
+    FILE* file = fopen(file_name, "wb");
+    if(!file){
+        fprintf(stderr, "Error opening output file %s!\n", file_name);
+        abort();
+    }
+
+    ContainerHeader header;
+    memcpy(header.magic, CONTAINER_MAGIC, sizeof(header.magic));
+    header.version = CONTAINER_VERSION;
+    header.encoding = (uint16_t)image->encoding;
+    header.entry_point = image->entry_point;
+    header.code_size = image->code.count * (uint32_t)sizeof(BinInstruction);
+    header.sections_count = 0;
+
+    bool has_stack_hints = image->stack_hints.data_stack_size != 0 || image->stack_hints.call_stack_size != 0;
+
+    // Section table is written after sections, when their offsets are known
+    ContainerSection section_list[4];
+    uint32_t sections_count = 1 + (image->data_size != 0) + has_stack_hints + (image->symbol_map != NULL);
+    if(fseek(file, sizeof(ContainerHeader) + sections_count * sizeof(ContainerSection), SEEK_SET) != 0)
+        binary_write_error(file_name);
+
+    write_code_section(file, &section_list[header.sections_count ++], image, file_name);
+
+    if(image->data_size != 0)
+        write_section(file, &section_list[header.sections_count ++], SECTION_DATA, image->data, image->data_size,
+                      file_name);
+
+    if(has_stack_hints)
+        write_section(file, &section_list[header.sections_count ++], SECTION_STACK_HINTS, &image->stack_hints,
+                      sizeof(StackHints), file_name);
+
+    if(image->symbol_map){
+        uint8_t* symbols = (uint8_t*)malloc(symbols_encoded_size_bound(image->symbol_map));
+        if(!symbols){
+            fprintf(stderr, "Error: Cannot allocate memory for symbols!\n");
+            abort();
+        }
+
+        size_t symbols_size = symbols_encode(image->symbol_map, symbols);
+        write_section(file, &section_list[header.sections_count ++], SECTION_SYMBOLS, symbols, symbols_size,
+                      file_name);
+        free(symbols);
+    }
+
+    if(fseek(file, 0, SEEK_SET) != 0 ||
+       fwrite(&header, sizeof(ContainerHeader), 1, file) != 1 ||
+       fwrite(section_list, sizeof(ContainerSection), header.sections_count, file) != header.sections_count)
+        binary_write_error(file_name);
+
+    if(fclose(file) != 0)
+        binary_write_error(file_name);
+}
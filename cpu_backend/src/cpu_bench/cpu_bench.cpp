@@ -0,0 +1,407 @@
+#include "instructions/instructions.h"
+#include "exceptions/exceptions.h"
+#include "text_asm_parser/text_asm_parser.h"
+#include "assembler/assembler.h"
+#include "cpu_emulator/cpu.h"
+#include "cpu_emulator/metrics.h"
+#include "cpu_emulator/host_calls.h"
+#include "stack/stack.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+
+#define BENCH_DEFAULT_WARMUP 1
+#define BENCH_DEFAULT_REPS 5
+#define BENCH_MAX_REPS 1000
+#define BENCH_JSON_VERSION 1
+
+// Guest workloads, numbers are hexadecimal as everywhere in assembler
+typedef struct Workload{
+    const char* name;
+    const char* description;
+    const char* source;
+}Workload;
+
+static const Workload workloads[] = {
+    {
+        "branch_loop",
+        "Loop with data dependent conditional branches",
+        "mov x0 0\n"
+        "mov x1 30000\n"
+        "mov x3 0\n"
+        "mov x4 0\n"
+        ":loop\n"
+        "add x3 x3 1\n"
+        "bne x3 3 :no_reset\n"
+        "mov x3 0\n"
+        ":no_reset\n"
+        "bgt x3 1 :high\n"
+        "add x4 x4 1\n"
+        "baw :next\n"
+        ":high\n"
+        "sub x4 x4 1\n"
+        ":next\n"
+        "add x0 x0 1\n"
+        "bne x0 x1 :loop\n"
+        "hlt\n"
+    },
+    {
+        "deep_recursion",
+        "Repeated cfn recursion 512 frames deep",
+        "mov x5 0\n"
+        ":repeat\n"
+        "mov x0 200\n"
+        "cfn :down\n"
+        "add x5 x5 1\n"
+        "bne x5 4 :repeat\n"
+        "hlt\n"
+        ":down\n"
+        "beq x0 0 :bottom\n"
+        "sub x0 x0 1\n"
+        "cfn :down\n"
+        ":bottom\n"
+        "ret\n"
+    },
+    {
+        "stack_traffic",
+        "str and ldr pairs on top of data stack",
+        "mov x0 0\n"
+        ":loop\n"
+        "str x0\n"
+        "str x0\n"
+        "ldr x1\n"
+        "ldr x2\n"
+        "add x0 x0 1\n"
+        "bne x0 800 :loop\n"
+        "hlt\n"
+    },
+    {
+        "indirect_walk",
+        "Register indirect reads over 256 words of stack memory",
+        "mov x0 0\n"
+        ":fill\n"
+        "mov *x0 x0\n"
+        "add x0 x0 4\n"
+        "bne x0 400 :fill\n"
+        "mov x2 0\n"
+        "mov x3 0\n"
+        ":walk\n"
+        "mov x0 0\n"
+        ":inner\n"
+        "add x3 x3 *x0\n"
+        "add x0 x0 4\n"
+        "bne x0 400 :inner\n"
+        "add x2 x2 1\n"
+        "bne x2 200 :walk\n"
+        "hlt\n"
+    },
+    {
+        "output",
+        "out in a loop, stdout is redirected to /dev/null",
+        "mov x0 0\n"
+        ":loop\n"
+        "out x0\n"
+        "add x0 x0 1\n"
+        "bne x0 20000 :loop\n"
+        "hlt\n"
+    }
+};
+
+#define WORKLOADS_NUMBER (sizeof(workloads) / sizeof(workloads[0]))
+
+typedef struct BenchOptions{
+    uint32_t warmup;
+    uint32_t reps;
+    const char* filter;
+    const char* output_file_name;
+}BenchOptions;
+
+typedef struct BenchResult{
+    uint64_t instructions;
+    uint64_t ns[BENCH_MAX_REPS];
+    long peak_rss_kb;
+}BenchResult;
+
+//-------------------------ASSEMBLING-------------------------
+
+// Parser reads files, so source goes through temporary file
+static void assemble_workload(const Workload* workload, BinInstructionArray* bin_instructions_array){
+    char source_file_name[] = "/tmp/cpu_bench_XXXXXX";
+    int fd = mkstemp(source_file_name);
+    if(fd == -1){
+        fprintf(stderr, "Error: Cannot create temporary source file!\n");
+        abort();
+    }
+
+    size_t source_size = strlen(workload->source);
+    if(write(fd, workload->source, source_size) != (ssize_t)source_size){
+        close(fd);
+        unlink(source_file_name);
+        fprintf(stderr, "Error: Cannot write temporary source file!\n");
+        abort();
+    }
+    close(fd);
+
+    TextInstructionArray text_instructions_array;
+    LabelTable label_table;
+
+    TRY{
+        parse_text_asm_file(source_file_name, &text_instructions_array, &label_table);
+    }
+    CATCH_ALL{
+        unlink(source_file_name);
+        fprintf(stderr, "Error: Workload %s doesn't assemble!\n", workload->name);
+        parser_critical_error(&text_instructions_array, &label_table);
+    }
+    END_TRY;
+
+    unlink(source_file_name);
+
+    bin_instructions_array->count = text_instructions_array.count;
+    bin_instructions_array->bin_instruction_list = (BinInstruction*)calloc(text_instructions_array.count,
+                                                                           sizeof(BinInstruction));
+    assemble_text_instructions_array(bin_instructions_array, &text_instructions_array);
+
+    free_text_instruction_list(&text_instructions_array);
+    free_label_table(&label_table);
+}
+
+//-------------------------RUNNING-------------------------
+
+static uint64_t bench_clock_ns(){
+    struct timespec time_spec;
+    clock_gettime(CLOCK_MONOTONIC, &time_spec);
+    return (uint64_t)time_spec.tv_sec * 1000000000ull + (uint64_t)time_spec.tv_nsec;
+}
+
+// Returns execution time, cpu setup and teardown are not measured
+static uint64_t run_once(BinInstructionArray* bin_instructions_array, uint64_t* instructions){
+    Cpu cpu;
+    Stack data_stack;
+    Stack call_stack;
+
+    cpu_init(&cpu, &data_stack, &call_stack);
+    cpu.host_calls = &standard_host_calls;
+    cpu_load_program(&cpu, (const uint8_t*)bin_instructions_array->bin_instruction_list,
+                     bin_instructions_array->count * sizeof(BinInstruction));
+
+    Metrics metrics;
+    metrics_init(&metrics, false);
+
+    uint64_t start_time = bench_clock_ns();
+    cpu_execute(&cpu, &metrics);
+    uint64_t elapsed_ns = bench_clock_ns() - start_time;
+
+    MetricsSnapshot snapshot;
+    metrics_snapshot(&metrics, &cpu, &snapshot);
+    *instructions = snapshot.instructions_retired;
+
+    cpu_free(&cpu);
+    return elapsed_ns;
+}
+
+static void run_workload(const Workload* workload, BenchOptions* options, BenchResult* result){
+    BinInstructionArray bin_instructions_array;
+    assemble_workload(workload, &bin_instructions_array);
+
+    // Guest output must not get into JSON and terminal shouldn't slow it down
+    fflush(stdout);
+    int saved_stdout = dup(STDOUT_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+    if(saved_stdout == -1 || null_fd == -1){
+        fprintf(stderr, "Error: Cannot redirect stdout!\n");
+        abort();
+    }
+    dup2(null_fd, STDOUT_FILENO);
+    close(null_fd);
+
+    for(uint32_t rep = 0; rep < options->warmup; rep ++)
+        run_once(&bin_instructions_array, &result->instructions);
+
+    for(uint32_t rep = 0; rep < options->reps; rep ++)
+        result->ns[rep] = run_once(&bin_instructions_array, &result->instructions);
+
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+
+    free(bin_instructions_array.bin_instruction_list);
+}
+
+// Workload runs in child process, so its peak rss doesn't include memory of workloads run before it.
+// Result must be in shared memory to be seen by parent.
+static void run_workload_process(const Workload* workload, BenchOptions* options, BenchResult* result){
+    fflush(stdout);
+    fflush(stderr);
+
+    pid_t pid = fork();
+    if(pid == -1){
+        fprintf(stderr, "Error: Cannot fork workload process!\n");
+        abort();
+    }
+    if(pid == 0){
+        run_workload(workload, options, result);
+        _exit(0);
+    }
+
+    int status = 0;
+    struct rusage usage;
+    if(wait4(pid, &status, 0, &usage) == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0){
+        fprintf(stderr, "Error: Workload %s failed!\n", workload->name);
+        abort();
+    }
+    result->peak_rss_kb = usage.ru_maxrss;
+}
+
+//-------------------------REPORT-------------------------
+
+static int uint64_compare(const void* first, const void* second){
+    uint64_t value_1 = *(const uint64_t*)first;
+    uint64_t value_2 = *(const uint64_t*)second;
+    return value_1 < value_2 ? -1 : (value_1 > value_2 ? 1 : 0);
+}
+
+static void write_result_json(FILE* json_file, const Workload* workload, BenchResult* result, uint32_t reps,
+                              bool last){
+    qsort(result->ns, reps, sizeof(uint64_t), uint64_compare);
+
+    uint64_t min_ns = result->ns[0];
+    uint64_t median_ns = result->ns[reps / 2];
+    double instructions = (double)result->instructions;
+
+    fprintf(json_file,
+            "    {\n"
+            "      \"name\": \"%s\",\n"
+            "      \"description\": \"%s\",\n"
+            "      \"instructions\": %lu,\n"
+            "      \"reps\": %u,\n"
+            "      \"min_ns\": %lu,\n"
+            "      \"median_ns\": %lu,\n"
+            "      \"ns_per_instruction\": %.3f,\n"
+            "      \"min_ns_per_instruction\": %.3f,\n"
+            "      \"instructions_per_second\": %.1f,\n"
+            "      \"peak_rss_kb\": %ld\n"
+            "    }%s\n",
+            workload->name, workload->description, result->instructions, reps, min_ns, median_ns,
+            (double)median_ns / instructions, (double)min_ns / instructions,
+            median_ns ? instructions * 1e9 / (double)median_ns : 0.0, result->peak_rss_kb, last ? "" : ",");
+}
+
+//-------------------------OPTIONS-------------------------
+
+static void print_usage(){
+    fprintf(stderr, "Usage: cpu_bench [options]\n"
+                    "  --warmup <n>     Untimed runs before measurement (default: %d)\n"
+                    "  --reps <n>       Measured runs per workload, 1..%d (default: %d)\n"
+                    "  --filter <name>  Run only workloads which name contains given string\n"
+                    "  --output <json>  Write results to file instead of stdout\n"
+                    "  --list           Print workloads and exit\n",
+                    BENCH_DEFAULT_WARMUP, BENCH_MAX_REPS, BENCH_DEFAULT_REPS);
+}
+
+static void parse_options(int argc, char* argv[], BenchOptions* options){
+    options->warmup = BENCH_DEFAULT_WARMUP;
+    options->reps = BENCH_DEFAULT_REPS;
+    options->filter = NULL;
+    options->output_file_name = NULL;
+
+    for(int arg_count = 1; arg_count < argc; arg_count ++){
+        const char* arg = argv[arg_count];
+        bool has_value = arg_count + 1 < argc;
+
+        if(strcmp(arg, "--warmup") == 0 && has_value){
+            options->warmup = (uint32_t)strtoul(argv[++ arg_count], NULL, 10);
+        }
+        else if(strcmp(arg, "--reps") == 0 && has_value){
+            options->reps = (uint32_t)strtoul(argv[++ arg_count], NULL, 10);
+        }
+        else if(strcmp(arg, "--filter") == 0 && has_value){
+            options->filter = argv[++ arg_count];
+        }
+        else if(strcmp(arg, "--output") == 0 && has_value){
+            options->output_file_name = argv[++ arg_count];
+        }
+        else if(strcmp(arg, "--list") == 0){
+            for(size_t i = 0; i < WORKLOADS_NUMBER; i ++)
+                printf("%-16s %s\n", workloads[i].name, workloads[i].description);
+            exit(0);
+        }
+        else{
+            fprintf(stderr, "Unknown option %s!\n", arg);
+            print_usage();
+            abort();
+        }
+    }
+
+    if(options->reps == 0 || options->reps > BENCH_MAX_REPS){
+        fprintf(stderr, "Error: Number of reps must be in range 1..%d!\n", BENCH_MAX_REPS);
+        abort();
+    }
+}
+
+//-------------------------MAIN-------------------------
+
+int main(int argc, char* argv[]){
+    BenchOptions options;
+    parse_options(argc, argv, &options);
+
+    bool selected[WORKLOADS_NUMBER] = {};
+    size_t selected_count = 0;
+    for(size_t i = 0; i < WORKLOADS_NUMBER; i ++){
+        if(!options.filter || strstr(workloads[i].name, options.filter)){
+            selected[i] = true;
+            selected_count ++;
+        }
+    }
+
+    size_t results_size = WORKLOADS_NUMBER * sizeof(BenchResult);
+    BenchResult* results = (BenchResult*)mmap(NULL, results_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS,
+                                              -1, 0);
+    if(results == MAP_FAILED){
+        fprintf(stderr, "Error: Cannot allocate bench results!\n");
+        abort();
+    }
+    for(size_t i = 0; i < WORKLOADS_NUMBER; i ++){
+        if(!selected[i])
+            continue;
+
+        fprintf(stderr, "Running %s...\n", workloads[i].name);
+        run_workload_process(&workloads[i], &options, &results[i]);
+    }
+
+    FILE* json_file = stdout;
+    if(options.output_file_name){
+        json_file = fopen(options.output_file_name, "w");
+        if(!json_file){
+            fprintf(stderr, "Error opening output file %s!\n", options.output_file_name);
+            abort();
+        }
+    }
+
+    fprintf(json_file, "{\n  \"version\": %d,\n  \"warmup\": %u,\n  \"benchmarks\": [\n",
+            BENCH_JSON_VERSION, options.warmup);
+
+    size_t written = 0;
+    for(size_t i = 0; i < WORKLOADS_NUMBER; i ++){
+        if(!selected[i])
+            continue;
+
+        written ++;
+        write_result_json(json_file, &workloads[i], &results[i], options.reps, written == selected_count);
+    }
+
+    fprintf(json_file, "  ]\n}\n");
+
+    if(json_file != stdout)
+        fclose(json_file);
+
+    munmap(results, results_size);
+    return 0;
+}
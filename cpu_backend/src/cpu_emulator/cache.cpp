@@ -0,0 +1,343 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "cpu_emulator/cpu.h"
+#include "cpu_emulator/cache.h"
+#include "symbols/symbols.h"
+#include "binary_format/binary_format.h"
+
+#define CACHE_INVALID_TAG UINT64_MAX
+
+typedef struct CacheReportEntry{
+    uint32_t index;
+    uint64_t accesses;
+    uint64_t misses[CACHE_MAX_LEVELS];
+}CacheReportEntry;
+
+//-------------------------CONFIG-------------------------
+
+static bool is_power_of_two(uint64_t value){
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+static uint32_t parse_size(const char** config){
+    char* end = NULL;
+    uint64_t value = strtoull(*config, &end, 10);
+
+    if(end == *config){
+        fprintf(stderr, "Error: Expected number in cache config at \"%s\"!\n", *config);
+        abort();
+    }
+
+    if(*end == 'K' || *end == 'k'){
+        value <<= 10;
+        end ++;
+    }
+    else if(*end == 'M' || *end == 'm'){
+        value <<= 20;
+        end ++;
+    }
+
+    if(value > UINT32_MAX){
+        fprintf(stderr, "Error: Cache size is too large!\n");
+        abort();
+    }
+
+    *config = end;
+    return (uint32_t)value;
+}
+
+static void expect_char(const char** config, char expected){
+    if(**config != expected){
+        fprintf(stderr, "Error: Expected '%c' in cache config at \"%s\"!\n", expected, *config);
+        abort();
+    }
+    (*config) ++;
+}
+
+static void cache_level_init(CacheLevel* level, uint32_t size, uint32_t associativity, uint32_t line_size){
+    if(!is_power_of_two(line_size) || associativity == 0 || size % (associativity * line_size) != 0 ||
+       !is_power_of_two(size / (associativity * line_size))){
+        fprintf(stderr, "Error: Cache level %u:%u:%u must have power of two line size and number of sets!\n",
+                size, associativity, line_size);
+        abort();
+    }
+
+    level->size = size;
+    level->associativity = associativity;
+    level->line_size = line_size;
+    level->line_bits = __builtin_ctz(line_size);
+    level->sets_mask = size / (associativity * line_size) - 1;
+
+    uint32_t ways_count = size / line_size;
+    level->tags = (uint64_t*)calloc(ways_count, sizeof(uint64_t));
+    level->last_use = (uint64_t*)calloc(ways_count, sizeof(uint64_t));
+    if(!level->tags || !level->last_use){
+        fprintf(stderr, "Error: Cannot allocate cache level!\n");
+        abort();
+    }
+
+    memset(level->tags, 0xFF, ways_count * sizeof(uint64_t));
+    level->clock = 0;
+    level->hits = 0;
+    level->misses = 0;
+}
+
+void cache_simulator_init(CacheSimulator* cache, const char* config, const char* symbol_file_name){
+    cache->levels_count = 0;
+
+    const char* position = config;
+    while(*position){
+        if(cache->levels_count == CACHE_MAX_LEVELS){
+            fprintf(stderr, "Error: Cache model supports at most %d levels!\n", CACHE_MAX_LEVELS);
+            abort();
+        }
+
+        uint32_t size = parse_size(&position);
+        expect_char(&position, ':');
+        uint32_t associativity = parse_size(&position);
+        expect_char(&position, ':');
+        uint32_t line_size = parse_size(&position);
+
+        cache_level_init(&cache->levels[cache->levels_count], size, associativity, line_size);
+        cache->levels_count ++;
+
+        if(*position)
+            expect_char(&position, ',');
+    }
+
+    if(cache->levels_count == 0){
+        fprintf(stderr, "Error: Cache config has no levels!\n");
+        abort();
+    }
+
+    cache->pc_accesses = (uint64_t*)calloc(CACHE_PC_SLOTS, sizeof(uint64_t));
+    for(uint32_t level = 0; level < cache->levels_count; level ++){
+        cache->pc_misses[level] = (uint64_t*)calloc(CACHE_PC_SLOTS, sizeof(uint64_t));
+        if(!cache->pc_misses[level]){
+            fprintf(stderr, "Error: Cannot allocate cache counters!\n");
+            abort();
+        }
+    }
+    if(!cache->pc_accesses){
+        fprintf(stderr, "Error: Cannot allocate cache counters!\n");
+        abort();
+    }
+
+    symbol_map_init(&cache->symbol_map);
+    if(symbol_file_name)
+        binary_read_symbols(symbol_file_name, &cache->symbol_map);
+}
+
+void cache_simulator_free(CacheSimulator* cache){
+    for(uint32_t level = 0; level < cache->levels_count; level ++){
+        free(cache->levels[level].tags);
+        free(cache->levels[level].last_use);
+        free(cache->pc_misses[level]);
+    }
+    free(cache->pc_accesses);
+    cache->levels_count = 0;
+
+    symbol_map_free(&cache->symbol_map);
+}
+
+//-------------------------SIMULATION-------------------------
+
+// Returns true on hit, on miss line replaces least recently used way of its set
+static bool cache_level_lookup(CacheLevel* level, uint64_t address){
+    uint64_t tag = address >> level->line_bits;
+    uint32_t set = (uint32_t)tag & level->sets_mask;
+
+    uint64_t* tags = level->tags + (uint64_t)set * level->associativity;
+    uint64_t* last_use = level->last_use + (uint64_t)set * level->associativity;
+
+    level->clock ++;
+
+    uint32_t victim = 0;
+    for(uint32_t way = 0; way < level->associativity; way ++){
+        if(tags[way] == tag){
+            last_use[way] = level->clock;
+            level->hits ++;
+            return true;
+        }
+
+        if(last_use[way] < last_use[victim])
+            victim = way;
+    }
+
+    tags[victim] = tag;
+    last_use[victim] = level->clock;
+    level->misses ++;
+    return false;
+}
+
+static void cache_line_access(CacheSimulator* cache, uint32_t pc_index, uint64_t address){
+    if(pc_index < CACHE_PC_SLOTS)
+        cache->pc_accesses[pc_index] ++;
+
+    for(uint32_t level = 0; level < cache->levels_count; level ++){
+        if(cache_level_lookup(&cache->levels[level], address))
+            return;
+
+        if(pc_index < CACHE_PC_SLOTS)
+            cache->pc_misses[level][pc_index] ++;
+    }
+}
+
+void cache_simulator_access(CacheSimulator* cache, uint32_t pc, uint32_t address, uint32_t size){
+    uint32_t pc_index = pc / BIN_INSTRUCTION_SIZE;
+    uint32_t line_bits = cache->levels[0].line_bits;
+
+    uint64_t first_line = (uint64_t)address >> line_bits;
+    uint64_t last_line = ((uint64_t)address + size - 1) >> line_bits;
+
+    // Unaligned access may touch two first level lines
+    for(uint64_t line = first_line; line <= last_line; line ++)
+        cache_line_access(cache, pc_index, line << line_bits);
+}
+
+//-------------------------REPORT-------------------------
+
+static int report_entries_compare(const void* first, const void* second){
+    const CacheReportEntry* entry_1 = (const CacheReportEntry*)first;
+    const CacheReportEntry* entry_2 = (const CacheReportEntry*)second;
+
+    if(entry_1->misses[0] != entry_2->misses[0])
+        return entry_1->misses[0] > entry_2->misses[0] ? -1 : 1;
+
+    if(entry_1->accesses != entry_2->accesses)
+        return entry_1->accesses > entry_2->accesses ? -1 : 1;
+
+    return entry_1->index < entry_2->index ? -1 : 1;
+}
+
+static double percent(uint64_t part, uint64_t total){
+    return total ? 100.0 * (double)part / (double)total : 0.0;
+}
+
+static void write_entry_header(CacheSimulator* cache, FILE* report_file, const char* first_columns){
+    fprintf(report_file, "%s %14s", first_columns, "accesses");
+    for(uint32_t level = 0; level < cache->levels_count; level ++)
+        fprintf(report_file, "    L%u misses  miss%%", level + 1);
+    fprintf(report_file, "\n");
+}
+
+// Miss rate of every level is relative to accesses reaching this level
+static void write_entry_counters(CacheSimulator* cache, FILE* report_file, CacheReportEntry* entry){
+    fprintf(report_file, " %14lu", entry->accesses);
+
+    uint64_t level_accesses = entry->accesses;
+    for(uint32_t level = 0; level < cache->levels_count; level ++){
+        fprintf(report_file, " %12lu %6.2f", entry->misses[level], percent(entry->misses[level], level_accesses));
+        level_accesses = entry->misses[level];
+    }
+    fprintf(report_file, "\n");
+}
+
+static void write_levels_section(CacheSimulator* cache, FILE* report_file){
+    fprintf(report_file, "Cache levels:\n");
+    fprintf(report_file, "%-6s %10s %6s %6s %14s %14s %14s %8s\n",
+            "level", "size", "ways", "line", "accesses", "hits", "misses", "miss%");
+
+    for(uint32_t level_index = 0; level_index < cache->levels_count; level_index ++){
+        CacheLevel* level = &cache->levels[level_index];
+        uint64_t accesses = level->hits + level->misses;
+        fprintf(report_file, "L%-5u %10u %6u %6u %14lu %14lu %14lu %7.2f%%\n", level_index + 1,
+                level->size, level->associativity, level->line_size,
+                accesses, level->hits, level->misses, percent(level->misses, accesses));
+    }
+}
+
+static void write_label_section(CacheSimulator* cache, FILE* report_file){
+    SymbolMap* symbol_map = &cache->symbol_map;
+    if(symbol_map->symbols_count == 0)
+        return;
+
+    CacheReportEntry* entries = (CacheReportEntry*)calloc(symbol_map->symbols_count, sizeof(CacheReportEntry));
+    for(uint32_t i = 0; i < symbol_map->symbols_count; i ++){
+        entries[i].index = i;
+    }
+
+    // Memory accesses and misses of each level made by instruction are added to its function,
+    // which is nearest label at or before its address
+    for(uint32_t pc_index = 0; pc_index < CACHE_PC_SLOTS; pc_index ++){
+        if(cache->pc_accesses[pc_index] == 0)
+            continue;
+
+        const Symbol* symbol = symbol_map_find(symbol_map, pc_index * BIN_INSTRUCTION_SIZE);
+        if(!symbol)
+            continue;
+
+        CacheReportEntry* entry = &entries[symbol - symbol_map->symbol_list];
+        entry->accesses += cache->pc_accesses[pc_index];
+        for(uint32_t level = 0; level < cache->levels_count; level ++)
+            entry->misses[level] += cache->pc_misses[level][pc_index];
+    }
+
+    qsort(entries, symbol_map->symbols_count, sizeof(CacheReportEntry), report_entries_compare);
+
+    fprintf(report_file, "\nLabels by L1 misses:\n");
+    write_entry_header(cache, report_file, "label                           ");
+    for(uint32_t i = 0; i < symbol_map->symbols_count && entries[i].accesses != 0; i ++){
+        fprintf(report_file, ":%-31s", symbol_map->symbol_list[entries[i].index].name);
+        write_entry_counters(cache, report_file, &entries[i]);
+    }
+
+    free(entries);
+}
+
+static void write_pc_section(CacheSimulator* cache, FILE* report_file){
+    uint32_t entries_count = 0;
+    for(uint32_t pc_index = 0; pc_index < CACHE_PC_SLOTS; pc_index ++){
+        if(cache->pc_accesses[pc_index] != 0)
+            entries_count ++;
+    }
+
+    CacheReportEntry* entries = (CacheReportEntry*)calloc(entries_count + 1, sizeof(CacheReportEntry));
+    entries_count = 0;
+    for(uint32_t pc_index = 0; pc_index < CACHE_PC_SLOTS; pc_index ++){
+        if(cache->pc_accesses[pc_index] == 0)
+            continue;
+
+        CacheReportEntry* entry = &entries[entries_count ++];
+        entry->index = pc_index;
+        entry->accesses = cache->pc_accesses[pc_index];
+        for(uint32_t level = 0; level < cache->levels_count; level ++)
+            entry->misses[level] = cache->pc_misses[level][pc_index];
+    }
+
+    qsort(entries, entries_count, sizeof(CacheReportEntry), report_entries_compare);
+
+    fprintf(report_file, "\nInstructions by L1 misses:\n");
+    write_entry_header(cache, report_file, "address   label                              line");
+
+    for(uint32_t i = 0; i < entries_count; i ++){
+        uint32_t address = entries[i].index * BIN_INSTRUCTION_SIZE;
+
+        char location[64] = "";
+        const Symbol* symbol = symbol_map_find(&cache->symbol_map, address);
+        if(symbol)
+            snprintf(location, sizeof(location), ":%s+%x", symbol->name, address - symbol->address);
+
+        fprintf(report_file, "%08x  %-32s %6u", address, location, symbol_map_find_line(&cache->symbol_map, address));
+        write_entry_counters(cache, report_file, &entries[i]);
+    }
+
+    free(entries);
+}
+
+void cache_simulator_write_report(CacheSimulator* cache, const char* report_file_name){
+    FILE* report_file = fopen(report_file_name, "w");
+    if(!report_file){
+        fprintf(stderr, "Error opening cache report file %s!\n", report_file_name);
+        abort();
+    }
+
+    write_levels_section(cache, report_file);
+    write_label_section(cache, report_file);
+    write_pc_section(cache, report_file);
+
+    fclose(report_file);
+}
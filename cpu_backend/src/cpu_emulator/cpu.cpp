@@ -1,122 +1,228 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "cpu_emulator/cpu.h"
 #include "cpu_emulator/cpu_instructions.h"
+#include "cpu_emulator/spmd.h"
+#include "cpu_emulator/profiler.h"
+#include "cpu_emulator/flamegraph.h"
+#include "cpu_emulator/trace.h"
+#include "cpu_emulator/latency.h"
+#include "cpu_emulator/metrics.h"
+#include "cpu_emulator/cache.h"
+#include "cpu_emulator/timing.h"
+#include "cpu_emulator/host_calls.h"
 #include "instructions/instructions.h"
+#include "binary_format/binary_format.h"
 #include "stack/stack.h"
+#include "assembler/asm_cache.h"
 
 
-//-------------------------DEBUG-------------------------
-static void cpu_state(Cpu* cpu){
-    printf("Registers values:\n");
-    for(int i = 0; i < NUM_OF_REGISTERS - 3; i ++){
-        printf("reg %d: %x\n", i, cpu->regs[i]);
-    }
+// Tools attached to execution, NULL if not enabled
+typedef struct Instrumentation{
+    Profiler* profiler;
+    FlameSampler* flame_sampler;
+    Tracer* tracer;
+    LatencyRecorder* latency;
+    TimingModel* timing;
+    Metrics* metrics;
+}Instrumentation;
 
-    printf("Rbp: %x\n", cpu->regs[RBP]);
-    printf("Rpc: %x\n", cpu->regs[RPC]);
-    printf("Rcc: %x\n", cpu->regs[RCC]);
+// Separate loop, so execution without instrumentation doesn't pay for it
+static void cpu_execute_instrumented(Cpu* cpu, Instrumentation* instrumentation) {
+    Profiler* profiler = instrumentation->profiler;
+    FlameSampler* flame_sampler = instrumentation->flame_sampler;
+    Tracer* tracer = instrumentation->tracer;
+    LatencyRecorder* latency = instrumentation->latency;
+    TimingModel* timing = instrumentation->timing;
+    Metrics* metrics = instrumentation->metrics;
 
-    printf("\n Cpu state: %b\n", cpu->running);
-    stack_dump(cpu->data_stack);
-}
+    while(cpu->running) {
+        uint32_t pc = cpu->regs[RPC];
+        uint32_t op_code = (*(uint32_t*)(cpu->program_buffer + pc) >> 24) & 0xFF;
 
-//-------------------------CPU-------------------------
-static void load_program_data(Cpu* cpu, const char* file_name) {
-    FILE* file = fopen(file_name, "rb");
-    if (!file) {
-        cpu_critical_error(cpu, "Failed to open bin file!");
-    }
-    
-    // Get file size
-    fseek(file, 0, SEEK_END);
-    size_t file_size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-    
-    const size_t max_program_size = 16 * 65536;
-    
-    if (file_size > max_program_size) {
-        fprintf(stderr, "Error: File '%s' is too large (%ld bytes > %zu bytes max)\n",
-                file_name, file_size, max_program_size);
-        fclose(file);
-        cpu_critical_error(cpu, "Execution aborted: program exceeds maximum size!\n");
-    }
-    
-    if (file_size == 0) {
-        fprintf(stderr, "Error: File '%s' is empty!\n", file_name);
-        fclose(file);
-        cpu_critical_error(cpu, "\0");
-    }
-    
-    // Read directly into CPU buffer
-    size_t bytes_read = fread(cpu->program_buffer, 1, file_size, file);
-    
-    if (bytes_read != file_size) {
-        if (feof(file)) {
-            fprintf(stderr, "Error: Unexpected end of file!\n");
-        } else if (ferror(file)) {
-            perror("Error reading file!");
-        }
-        fclose(file);
-        cpu_critical_error(cpu, "\0");
-    }
-    
-    fclose(file);
-    
-}
+        if(tracer)
+            tracer_record(tracer, cpu, pc, op_code);
 
-static void cpu_init(Cpu* cpu, Stack* data_stack, Stack* call_stack, const char* bin_file_name){
-    // Initialize data buffer
-    cpu->program_buffer = (uint8_t*)calloc(CODE_MEM_SIZE, sizeof(uint8_t));
-    load_program_data(cpu, bin_file_name);
+        if(flame_sampler)
+            flame_sampler_tick(flame_sampler, cpu);
 
-    // Initialize stacks
-    stack_init(data_stack, DATA_STACK_INIT_SIZE, sizeof(uint8_t));
-    cpu->data_stack = data_stack;
+        uint64_t profiler_start_time = profiler ? profiler_clock() : 0;
+        uint64_t latency_start_time = latency_start(latency);
+
+        instruction_execute(cpu);
 
-    stack_init(call_stack, CALL_STACK_INIT_SIZE, sizeof(uint32_t));
-    cpu->call_stack = call_stack;
-    // Cpu state
-    cpu->running = true;
+        if(latency)
+            latency_histogram_add(&latency->op_histograms[op_code], latency_clock() - latency_start_time);
 
-    // Initialize all regs with zero values
-    for (int i = 0; i < NUM_OF_REGISTERS; i++){
-        cpu->regs[i] = 0;
+        if(profiler)
+            profiler_record(profiler, pc, op_code, profiler_clock() - profiler_start_time);
+
+        if(timing)
+            timing_model_record(timing, cpu, pc, op_code);
+
+        cpu->regs[RCC] ++;
+
+        if((cpu->regs[RCC] & METRICS_UPDATE_MASK) == 0)
+            metrics_update(metrics, cpu);
     }
 }
 
+//-------------------------OPTIONS-------------------------
 
-static void instruction_execute(Cpu* cpu){
-    uint32_t op_code = *(uint32_t*)(cpu->program_buffer + cpu->regs[RPC]);
-    op_code = (op_code >> 24) & 0xFF;
-    if(DEBUG)
-        printf("Instruction: %s\n\n", instruction_set[op_code].op_name);
+typedef struct EmulatorOptions{
+    const char* bin_file_name;
+    bool spmd;
+    const char* profile_file_name;
+    const char* symbol_file_name;
+    const char* flamegraph_file_name;
+    uint64_t sample_period;
+    const char* trace_file_name;
+    bool trace_operands;
+    bool trace_ring;
+    const char* latency_file_name;
+    const char* metrics_file_name;
+    bool metrics_shm;
+    const char* cache_file_name;
+    const char* cache_config;
+    const char* timing_file_name;
+    const char* timing_config_file_name;
+    const char* predictor_name;
+}EmulatorOptions;
 
-    instruction_set[op_code].cpu_instruction_pointer(cpu);
+static void print_usage(){
+    fprintf(stderr, "Usage: cpu_emulator [options] program.bin|program.myasm\n"
+                    "  Sources are assembled once and cached in $XDG_CACHE_HOME/" ASM_CACHE_DIR_NAME "\n"
+                    "  --spmd                Run program once per stdin line in lockstep\n"
+                    "  --profile <report>    Count executions and host time per address and opcode\n"
+                    "  --flamegraph <file>   Sample guest call chains into folded stacks file\n"
+                    "  --sample-period <n>   Instructions between call chain samples (default: %d)\n"
+                    "  --trace <file>        Write binary execution trace, see trace_decode\n"
+                    "  --trace-operands      Also trace operand values and memory addresses\n"
+                    "  --trace-ring          Keep only last %d trace records, written at exit\n"
+                    "  --latency <report>    Latency histograms per handler and memory operation\n"
+                    "  --metrics <json>      Write runtime metrics as JSON at exit\n"
+                    "  --metrics-shm         Publish runtime metrics for cpu_top while running\n"
+                    "  --cache <report>      Simulate data cache, hit and miss rates per level, label, address\n"
+                    "  --cache-levels <cfg>  Cache levels size:ways:line,... (default: %s)\n"
+                    "  --timing <report>     Model cycles with per-opcode latencies and branch prediction\n"
+                    "  --timing-config <f>   Opcode latencies and predictor parameters for --timing\n"
+                    "  --predictor <kind>    Branch predictor: static, bimodal or gshare (default)\n"
+                    "  --symbols <file>      Symbol file for reports (default: program.bin.sym)\n",
+                    FLAME_DEFAULT_SAMPLE_PERIOD, TRACE_RING_RECORDS, CACHE_DEFAULT_CONFIG);
 }
 
+static void parse_options(int argc, char* argv[], EmulatorOptions* options){
+    options->bin_file_name = NULL;
+    options->spmd = false;
+    options->profile_file_name = NULL;
+    options->symbol_file_name = NULL;
+    options->flamegraph_file_name = NULL;
+    options->sample_period = FLAME_DEFAULT_SAMPLE_PERIOD;
+    options->trace_file_name = NULL;
+    options->trace_operands = false;
+    options->trace_ring = false;
+    options->latency_file_name = NULL;
+    options->metrics_file_name = NULL;
+    options->metrics_shm = false;
+    options->cache_file_name = NULL;
+    options->cache_config = CACHE_DEFAULT_CONFIG;
+    options->timing_file_name = NULL;
+    options->timing_config_file_name = NULL;
+    options->predictor_name = NULL;
 
-static void cpu_execute(Cpu* cpu) {
-    while(cpu->running) {
-        instruction_execute(cpu);
-
-        if(DEBUG)
-            cpu_state(cpu);
+    for(int arg_count = 1; arg_count < argc; arg_count ++){
+        const char* arg = argv[arg_count];
+        bool has_value = arg_count + 1 < argc;
 
-        cpu->regs[RCC] ++;
+        if(strcmp(arg, "--spmd") == 0){
+            options->spmd = true;
+        }
+        else if(strcmp(arg, "--profile") == 0 && has_value){
+            options->profile_file_name = argv[++ arg_count];
+        }
+        else if(strcmp(arg, "--flamegraph") == 0 && has_value){
+            options->flamegraph_file_name = argv[++ arg_count];
+        }
+        else if(strcmp(arg, "--sample-period") == 0 && has_value){
+            options->sample_period = strtoull(argv[++ arg_count], NULL, 10);
+        }
+        else if(strcmp(arg, "--trace") == 0 && has_value){
+            options->trace_file_name = argv[++ arg_count];
+        }
+        else if(strcmp(arg, "--trace-operands") == 0){
+            options->trace_operands = true;
+        }
+        else if(strcmp(arg, "--trace-ring") == 0){
+            options->trace_ring = true;
+        }
+        else if(strcmp(arg, "--latency") == 0 && has_value){
+            options->latency_file_name = argv[++ arg_count];
+        }
+        else if(strcmp(arg, "--metrics") == 0 && has_value){
+            options->metrics_file_name = argv[++ arg_count];
+        }
+        else if(strcmp(arg, "--metrics-shm") == 0){
+            options->metrics_shm = true;
+        }
+        else if(strcmp(arg, "--cache") == 0 && has_value){
+            options->cache_file_name = argv[++ arg_count];
+        }
+        else if(strcmp(arg, "--cache-levels") == 0 && has_value){
+            options->cache_config = argv[++ arg_count];
+        }
+        else if(strcmp(arg, "--timing") == 0 && has_value){
+            options->timing_file_name = argv[++ arg_count];
+        }
+        else if(strcmp(arg, "--timing-config") == 0 && has_value){
+            options->timing_config_file_name = argv[++ arg_count];
+        }
+        else if(strcmp(arg, "--predictor") == 0 && has_value){
+            options->predictor_name = argv[++ arg_count];
+        }
+        else if(strcmp(arg, "--symbols") == 0 && has_value){
+            options->symbol_file_name = argv[++ arg_count];
+        }
+        else if(arg[0] != '-' && !options->bin_file_name){
+            options->bin_file_name = arg;
+        }
+        else{
+            fprintf(stderr, "Unknown option %s!\n", arg);
+            print_usage();
+            abort();
+        }
     }
-}
 
-int main(int argc,char* argv[]){
-    // Check number of args and set bin_file_name
-    if(argc != 2){
+    // Check that bin file given
+    if(!options->bin_file_name){
         fprintf(stderr, "Wrong number of args!\n");
+        print_usage();
         abort();
     }
+}
+
+//-------------------------MAIN-------------------------
+
+int main(int argc,char* argv[]){
+    EmulatorOptions options;
+    parse_options(argc, argv, &options);
 
-    const char* bin_file_name = argv[1];
+    // Sources are assembled through cache, cached bin is used as program from here on
+    char* cached_bin_file_name = NULL;
+    if(asm_cache_is_source(options.bin_file_name))
+        cached_bin_file_name = asm_cache_get(options.bin_file_name);
+
+    const char* bin_file_name = cached_bin_file_name ? cached_bin_file_name : options.bin_file_name;
+
+    // Lockstep execution of one program over many inputs
+    if(options.spmd){
+        spmd_execute_file(bin_file_name, stdin, stdout);
+        free(cached_bin_file_name);
+        return 0;
+    }
 
     // Cpu initialization
     Cpu cpu_struct;
@@ -128,13 +234,108 @@ int main(int argc,char* argv[]){
     Stack c_stk;
     Stack* call_stack = &c_stk;
 
-    cpu_init(cpu, data_stack, call_stack, bin_file_name);
+    // Whole program is read first, so everything is allocated once with sizes from its hints
+    BinaryImage image;
+    binary_image_read(bin_file_name, &image);
+    cpu_init_image(cpu, data_stack, call_stack, &image);
+    cpu->host_calls = &standard_host_calls;
+    binary_image_free(&image);
+
+    // Symbol file is searched next to bin file by default, then symbols embedded into bin are used
+    char* default_symbol_file_name = (char*)calloc(strlen(bin_file_name) + sizeof(SYMBOL_FILE_SUFFIX), sizeof(char));
+    strcpy(default_symbol_file_name, bin_file_name);
+    strcat(default_symbol_file_name, SYMBOL_FILE_SUFFIX);
+    if(access(default_symbol_file_name, F_OK) != 0)
+        strcpy(default_symbol_file_name, bin_file_name);
+
+    const char* symbol_file_name = options.symbol_file_name ? options.symbol_file_name : default_symbol_file_name;
+
+    // Metrics are always collected, options only control where they go
+    Metrics metrics;
+    metrics_init(&metrics, options.metrics_shm);
+
+    Instrumentation instrumentation = {};
+    instrumentation.metrics = &metrics;
+
+    Profiler profiler;
+    if(options.profile_file_name){
+        profiler_init(&profiler, symbol_file_name);
+        instrumentation.profiler = &profiler;
+    }
+
+    FlameSampler flame_sampler;
+    if(options.flamegraph_file_name){
+        flame_sampler_init(&flame_sampler, options.sample_period, symbol_file_name);
+        instrumentation.flame_sampler = &flame_sampler;
+    }
+
+    Tracer tracer;
+    if(options.trace_file_name){
+        tracer_init(&tracer, options.trace_file_name, !options.trace_ring, options.trace_operands);
+        instrumentation.tracer = &tracer;
+    }
+
+    if(options.latency_file_name){
+        instrumentation.latency = latency_recorder_create();
+        cpu->latency = instrumentation.latency;
+    }
+
+    TimingModel timing;
+    if(options.timing_file_name){
+        timing_model_init(&timing, options.timing_config_file_name, options.predictor_name);
+        instrumentation.timing = &timing;
+    }
+
+    // Cache model is driven from memory operations, so it works with both loops
+    CacheSimulator cache;
+    if(options.cache_file_name){
+        cache_simulator_init(&cache, options.cache_config, symbol_file_name);
+        cpu->cache = &cache;
+    }
+
+    if(instrumentation.profiler || instrumentation.flame_sampler || instrumentation.tracer || instrumentation.latency ||
+       instrumentation.timing)
+        cpu_execute_instrumented(cpu, &instrumentation);
+    else
+        cpu_execute(cpu, &metrics);
+
+    if(options.metrics_file_name)
+        metrics_write_json(&metrics, cpu, options.metrics_file_name);
+    metrics_finish(&metrics, cpu);
+
+    if(instrumentation.profiler){
+        profiler_write_report(&profiler, options.profile_file_name, cpu->program_buffer);
+        profiler_free(&profiler);
+    }
+
+    if(instrumentation.flame_sampler){
+        flame_sampler_write(&flame_sampler, options.flamegraph_file_name);
+        flame_sampler_free(&flame_sampler);
+    }
 
+    if(instrumentation.tracer)
+        tracer_finish(&tracer);
+
+    if(instrumentation.latency){
+        latency_recorder_write_report(instrumentation.latency, options.latency_file_name);
+        latency_recorder_free(instrumentation.latency);
+        cpu->latency = NULL;
+    }
+
+    if(instrumentation.timing){
+        timing_model_write_report(&timing, options.timing_file_name);
+        timing_model_free(&timing);
+    }
+
+    if(cpu->cache){
+        cache_simulator_write_report(&cache, options.cache_file_name);
+        cache_simulator_free(&cache);
+        cpu->cache = NULL;
+    }
 
-    cpu_execute(cpu);
+    free(default_symbol_file_name);
+    free(cached_bin_file_name);
 
-    free(cpu->program_buffer);
-    stack_free(cpu->data_stack);
-    stack_free(cpu->call_stack);
+    cpu_free(cpu);
     return 0;
 }
@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "cpu_emulator/cpu.h"
+#include "cpu_emulator/cpu_instructions.h"
+#include "cpu_emulator/metrics.h"
+#include "instructions/instructions.h"
+#include "binary_format/binary_format.h"
+#include "verifier/verifier.h"
+#include "stack/stack.h"
+
+
+//-------------------------DEBUG-------------------------
+static void cpu_state(Cpu* cpu){
+    printf("Registers values:\n");
+    for(int i = 0; i < NUM_OF_REGISTERS - 3; i ++){
+        printf("reg %d: %x\n", i, cpu->regs[i]);
+    }
+
+    printf("Rbp: %x\n", cpu->regs[RBP]);
+    printf("Rpc: %x\n", cpu->regs[RPC]);
+    printf("Rcc: %x\n", cpu->regs[RCC]);
+
+    printf("\n Cpu state: %b\n", cpu->running);
+    stack_dump(cpu->data_stack);
+}
+
+//-------------------------CPU-------------------------
+
+// Every execution loop gets program from here, so it runs verified program without per step checks
+void cpu_load_program(Cpu* cpu, const uint8_t* program, size_t program_size){
+    if(program_size == 0 || program_size > CODE_MEM_SIZE || program_size % BIN_INSTRUCTION_SIZE != 0){
+        fprintf(stderr, "Error: Program size %zu isn't whole number of instructions in range 1..%d bytes!\n",
+                program_size, CODE_MEM_SIZE);
+        cpu_critical_error(cpu, "Execution aborted!\n");
+    }
+
+    memcpy(cpu->program_buffer, program, program_size);
+
+    VerifierError error;
+    if(!program_verify((const BinInstruction*)cpu->program_buffer, (uint32_t)(program_size / BIN_INSTRUCTION_SIZE),
+                       &error)){
+        fprintf(stderr, "Error: Program is rejected at %08x: %s!\n", error.address, error.message);
+        abort();
+    }
+}
+
+// Hints are upper bounds, one spare element keeps stack from reallocation on reaching them
+void cpu_stacks_init(Stack* data_stack, Stack* call_stack, const BinaryImage* image){
+    size_t data_stack_size = DATA_STACK_INIT_SIZE;
+    size_t call_stack_size = CALL_STACK_INIT_SIZE;
+
+    if(image && image->stack_hints.data_stack_size != 0)
+        data_stack_size = (size_t)image->stack_hints.data_stack_size + 1;
+    if(image && image->stack_hints.call_stack_size != 0)
+        call_stack_size = (size_t)image->stack_hints.call_stack_size + 1;
+
+    if(image && image->data_size != 0){
+        if(data_stack_size <= image->data_size)
+            data_stack_size = (size_t)image->data_size + 1;
+        stack_init_from_buffer(data_stack, data_stack_size, sizeof(uint8_t), image->data, image->data_size);
+    }
+    else{
+        stack_init(data_stack, data_stack_size, sizeof(uint8_t));
+    }
+
+    stack_init(call_stack, call_stack_size, sizeof(uint32_t));
+}
+
+static void cpu_alloc(Cpu* cpu, Stack* data_stack, Stack* call_stack, const BinaryImage* image){
+    // Initialize data buffer
+    cpu->program_buffer = (uint8_t*)calloc(CODE_MEM_SIZE, sizeof(uint8_t));
+
+    // Initialize stacks
+    cpu_stacks_init(data_stack, call_stack, image);
+    cpu->data_stack = data_stack;
+    cpu->call_stack = call_stack;
+
+    // Cpu state
+    cpu->running = true;
+    cpu->latency = NULL;
+    cpu->cache = NULL;
+    cpu->host_calls = NULL;
+    cpu->vector_scratch = NULL;
+    cpu->vector_scratch_count = 0;
+
+    cpu->input_values = 0;
+    cpu->output_values = 0;
+    cpu->output_bytes = 0;
+
+    // Initialize all regs with zero values
+    for (int i = 0; i < NUM_OF_REGISTERS; i++){
+        cpu->regs[i] = 0;
+    }
+}
+
+void cpu_init(Cpu* cpu, Stack* data_stack, Stack* call_stack){
+    cpu_alloc(cpu, data_stack, call_stack, NULL);
+}
+
+void cpu_init_image(Cpu* cpu, Stack* data_stack, Stack* call_stack, const BinaryImage* image){
+    cpu_alloc(cpu, data_stack, call_stack, image);
+
+    cpu_load_program(cpu, (const uint8_t*)image->code.bin_instruction_list,
+                     image->code.count * sizeof(BinInstruction));
+    cpu->regs[RPC] = image->entry_point;
+}
+
+void cpu_free(Cpu* cpu){
+    free(cpu->program_buffer);
+    cpu->program_buffer = NULL;
+    free(cpu->vector_scratch);
+    cpu->vector_scratch = NULL;
+    stack_free(cpu->data_stack);
+    stack_free(cpu->call_stack);
+}
+
+
+void cpu_execute(Cpu* cpu, Metrics* metrics) {
+    while(cpu->running) {
+        instruction_execute(cpu);
+
+        if(DEBUG)
+            cpu_state(cpu);
+
+        cpu->regs[RCC] ++;
+
+        if((cpu->regs[RCC] & METRICS_UPDATE_MASK) == 0)
+            metrics_update(metrics, cpu);
+    }
+}
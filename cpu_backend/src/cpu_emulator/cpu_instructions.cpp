@@ -7,6 +7,10 @@
 #include "instructions/instructions.h"
 #include "cpu_emulator/cpu.h"
 #include "cpu_emulator/cpu_instructions.h"
+#include "cpu_emulator/latency.h"
+#include "cpu_emulator/cache.h"
+#include "cpu_emulator/vector_kernels.h"
+#include "cpu_emulator/host_calls.h"
 #include "stack/stack.h"
 #include "exceptions/exceptions.h"
 
@@ -14,6 +18,7 @@
 
 static void cpu_deinitialize(Cpu* cpu){
     free(cpu->program_buffer);
+    free(cpu->vector_scratch);
     stack_free(cpu->call_stack);
     stack_free(cpu->data_stack);
 }
@@ -36,9 +41,6 @@ static void parse_binary_operand(Cpu* cpu, CpuInstructionArgs* cpu_instruction_a
     int byte_position = 16 - (arg_count * 8);
     
     if (header & (1 << (byte_position + 1))) {
-        if (arg_value >= NUM_OF_REGISTERS) {
-            cpu_critical_error(cpu, "Cpu contain only %u general purpose registers! Given reg number is %u\n");
-        }
         cpu_instruction_args->cpu_imm_args[arg_count].in_reg = true;
     }
     else {
@@ -53,7 +55,7 @@ static void parse_binary_operand(Cpu* cpu, CpuInstructionArgs* cpu_instruction_a
     }
 }
 
-static void parse_instruction_operands(Cpu* cpu, CpuInstructionArgs* cpu_instruction_args, int num_of_args) {
+void parse_instruction_operands(Cpu* cpu, CpuInstructionArgs* cpu_instruction_args, int num_of_args) {
     // Read opcode from first byte
     uint32_t instruction_header = *(uint32_t*)(cpu->program_buffer + cpu->regs[RPC]);
     cpu_instruction_args->cpu_op_code = (instruction_header >> 24) & 0xFF;
@@ -66,6 +68,7 @@ static void parse_instruction_operands(Cpu* cpu, CpuInstructionArgs* cpu_instruc
 //---------------------STACK_OPERATIONS---------------------
 
 uint32_t* get_uint_from_stack(Cpu* cpu, uint32_t position){
+    uint64_t start_time = latency_start(cpu->latency);
     Stack* stack = cpu->data_stack;
     
     if(position > stack->count - sizeof(uint32_t)){
@@ -76,19 +79,22 @@ uint32_t* get_uint_from_stack(Cpu* cpu, uint32_t position){
 
     uint32_t* uint_ptr = NULL;
     TRY{
-        uint32_t* uint_ptr = (uint32_t*)stack_get_element(stack, position);
-        return uint_ptr;
+        uint_ptr = (uint32_t*)stack_get_element(stack, position);
     }
     CATCH_ALL{
         cpu_critical_error(cpu, "Error while getting uint from stack!");
-        return NULL;
     }
     END_TRY;
-    
+
+    if(cpu->cache)
+        cache_simulator_access(cpu->cache, cpu->regs[RPC], position, sizeof(uint32_t));
+
+    latency_finish_memory_op(cpu->latency, LATENCY_GET_UINT, start_time);
     return uint_ptr;
 }
 
 void write_uint_on_stack(Cpu* cpu, uint32_t position, uint32_t value){
+    uint64_t start_time = latency_start(cpu->latency);
     Stack* stack = cpu->data_stack;
     
     for(size_t byte_count = 0; byte_count < sizeof(uint32_t); byte_count ++){
@@ -100,6 +106,70 @@ void write_uint_on_stack(Cpu* cpu, uint32_t position, uint32_t value){
         }
         END_TRY;
     }
+
+    if(cpu->cache)
+        cache_simulator_access(cpu->cache, cpu->regs[RPC], position, sizeof(uint32_t));
+
+    latency_finish_memory_op(cpu->latency, LATENCY_WRITE_UINT, start_time);
+}
+
+// Words of range are read in place, range must be inside stack
+static const uint32_t* get_range_from_stack(Cpu* cpu, uint32_t position, uint64_t size){
+    uint64_t start_time = latency_start(cpu->latency);
+    Stack* stack = cpu->data_stack;
+
+    if(size > 0 && position + size > stack->count){
+        fprintf(stderr, "ERROR: range %u + %llu > count %zu\n", position, (unsigned long long)size, stack->count);
+        cpu_critical_error(cpu, "No read access to memory that out of the stack!");
+    }
+
+    // Empty range may start at end of stack, where there is no element
+    const uint32_t* range_ptr = NULL;
+    if(size > 0){
+        TRY{
+            range_ptr = (const uint32_t*)stack_get_element(stack, position);
+        }
+        CATCH_ALL{
+            cpu_critical_error(cpu, "Error while getting range from stack!");
+        }
+        END_TRY;
+    }
+
+    if(cpu->cache && size > 0)
+        cache_simulator_access(cpu->cache, cpu->regs[RPC], position, (uint32_t)size);
+
+    latency_finish_memory_op(cpu->latency, LATENCY_GET_RANGE, start_time);
+    return range_ptr;
+}
+
+// Whole range is written with one stack hash update
+static void write_range_on_stack(Cpu* cpu, uint32_t position, const void* data, uint64_t size){
+    uint64_t start_time = latency_start(cpu->latency);
+
+    TRY{
+        stack_modify_range(cpu->data_stack, data, position, size);
+    }
+    CATCH_ALL{
+        cpu_critical_error(cpu, "Error while writing range on stack!");
+    }
+    END_TRY;
+
+    if(cpu->cache && size > 0)
+        cache_simulator_access(cpu->cache, cpu->regs[RPC], position, (uint32_t)size);
+
+    latency_finish_memory_op(cpu->latency, LATENCY_WRITE_RANGE, start_time);
+}
+
+static void cpu_stack_push(Cpu* cpu, Stack* stack, void* elem){
+    uint64_t start_time = latency_start(cpu->latency);
+    stack_push(stack, elem);
+    latency_finish_memory_op(cpu->latency, LATENCY_STACK_PUSH, start_time);
+}
+
+static void cpu_stack_pop(Cpu* cpu, Stack* stack){
+    uint64_t start_time = latency_start(cpu->latency);
+    stack_pop(stack);
+    latency_finish_memory_op(cpu->latency, LATENCY_STACK_POP, start_time);
 }
 
 void pop_uint_from_stack(Cpu* cpu){
@@ -107,7 +177,7 @@ void pop_uint_from_stack(Cpu* cpu){
 
     for(size_t i = 0; i < sizeof(uint32_t); i ++){
         TRY{
-            stack_pop(stack);
+            cpu_stack_pop(cpu, stack);
         }
         CATCH_ALL{
             cpu_critical_error(cpu, "Error while popping uint from stack!");
@@ -119,21 +189,17 @@ void pop_uint_from_stack(Cpu* cpu){
 
 //---------------------RUNTIME_OPERANDS_PROCESSING---------------------
 
+// Register numbers and writability of operands are checked by verifier at load
+
 uint32_t get_runtime_operand_value(Cpu* cpu, CpuInstructionArg* cpu_instruction_arg){
     if(cpu_instruction_arg->abst_op && cpu_instruction_arg->in_reg){
         // Both flags set: indirect register addressing
         // cpu_imm_arg is a register number, whose value is an address in stack
-        if(cpu_instruction_arg->cpu_imm_arg >= NUM_OF_REGISTERS){
-            cpu_critical_error(cpu, "Cpu contain only %u general purpose registers!");
-        }
         uint32_t address = cpu->regs[cpu_instruction_arg->cpu_imm_arg];
         return *get_uint_from_stack(cpu, address);
     }
     else if(cpu_instruction_arg->in_reg){
         // Only in_reg flag: direct register access
-        if(cpu_instruction_arg->cpu_imm_arg >= NUM_OF_REGISTERS){
-            cpu_critical_error(cpu, "Cpu contain only %u general purpose registers!");
-        }
         return cpu->regs[cpu_instruction_arg->cpu_imm_arg];
     }
     else if(cpu_instruction_arg->abst_op){
@@ -146,49 +212,28 @@ uint32_t get_runtime_operand_value(Cpu* cpu, CpuInstructionArg* cpu_instruction_
     }
 }
 
-bool is_addresseble(CpuInstructionArg* cpu_instruction_arg){
-    if(!cpu_instruction_arg->abst_op && !cpu_instruction_arg->in_reg)
-        return false;
-
-    return true;
-}
-
-bool is_register(CpuInstructionArg* cpu_instruction_arg){
-    if(!cpu_instruction_arg->abst_op && cpu_instruction_arg->in_reg && cpu_instruction_arg->cpu_imm_arg < NUM_OF_REGISTERS)
-        return true;
-
-    return false;
-}
-
 void set_runtime_operand_value(Cpu* cpu, CpuInstructionArg* cpu_instruction_arg, uint32_t value){
-    if(!is_addresseble(cpu_instruction_arg)){
-        cpu_critical_error(cpu, "Arg which used as address for writing value cannot be value!\nIt must be address or stack or register!\n");
-    }
-
     if(cpu_instruction_arg->abst_op && cpu_instruction_arg->in_reg){
         // Indirect register addressing
-        uint32_t reg_num = cpu_instruction_arg->cpu_imm_arg;
-        if(reg_num >= NUM_OF_REGISTERS){
-            cpu_critical_error(cpu, "Cpu contain only %u general purpose registers!");
-        }
-        uint32_t address = cpu->regs[reg_num];
+        uint32_t address = cpu->regs[cpu_instruction_arg->cpu_imm_arg];
         write_uint_on_stack(cpu, address, value);
     }
     else if(cpu_instruction_arg->in_reg){
         // Direct register access
-        uint32_t reg_num = cpu_instruction_arg->cpu_imm_arg;
-
-        if(reg_num >= NUM_OF_REGISTERS){
-            cpu_critical_error(cpu, "Cpu contain only %u general purpose registers!");
-        }
-        cpu->regs[reg_num] = value;
+        cpu->regs[cpu_instruction_arg->cpu_imm_arg] = value;
     }
-    else if(cpu_instruction_arg->abst_op){
+    else{
         // Direct memory address
         write_uint_on_stack(cpu, cpu_instruction_arg->cpu_imm_arg, value);
     }
 }
 
+uint32_t get_runtime_operand_address(Cpu* cpu, CpuInstructionArg* cpu_instruction_arg){
+    if(cpu_instruction_arg->in_reg)
+        return cpu->regs[cpu_instruction_arg->cpu_imm_arg];
+    return cpu_instruction_arg->cpu_imm_arg;
+}
+
 //---------------------CPU_INSTRUCTIONS_IMPLEMENTATION---------------------
 
 void inp(Cpu* cpu){
@@ -198,6 +243,7 @@ void inp(Cpu* cpu){
 
     uint32_t value;
     scanf("%x", &value);
+    cpu->input_values ++;
 
     set_runtime_operand_value(cpu, &cpu_instruction_args.cpu_imm_args[0], value);
 
@@ -210,7 +256,9 @@ void out(Cpu* cpu){
     parse_instruction_operands(cpu, &cpu_instruction_args, instruction_set[1].num_of_args);
 
     uint32_t value = get_runtime_operand_value(cpu, &cpu_instruction_args.cpu_imm_args[0]);
-    printf("%x\n", value);
+    int printed = printf("%x\n", value);
+    cpu->output_values ++;
+    cpu->output_bytes += printed > 0 ? printed : 0;
 
     cpu->regs[RPC] += 16;
 }
@@ -281,7 +329,7 @@ void div(Cpu* cpu){
     uint32_t src2_value = get_runtime_operand_value(cpu, &cpu_instruction_args.cpu_imm_args[2]);
 
     if(src2_value == 0)
-        cpu_critical_error(cpu, "Division by zero!\n")
+        cpu_critical_error(cpu, "Division by zero!\n");
 
     uint32_t result = src1_value / src2_value;
 
@@ -445,7 +493,7 @@ void cfn(Cpu* cpu){
     parse_instruction_operands(cpu, &cpu_instruction_args, instruction_set[17].num_of_args);
 
     uint32_t ret_address = cpu->regs[RPC] + BIN_INSTRUCTION_SIZE;
-    stack_push(cpu->call_stack, &ret_address);
+    cpu_stack_push(cpu, cpu->call_stack, &ret_address);
     cpu->regs[RPC] = cpu_instruction_args.cpu_imm_args[0].cpu_imm_arg;
 }
 
@@ -455,9 +503,166 @@ void ret(Cpu* cpu){
     parse_instruction_operands(cpu, &cpu_instruction_args, instruction_set[17].num_of_args);
 
     cpu->regs[RPC] = *(uint32_t*)stack_get_element(cpu->call_stack, (cpu->call_stack->count - 1));
-    stack_pop(cpu->call_stack);
+    cpu_stack_pop(cpu, cpu->call_stack);
 }
 
 void hlt(Cpu* cpu){
     cpu->running = false;
 }
+
+//---------------------VECTOR_INSTRUCTIONS---------------------
+
+// Scratch buffer of cpu, which holds at least count words
+static uint32_t* vector_scratch(Cpu* cpu, uint32_t count){
+    if(count > cpu->vector_scratch_count){
+        uint32_t* new_scratch = (uint32_t*)realloc(cpu->vector_scratch, (size_t)count * sizeof(uint32_t));
+        if(!new_scratch)
+            cpu_critical_error(cpu, "Cannot allocate vector result!\n");
+
+        cpu->vector_scratch = new_scratch;
+        cpu->vector_scratch_count = count;
+    }
+    return cpu->vector_scratch;
+}
+
+typedef void (*VectorKernel)(uint32_t* result, const uint32_t* src1, const uint32_t* src2, uint32_t count);
+
+// Result is built aside, so overlapping ranges see only old words and stack is hashed once
+static void vector_elementwise(Cpu* cpu, uint32_t op_code, VectorKernel kernel){
+    CpuInstructionArgs cpu_instruction_args;
+
+    parse_instruction_operands(cpu, &cpu_instruction_args, instruction_set[op_code].num_of_args);
+
+    uint32_t dst_address = get_runtime_operand_address(cpu, &cpu_instruction_args.cpu_imm_args[0]);
+    uint32_t src_address = get_runtime_operand_address(cpu, &cpu_instruction_args.cpu_imm_args[1]);
+    uint32_t count = get_runtime_operand_value(cpu, &cpu_instruction_args.cpu_imm_args[2]);
+    uint64_t size = (uint64_t)count * sizeof(uint32_t);
+
+    const uint32_t* dst = get_range_from_stack(cpu, dst_address, size);
+    const uint32_t* src = get_range_from_stack(cpu, src_address, size);
+
+    if(count > 0){
+        uint32_t* result = vector_scratch(cpu, count);
+        kernel(result, dst, src, count);
+        write_range_on_stack(cpu, dst_address, result, size);
+    }
+
+    cpu->regs[RPC] += BIN_INSTRUCTION_SIZE;
+}
+
+void vad(Cpu* cpu){
+    vector_elementwise(cpu, OP_VAD, &vector_add);
+}
+
+void vml(Cpu* cpu){
+    vector_elementwise(cpu, OP_VML, &vector_mul);
+}
+
+void vcm(Cpu* cpu){
+    vector_elementwise(cpu, OP_VCM, &vector_compare);
+}
+
+void vsm(Cpu* cpu){
+    CpuInstructionArgs cpu_instruction_args;
+
+    parse_instruction_operands(cpu, &cpu_instruction_args, instruction_set[OP_VSM].num_of_args);
+
+    uint32_t src_address = get_runtime_operand_address(cpu, &cpu_instruction_args.cpu_imm_args[1]);
+    uint32_t count = get_runtime_operand_value(cpu, &cpu_instruction_args.cpu_imm_args[2]);
+
+    const uint32_t* src = get_range_from_stack(cpu, src_address, (uint64_t)count * sizeof(uint32_t));
+    uint32_t sum = vector_sum(src, count);
+
+    set_runtime_operand_value(cpu, &cpu_instruction_args.cpu_imm_args[0], sum);
+
+    cpu->regs[RPC] += BIN_INSTRUCTION_SIZE;
+}
+
+//---------------------BULK_MEMORY_INSTRUCTIONS---------------------
+
+// Range is written as one stack operation with one hash update, it must end inside address space
+static void check_bulk_range(Cpu* cpu, uint32_t address, uint32_t size){
+    if((uint64_t)address + size > UINT32_MAX)
+        cpu_critical_error(cpu, "Memory range is out of address space!\n");
+}
+
+void bmv(Cpu* cpu){
+    CpuInstructionArgs cpu_instruction_args;
+
+    parse_instruction_operands(cpu, &cpu_instruction_args, instruction_set[OP_BMV].num_of_args);
+
+    uint32_t dst_address = get_runtime_operand_address(cpu, &cpu_instruction_args.cpu_imm_args[0]);
+    uint32_t src_address = get_runtime_operand_address(cpu, &cpu_instruction_args.cpu_imm_args[1]);
+    uint32_t size = get_runtime_operand_value(cpu, &cpu_instruction_args.cpu_imm_args[2]);
+    check_bulk_range(cpu, dst_address, size);
+
+    uint64_t start_time = latency_start(cpu->latency);
+    if(size > 0 && (uint64_t)src_address + size > cpu->data_stack->count)
+        cpu_critical_error(cpu, "No read access to memory that out of the stack!");
+
+    TRY{
+        stack_move_range(cpu->data_stack, dst_address, src_address, size);
+    }
+    CATCH_ALL{
+        cpu_critical_error(cpu, "Error while moving range on stack!");
+    }
+    END_TRY;
+
+    if(cpu->cache && size > 0){
+        cache_simulator_access(cpu->cache, cpu->regs[RPC], src_address, size);
+        cache_simulator_access(cpu->cache, cpu->regs[RPC], dst_address, size);
+    }
+    latency_finish_memory_op(cpu->latency, LATENCY_WRITE_RANGE, start_time);
+
+    cpu->regs[RPC] += BIN_INSTRUCTION_SIZE;
+}
+
+void bfl(Cpu* cpu){
+    CpuInstructionArgs cpu_instruction_args;
+
+    parse_instruction_operands(cpu, &cpu_instruction_args, instruction_set[OP_BFL].num_of_args);
+
+    uint32_t dst_address = get_runtime_operand_address(cpu, &cpu_instruction_args.cpu_imm_args[0]);
+    uint8_t value = (uint8_t)get_runtime_operand_value(cpu, &cpu_instruction_args.cpu_imm_args[1]);
+    uint32_t size = get_runtime_operand_value(cpu, &cpu_instruction_args.cpu_imm_args[2]);
+    check_bulk_range(cpu, dst_address, size);
+
+    uint64_t start_time = latency_start(cpu->latency);
+    TRY{
+        stack_fill_range(cpu->data_stack, &value, dst_address, size);
+    }
+    CATCH_ALL{
+        cpu_critical_error(cpu, "Error while filling range on stack!");
+    }
+    END_TRY;
+
+    if(cpu->cache && size > 0)
+        cache_simulator_access(cpu->cache, cpu->regs[RPC], dst_address, size);
+    latency_finish_memory_op(cpu->latency, LATENCY_WRITE_RANGE, start_time);
+
+    cpu->regs[RPC] += BIN_INSTRUCTION_SIZE;
+}
+
+//---------------------HOST_CALLS---------------------
+
+void hcl(Cpu* cpu){
+    CpuInstructionArgs cpu_instruction_args;
+
+    parse_instruction_operands(cpu, &cpu_instruction_args, instruction_set[OP_HCL].num_of_args);
+
+    uint32_t index = get_runtime_operand_value(cpu, &cpu_instruction_args.cpu_imm_args[0]);
+    const HostCallTable* host_calls = cpu->host_calls;
+    if(!host_calls || index >= host_calls->count){
+        fprintf(stderr, "ERROR: host call %x isn't registered\n", index);
+        cpu_critical_error(cpu, "Unknown host call!\n");
+    }
+
+    const HostCall* host_call = &host_calls->call_list[index];
+    const char* error_message = host_call->function(cpu);
+    if(error_message){
+        fprintf(stderr, "ERROR: host call %s failed\n", host_call->name);
+        cpu_critical_error(cpu, error_message);
+    }
+
+    cpu->regs[RPC] += BIN_INSTRUCTION_SIZE;
+}
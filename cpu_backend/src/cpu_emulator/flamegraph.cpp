@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "cpu_emulator/cpu.h"
+#include "cpu_emulator/flamegraph.h"
+#include "instructions/instructions.h"
+#include "stack/stack.h"
+#include "symbols/symbols.h"
+#include "binary_format/binary_format.h"
+
+//-------------------------MEMORY-------------------------
+
+static void* flame_realloc(void* buffer, size_t size){
+    void* new_buffer = realloc(buffer, size);
+    if(!new_buffer){
+        fprintf(stderr, "Error: Cannot allocate flamegraph sampler buffers!\n");
+        abort();
+    }
+    return new_buffer;
+}
+
+void flame_sampler_init(FlameSampler* sampler, uint64_t sample_period, const char* symbol_file_name){
+    sampler->sample_period = sample_period ? sample_period : FLAME_DEFAULT_SAMPLE_PERIOD;
+    sampler->countdown = sampler->sample_period;
+
+    sampler->table_capacity = FLAME_TABLE_INIT_SIZE;
+    sampler->table = (uint32_t*)calloc(sampler->table_capacity, sizeof(uint32_t));
+
+    sampler->stacks_count = 0;
+    sampler->stacks_capacity = FLAME_TABLE_INIT_SIZE / 2;
+    sampler->stack_list = (FlameStack*)calloc(sampler->stacks_capacity, sizeof(FlameStack));
+
+    sampler->frames_count = 0;
+    sampler->frames_capacity = FLAME_FRAMES_INIT_SIZE;
+    sampler->frames = (uint32_t*)calloc(sampler->frames_capacity, sizeof(uint32_t));
+
+    sampler->chain_capacity = CALL_STACK_INIT_SIZE + 1;
+    sampler->chain = (uint32_t*)calloc(sampler->chain_capacity, sizeof(uint32_t));
+
+    if(!sampler->table || !sampler->stack_list || !sampler->frames || !sampler->chain){
+        fprintf(stderr, "Error: Cannot allocate flamegraph sampler buffers!\n");
+        abort();
+    }
+
+    symbol_map_init(&sampler->symbol_map);
+    if(symbol_file_name)
+        binary_read_symbols(symbol_file_name, &sampler->symbol_map);
+}
+
+void flame_sampler_free(FlameSampler* sampler){
+    free(sampler->table);
+    free(sampler->stack_list);
+    free(sampler->frames);
+    free(sampler->chain);
+    symbol_map_free(&sampler->symbol_map);
+}
+
+//-------------------------STACKS_TABLE-------------------------
+
+static uint64_t chain_hash(const uint32_t* chain, uint32_t depth){
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    for(uint32_t i = 0; i < depth; i ++){
+        hash ^= chain[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static uint32_t* find_slot(FlameSampler* sampler, uint64_t hash, const uint32_t* chain, uint32_t depth){
+    uint32_t slot = (uint32_t)hash & (sampler->table_capacity - 1);
+
+    while(sampler->table[slot] != 0){
+        FlameStack* stack = &sampler->stack_list[sampler->table[slot] - 1];
+        if(stack->hash == hash && stack->depth == depth &&
+           memcmp(&sampler->frames[stack->frames_offset], chain, depth * sizeof(uint32_t)) == 0)
+            break;
+
+        slot = (slot + 1) & (sampler->table_capacity - 1);
+    }
+    return &sampler->table[slot];
+}
+
+static void table_grow(FlameSampler* sampler){
+    free(sampler->table);
+    sampler->table_capacity *= 2;
+    sampler->table = (uint32_t*)calloc(sampler->table_capacity, sizeof(uint32_t));
+    if(!sampler->table){
+        fprintf(stderr, "Error: Cannot allocate flamegraph sampler buffers!\n");
+        abort();
+    }
+
+    // Stacks are unique, so only empty slot should be found
+    for(uint32_t i = 0; i < sampler->stacks_count; i ++){
+        uint32_t slot = (uint32_t)sampler->stack_list[i].hash & (sampler->table_capacity - 1);
+        while(sampler->table[slot] != 0){
+            slot = (slot + 1) & (sampler->table_capacity - 1);
+        }
+        sampler->table[slot] = i + 1;
+    }
+}
+
+static void add_chain(FlameSampler* sampler, const uint32_t* chain, uint32_t depth){
+    uint64_t hash = chain_hash(chain, depth);
+    uint32_t* slot = find_slot(sampler, hash, chain, depth);
+
+    if(*slot != 0){
+        sampler->stack_list[*slot - 1].samples ++;
+        return;
+    }
+
+    // New unique stack
+    if(sampler->stacks_count == sampler->stacks_capacity){
+        sampler->stacks_capacity *= 2;
+        sampler->stack_list = (FlameStack*)flame_realloc(sampler->stack_list,
+                                                         sampler->stacks_capacity * sizeof(FlameStack));
+    }
+
+    while(sampler->frames_count + depth > sampler->frames_capacity){
+        sampler->frames_capacity *= 2;
+        sampler->frames = (uint32_t*)flame_realloc(sampler->frames, sampler->frames_capacity * sizeof(uint32_t));
+    }
+
+    FlameStack* stack = &sampler->stack_list[sampler->stacks_count];
+    stack->hash = hash;
+    stack->samples = 1;
+    stack->depth = depth;
+    stack->frames_offset = sampler->frames_count;
+
+    memcpy(&sampler->frames[sampler->frames_count], chain, depth * sizeof(uint32_t));
+    sampler->frames_count += depth;
+
+    sampler->stacks_count ++;
+    *slot = sampler->stacks_count;
+
+    if(sampler->stacks_count * 2 >= sampler->table_capacity)
+        table_grow(sampler);
+}
+
+//-------------------------SAMPLING-------------------------
+
+// Frame is identified by address of label, which contains given address.
+// Code before first label is one frame, raw addresses are used only without symbols.
+static uint32_t frame_key(FlameSampler* sampler, uint32_t address){
+    if(sampler->symbol_map.symbols_count == 0)
+        return address;
+
+    const Symbol* symbol = symbol_map_find(&sampler->symbol_map, address);
+    return symbol ? symbol->address : 0;
+}
+
+void flame_sampler_sample(FlameSampler* sampler, Cpu* cpu){
+    Stack* call_stack = cpu->call_stack;
+    uint32_t depth = (uint32_t)call_stack->count + 1;
+
+    if(depth > sampler->chain_capacity){
+        sampler->chain_capacity = depth * 2;
+        sampler->chain = (uint32_t*)flame_realloc(sampler->chain, sampler->chain_capacity * sizeof(uint32_t));
+    }
+
+    // Call stack holds return addresses, call site is previous instruction
+    if(call_stack->count > 0){
+        const uint32_t* return_addresses = (const uint32_t*)stack_get_element(call_stack, 0);
+        for(uint32_t i = 0; i < call_stack->count; i ++){
+            sampler->chain[i] = frame_key(sampler, return_addresses[i] - BIN_INSTRUCTION_SIZE);
+        }
+    }
+    sampler->chain[depth - 1] = frame_key(sampler, cpu->regs[RPC]);
+
+    add_chain(sampler, sampler->chain, depth);
+}
+
+//-------------------------OUTPUT-------------------------
+
+static void write_frame(FlameSampler* sampler, FILE* folded_file, uint32_t key){
+    const Symbol* symbol = symbol_map_find(&sampler->symbol_map, key);
+    if(symbol && symbol->address == key)
+        fprintf(folded_file, "%s", symbol->name);
+    else if(sampler->symbol_map.symbols_count != 0)
+        fprintf(folded_file, "[entry]");
+    else
+        fprintf(folded_file, "0x%08x", key);
+}
+
+void flame_sampler_write(FlameSampler* sampler, const char* folded_file_name){
+    FILE* folded_file = fopen(folded_file_name, "w");
+    if(!folded_file){
+        fprintf(stderr, "Error opening flamegraph file %s!\n", folded_file_name);
+        abort();
+    }
+
+    for(uint32_t i = 0; i < sampler->stacks_count; i ++){
+        FlameStack* stack = &sampler->stack_list[i];
+        for(uint32_t frame = 0; frame < stack->depth; frame ++){
+            if(frame != 0)
+                fputc(';', folded_file);
+            write_frame(sampler, folded_file, sampler->frames[stack->frames_offset + frame]);
+        }
+        fprintf(folded_file, " %lu\n", stack->samples);
+    }
+
+    fclose(folded_file);
+}
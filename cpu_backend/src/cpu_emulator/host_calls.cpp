@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <openssl/sha.h>
+
+#include "cpu_emulator/host_calls.h"
+#include "cpu_emulator/cache.h"
+#include "stack/stack.h"
+#include "exceptions/exceptions.h"
+
+#define FNV1A_OFFSET_BASIS 0x811c9dc5u
+#define FNV1A_PRIME 0x01000193u
+
+//---------------------GUEST_MEMORY---------------------
+
+static bool range_inside_stack(Cpu* cpu, uint32_t address, uint32_t size){
+    return (uint64_t)address + size <= cpu->data_stack->count;
+}
+
+const uint8_t* host_memory_read(Cpu* cpu, uint32_t address, uint32_t size){
+    if(!range_inside_stack(cpu, address, size))
+        return NULL;
+
+    // Empty range has no element to point at, any valid pointer does
+    static const uint8_t empty_range[1] = {0};
+    if(size == 0)
+        return empty_range;
+
+    const uint8_t* volatile range = NULL;
+    TRY{
+        range = (const uint8_t*)stack_get_element(cpu->data_stack, address);
+    }
+    CATCH_ALL{
+        range = NULL;
+    }
+    END_TRY;
+
+    if(cpu->cache && range)
+        cache_simulator_access(cpu->cache, cpu->regs[RPC], address, size);
+
+    return range;
+}
+
+bool host_memory_write(Cpu* cpu, uint32_t address, const void* data, uint32_t size){
+    if(!range_inside_stack(cpu, address, size))
+        return false;
+
+    volatile bool written = true;
+    TRY{
+        stack_modify_range(cpu->data_stack, data, address, size);
+    }
+    CATCH_ALL{
+        written = false;
+    }
+    END_TRY;
+
+    if(cpu->cache && size > 0)
+        cache_simulator_access(cpu->cache, cpu->regs[RPC], address, size);
+
+    return written;
+}
+
+//---------------------STANDARD_ROUTINES---------------------
+
+static const char* host_fnv1a(Cpu* cpu){
+    uint32_t size = cpu->regs[2];
+    const uint8_t* data = host_memory_read(cpu, cpu->regs[1], size);
+    if(!data)
+        return "fnv1a input is out of the stack!\n";
+
+    uint32_t hash = FNV1A_OFFSET_BASIS;
+    for(uint32_t i = 0; i < size; i ++){
+        hash ^= data[i];
+        hash *= FNV1A_PRIME;
+    }
+
+    cpu->regs[0] = hash;
+    return NULL;
+}
+
+static const char* host_sha256(Cpu* cpu){
+    uint32_t size = cpu->regs[2];
+    const uint8_t* data = host_memory_read(cpu, cpu->regs[1], size);
+    if(!data)
+        return "sha256 input is out of the stack!\n";
+
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    SHA256(data, size, digest);
+
+    if(!host_memory_write(cpu, cpu->regs[3], digest, sizeof(digest)))
+        return "sha256 output is out of the stack!\n";
+    return NULL;
+}
+
+static int words_compare(const void* first, const void* second){
+    uint32_t word_1 = *(const uint32_t*)first;
+    uint32_t word_2 = *(const uint32_t*)second;
+
+    if(word_1 != word_2)
+        return word_1 < word_2 ? -1 : 1;
+    return 0;
+}
+
+// Words are sorted aside, so stack is hashed once
+static const char* host_sort(Cpu* cpu){
+    uint64_t size = (uint64_t)cpu->regs[2] * sizeof(uint32_t);
+    if(size > UINT32_MAX)
+        return "sort input is out of the stack!\n";
+
+    const uint8_t* data = host_memory_read(cpu, cpu->regs[1], (uint32_t)size);
+    if(!data)
+        return "sort input is out of the stack!\n";
+    if(size == 0)
+        return NULL;
+
+    uint32_t* word_list = (uint32_t*)malloc(size);
+    if(!word_list)
+        return "Cannot allocate sort buffer!\n";
+
+    memcpy(word_list, data, size);
+    qsort(word_list, cpu->regs[2], sizeof(uint32_t), words_compare);
+
+    bool written = host_memory_write(cpu, cpu->regs[1], word_list, (uint32_t)size);
+    free(word_list);
+    return written ? NULL : "sort output is out of the stack!\n";
+}
+
+static int hex_digit_value(uint8_t symbol){
+    if(symbol >= '0' && symbol <= '9')
+        return symbol - '0';
+    if(symbol >= 'a' && symbol <= 'f')
+        return symbol - 'a' + 10;
+    if(symbol >= 'A' && symbol <= 'F')
+        return symbol - 'A' + 10;
+    return -1;
+}
+
+// Parsing stops at first byte, which isn't hex digit, value wraps modulo 2^32 like guest arithmetic
+static const char* host_parse_hex(Cpu* cpu){
+    uint32_t size = cpu->regs[2];
+    const uint8_t* text = host_memory_read(cpu, cpu->regs[1], size);
+    if(!text)
+        return "parse_hex input is out of the stack!\n";
+
+    uint32_t value = 0;
+    uint32_t digits = 0;
+    for(; digits < size; digits ++){
+        int digit = hex_digit_value(text[digits]);
+        if(digit < 0)
+            break;
+        value = (value << 4) | (uint32_t)digit;
+    }
+
+    cpu->regs[0] = value;
+    cpu->regs[1] = digits;
+    return NULL;
+}
+
+static const HostCall standard_host_call_list[STANDARD_HOST_CALLS_NUMBER] = {
+    {"fnv1a",     &host_fnv1a},
+    {"sha256",    &host_sha256},
+    {"sort",      &host_sort},
+    {"parse_hex", &host_parse_hex}
+};
+
+const HostCallTable standard_host_calls = {standard_host_call_list, STANDARD_HOST_CALLS_NUMBER};
@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "cpu_emulator/latency.h"
+#include "instructions/instructions.h"
+
+static const char* const memory_op_names[LATENCY_MEMORY_OPS] = {
+    "get_uint_from_stack",
+    "write_uint_on_stack",
+    "stack_push",
+    "stack_pop",
+    "get_range_from_stack",
+    "write_range_on_stack"
+};
+
+LatencyRecorder* latency_recorder_create(){
+    LatencyRecorder* recorder = (LatencyRecorder*)calloc(1, sizeof(LatencyRecorder));
+    if(!recorder){
+        fprintf(stderr, "Error: Cannot allocate latency histograms!\n");
+        abort();
+    }
+    return recorder;
+}
+
+void latency_recorder_free(LatencyRecorder* recorder){
+    free(recorder);
+}
+
+//-------------------------REPORT-------------------------
+
+// Upper bound of values, which fall into bucket
+static uint64_t bucket_upper_bound(uint32_t bucket){
+    if(bucket < LATENCY_SUB_BUCKETS)
+        return bucket;
+
+    uint32_t msb = bucket / LATENCY_SUB_BUCKETS;
+    uint64_t sub_bucket = bucket % LATENCY_SUB_BUCKETS;
+    return ((LATENCY_SUB_BUCKETS + sub_bucket + 1) << (msb - LATENCY_SUB_BUCKETS_BITS)) - 1;
+}
+
+static uint64_t histogram_percentile(LatencyHistogram* histogram, double percentile){
+    uint64_t rank = (uint64_t)(percentile * (double)histogram->count);
+    if(rank == 0)
+        rank = 1;
+
+    uint64_t seen = 0;
+    for(uint32_t bucket = 0; bucket < LATENCY_BUCKETS; bucket ++){
+        seen += histogram->buckets[bucket];
+        if(seen >= rank){
+            uint64_t upper_bound = bucket_upper_bound(bucket);
+            return upper_bound < histogram->max ? upper_bound : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+static void write_histogram_line(FILE* report_file, const char* name, LatencyHistogram* histogram){
+    fprintf(report_file, "%-20s %14lu %12lu %12lu %12lu %12.1f\n", name, histogram->count,
+            histogram_percentile(histogram, 0.50), histogram_percentile(histogram, 0.99), histogram->max,
+            (double)histogram->sum / (double)histogram->count);
+}
+
+void latency_recorder_write_report(LatencyRecorder* recorder, const char* report_file_name){
+    FILE* report_file = fopen(report_file_name, "w");
+    if(!report_file){
+        fprintf(stderr, "Error opening latency report file %s!\n", report_file_name);
+        abort();
+    }
+
+    fprintf(report_file, "Latencies in %s\n", LATENCY_UNIT);
+
+    fprintf(report_file, "\nHandlers:\n");
+    fprintf(report_file, "%-20s %14s %12s %12s %12s %12s\n", "op", "count", "p50", "p99", "max", "mean");
+    for(uint32_t op_code = 0; op_code < LATENCY_OP_SLOTS; op_code ++){
+        LatencyHistogram* histogram = &recorder->op_histograms[op_code];
+        if(histogram->count == 0)
+            continue;
+
+        write_histogram_line(report_file, op_code < INSTRUCTIONS_SET_NUMBER ? instruction_set[op_code].op_name : "???",
+                             histogram);
+    }
+
+    fprintf(report_file, "\nMemory operations:\n");
+    fprintf(report_file, "%-20s %14s %12s %12s %12s %12s\n", "operation", "count", "p50", "p99", "max", "mean");
+    for(uint32_t memory_op = 0; memory_op < LATENCY_MEMORY_OPS; memory_op ++){
+        LatencyHistogram* histogram = &recorder->memory_histograms[memory_op];
+        if(histogram->count == 0)
+            continue;
+
+        write_histogram_line(report_file, memory_op_names[memory_op], histogram);
+    }
+
+    fclose(report_file);
+}
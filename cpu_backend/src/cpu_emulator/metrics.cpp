@@ -0,0 +1,206 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+
+#include "cpu_emulator/cpu.h"
+#include "cpu_emulator/metrics.h"
+#include "stack/stack.h"
+
+//-------------------------COLLECTING-------------------------
+
+static uint64_t metrics_clock_ns(){
+    struct timespec time_spec;
+    clock_gettime(CLOCK_MONOTONIC, &time_spec);
+    return (uint64_t)time_spec.tv_sec * 1000000000ull + (uint64_t)time_spec.tv_nsec;
+}
+
+static void collect_stack_metrics(Stack* stack, StackMetrics* stack_metrics){
+    stack_metrics->high_water = stack->max_count;
+    stack_metrics->capacity_bytes = stack->capacity;
+    stack_metrics->reallocs = stack->realloc_count;
+    stack_metrics->hash_count = stack->hash_count;
+    stack_metrics->hash_ns = stack->hash_ns;
+}
+
+static void accumulate_retired(Metrics* metrics, Cpu* cpu){
+    uint32_t rcc = cpu->regs[RCC];
+    metrics->instructions_retired += (uint32_t)(rcc - metrics->last_rcc);
+    metrics->last_rcc = rcc;
+}
+
+void metrics_snapshot(Metrics* metrics, Cpu* cpu, MetricsSnapshot* snapshot){
+    accumulate_retired(metrics, cpu);
+
+    snapshot->magic = METRICS_MAGIC;
+    snapshot->version = METRICS_VERSION;
+    snapshot->pid = getpid();
+    snapshot->running = cpu->running;
+
+    snapshot->instructions_retired = metrics->instructions_retired;
+    snapshot->elapsed_ns = metrics_clock_ns() - metrics->start_ns;
+    snapshot->instructions_per_second = snapshot->elapsed_ns ?
+        (double)snapshot->instructions_retired * 1e9 / (double)snapshot->elapsed_ns : 0.0;
+
+    collect_stack_metrics(cpu->data_stack, &snapshot->data_stack);
+    collect_stack_metrics(cpu->call_stack, &snapshot->call_stack);
+
+    snapshot->input_values = cpu->input_values;
+    snapshot->output_values = cpu->output_values;
+    snapshot->output_bytes = cpu->output_bytes;
+}
+
+//-------------------------SHARED_MEMORY-------------------------
+
+static void publish_snapshot(Metrics* metrics, Cpu* cpu){
+    MetricsSnapshot snapshot = {};
+    metrics_snapshot(metrics, cpu, &snapshot);
+
+    MetricsSnapshot* shared = metrics->shared;
+    uint64_t sequence = shared->sequence;
+
+    __atomic_store_n(&shared->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    snapshot.sequence = sequence + 1;
+    memcpy(shared, &snapshot, sizeof(MetricsSnapshot));
+
+    __atomic_store_n(&shared->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+bool metrics_read_shared(const MetricsSnapshot* shared, MetricsSnapshot* snapshot){
+    for(int attempt = 0; attempt < 1000; attempt ++){
+        uint64_t sequence = __atomic_load_n(&shared->sequence, __ATOMIC_ACQUIRE);
+        if(sequence & 1)
+            continue;
+
+        memcpy(snapshot, shared, sizeof(MetricsSnapshot));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        if(__atomic_load_n(&shared->sequence, __ATOMIC_RELAXED) == sequence)
+            return snapshot->magic == METRICS_MAGIC && snapshot->version == METRICS_VERSION;
+    }
+    return false;
+}
+
+// Name of published segment, empty if nothing is published
+static char published_shm_name[METRICS_SHM_NAME_SIZE];
+
+// Guest runtime errors end in cpu_critical_error and abort(), segment must not outlive process there too.
+// After handler returns abort() terminates process as before.
+static void unlink_on_abort(int signal_number){
+    (void)signal_number;
+    if(published_shm_name[0] != '\0')
+        shm_unlink(published_shm_name);
+}
+
+void metrics_init(Metrics* metrics, bool publish){
+    metrics->start_ns = metrics_clock_ns();
+    metrics->instructions_retired = 0;
+    metrics->last_rcc = 0;
+    metrics->shared = NULL;
+    metrics->shm_name[0] = '\0';
+
+    if(!publish)
+        return;
+
+    snprintf(metrics->shm_name, METRICS_SHM_NAME_SIZE, METRICS_SHM_PREFIX "%d", (int)getpid());
+
+    int fd = shm_open(metrics->shm_name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd == -1){
+        fprintf(stderr, "Error: Cannot create metrics shared memory segment!\n");
+        abort();
+    }
+
+    memcpy(published_shm_name, metrics->shm_name, METRICS_SHM_NAME_SIZE);
+    signal(SIGABRT, unlink_on_abort);
+
+    if(ftruncate(fd, sizeof(MetricsSnapshot)) == -1){
+        close(fd);
+        fprintf(stderr, "Error truncating metrics shared memory segment!\n");
+        abort();
+    }
+
+    void* mapped_mem = mmap(NULL, sizeof(MetricsSnapshot), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if(mapped_mem == MAP_FAILED){
+        fprintf(stderr, "Cannot map metrics shared memory segment!\n");
+        abort();
+    }
+
+    metrics->shared = (MetricsSnapshot*)mapped_mem;
+    memset(metrics->shared, 0, sizeof(MetricsSnapshot));
+}
+
+void metrics_update(Metrics* metrics, Cpu* cpu){
+    if(metrics->shared)
+        publish_snapshot(metrics, cpu);
+    else
+        accumulate_retired(metrics, cpu);
+}
+
+void metrics_finish(Metrics* metrics, Cpu* cpu){
+    if(!metrics->shared)
+        return;
+
+    publish_snapshot(metrics, cpu);
+
+    munmap(metrics->shared, sizeof(MetricsSnapshot));
+    shm_unlink(metrics->shm_name);
+    published_shm_name[0] = '\0';
+    metrics->shared = NULL;
+}
+
+//-------------------------JSON-------------------------
+
+static void write_stack_json(FILE* json_file, const char* name, const char* high_water_name,
+                             StackMetrics* stack_metrics, bool last){
+    fprintf(json_file,
+            "  \"%s\": {\n"
+            "    \"%s\": %lu,\n"
+            "    \"capacity_bytes\": %lu,\n"
+            "    \"reallocs\": %lu,\n"
+            "    \"hash_count\": %lu,\n"
+            "    \"hash_ns\": %lu\n"
+            "  }%s\n",
+            name, high_water_name, stack_metrics->high_water, stack_metrics->capacity_bytes,
+            stack_metrics->reallocs, stack_metrics->hash_count, stack_metrics->hash_ns, last ? "" : ",");
+}
+
+void metrics_write_json(Metrics* metrics, Cpu* cpu, const char* json_file_name){
+    MetricsSnapshot snapshot = {};
+    metrics_snapshot(metrics, cpu, &snapshot);
+
+    FILE* json_file = fopen(json_file_name, "w");
+    if(!json_file){
+        fprintf(stderr, "Error opening metrics file %s!\n", json_file_name);
+        abort();
+    }
+
+    fprintf(json_file,
+            "{\n"
+            "  \"instructions_retired\": %lu,\n"
+            "  \"elapsed_ns\": %lu,\n"
+            "  \"instructions_per_second\": %.1f,\n",
+            snapshot.instructions_retired, snapshot.elapsed_ns, snapshot.instructions_per_second);
+
+    write_stack_json(json_file, "data_stack", "high_water_bytes", &snapshot.data_stack, false);
+    write_stack_json(json_file, "call_stack", "high_water_entries", &snapshot.call_stack, false);
+
+    fprintf(json_file,
+            "  \"io\": {\n"
+            "    \"input_values\": %lu,\n"
+            "    \"output_values\": %lu,\n"
+            "    \"output_bytes\": %lu\n"
+            "  }\n"
+            "}\n",
+            snapshot.input_values, snapshot.output_values, snapshot.output_bytes);
+
+    fclose(json_file);
+}
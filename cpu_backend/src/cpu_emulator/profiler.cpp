@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "cpu_emulator/cpu.h"
+#include "cpu_emulator/profiler.h"
+#include "instructions/instructions.h"
+#include "symbols/symbols.h"
+#include "binary_format/binary_format.h"
+
+typedef struct ProfilerReportEntry{
+    uint32_t index;
+    ProfilerCounter counter;
+}ProfilerReportEntry;
+
+//-------------------------INIT-------------------------
+
+void profiler_init(Profiler* profiler, const char* symbol_file_name){
+    profiler->pc_counters = (ProfilerCounter*)calloc(PROFILER_PC_SLOTS, sizeof(ProfilerCounter));
+    if(!profiler->pc_counters){
+        fprintf(stderr, "Error: Cannot allocate profiler counters!\n");
+        abort();
+    }
+
+    memset(profiler->op_counters, 0, sizeof(profiler->op_counters));
+
+    symbol_map_init(&profiler->symbol_map);
+    if(symbol_file_name)
+        binary_read_symbols(symbol_file_name, &profiler->symbol_map);
+}
+
+void profiler_free(Profiler* profiler){
+    free(profiler->pc_counters);
+    profiler->pc_counters = NULL;
+    symbol_map_free(&profiler->symbol_map);
+}
+
+//-------------------------REPORT-------------------------
+
+static int report_entries_compare(const void* first, const void* second){
+    const ProfilerReportEntry* entry_1 = (const ProfilerReportEntry*)first;
+    const ProfilerReportEntry* entry_2 = (const ProfilerReportEntry*)second;
+
+    if(entry_1->counter.executions != entry_2->counter.executions)
+        return entry_1->counter.executions > entry_2->counter.executions ? -1 : 1;
+
+    if(entry_1->counter.host_ns != entry_2->counter.host_ns)
+        return entry_1->counter.host_ns > entry_2->counter.host_ns ? -1 : 1;
+
+    return entry_1->index < entry_2->index ? -1 : 1;
+}
+
+static const char* op_name(uint32_t op_code){
+    if(op_code < INSTRUCTIONS_SET_NUMBER)
+        return instruction_set[op_code].op_name;
+    return "???";
+}
+
+static double percent(uint64_t part, uint64_t total){
+    return total ? 100.0 * (double)part / (double)total : 0.0;
+}
+
+static double per_execution(ProfilerCounter* counter){
+    return counter->executions ? (double)counter->host_ns / (double)counter->executions : 0.0;
+}
+
+static void write_op_section(Profiler* profiler, FILE* report_file, ProfilerCounter* total){
+    ProfilerReportEntry entries[PROFILER_OP_SLOTS];
+    uint32_t entries_count = 0;
+
+    for(uint32_t op_code = 0; op_code < PROFILER_OP_SLOTS; op_code ++){
+        if(profiler->op_counters[op_code].executions == 0)
+            continue;
+
+        entries[entries_count].index = op_code;
+        entries[entries_count].counter = profiler->op_counters[op_code];
+        entries_count ++;
+    }
+
+    qsort(entries, entries_count, sizeof(ProfilerReportEntry), report_entries_compare);
+
+    fprintf(report_file, "\nOpcodes by executions:\n");
+    fprintf(report_file, "%-6s %14s %8s %16s %10s\n", "op", "executions", "%", "host ns", "ns/exec");
+    for(uint32_t i = 0; i < entries_count; i ++){
+        ProfilerCounter* counter = &entries[i].counter;
+        fprintf(report_file, "%-6s %14lu %7.2f%% %16lu %10.1f\n", op_name(entries[i].index),
+                counter->executions, percent(counter->executions, total->executions),
+                counter->host_ns, per_execution(counter));
+    }
+}
+
+static void write_pc_section(Profiler* profiler, FILE* report_file, ProfilerCounter* total,
+                             const uint8_t* program_buffer){
+    uint32_t entries_count = 0;
+    for(uint32_t pc_index = 0; pc_index < PROFILER_PC_SLOTS; pc_index ++){
+        if(profiler->pc_counters[pc_index].executions != 0)
+            entries_count ++;
+    }
+
+    ProfilerReportEntry* entries = (ProfilerReportEntry*)calloc(entries_count + 1, sizeof(ProfilerReportEntry));
+    entries_count = 0;
+    for(uint32_t pc_index = 0; pc_index < PROFILER_PC_SLOTS; pc_index ++){
+        if(profiler->pc_counters[pc_index].executions == 0)
+            continue;
+
+        entries[entries_count].index = pc_index;
+        entries[entries_count].counter = profiler->pc_counters[pc_index];
+        entries_count ++;
+    }
+
+    qsort(entries, entries_count, sizeof(ProfilerReportEntry), report_entries_compare);
+
+    fprintf(report_file, "\nInstructions by executions:\n");
+    fprintf(report_file, "%-8s  %-32s %6s %-6s %14s %8s %16s %10s\n",
+            "address", "label", "line", "op", "executions", "%", "host ns", "ns/exec");
+
+    for(uint32_t i = 0; i < entries_count; i ++){
+        uint32_t address = entries[i].index * BIN_INSTRUCTION_SIZE;
+        ProfilerCounter* counter = &entries[i].counter;
+
+        char location[64] = "";
+        const Symbol* symbol = symbol_map_find(&profiler->symbol_map, address);
+        if(symbol)
+            snprintf(location, sizeof(location), ":%s+%x", symbol->name, address - symbol->address);
+
+        uint32_t op_code = (*(const uint32_t*)(program_buffer + address) >> 24) & 0xFF;
+
+        fprintf(report_file, "%08x  %-32s %6u %-6s %14lu %7.2f%% %16lu %10.1f\n", address, location,
+                symbol_map_find_line(&profiler->symbol_map, address), op_name(op_code),
+                counter->executions, percent(counter->executions, total->executions),
+                counter->host_ns, per_execution(counter));
+    }
+
+    free(entries);
+}
+
+static void write_label_section(Profiler* profiler, FILE* report_file, ProfilerCounter* total){
+    SymbolMap* symbol_map = &profiler->symbol_map;
+    if(symbol_map->symbols_count == 0)
+        return;
+
+    ProfilerReportEntry* entries = (ProfilerReportEntry*)calloc(symbol_map->symbols_count, sizeof(ProfilerReportEntry));
+    for(uint32_t i = 0; i < symbol_map->symbols_count; i ++){
+        entries[i].index = i;
+    }
+
+    // Accumulate instructions counters into nearest preceding label
+    for(uint32_t pc_index = 0; pc_index < PROFILER_PC_SLOTS; pc_index ++){
+        ProfilerCounter* counter = &profiler->pc_counters[pc_index];
+        if(counter->executions == 0)
+            continue;
+
+        const Symbol* symbol = symbol_map_find(symbol_map, pc_index * BIN_INSTRUCTION_SIZE);
+        if(!symbol)
+            continue;
+
+        ProfilerReportEntry* entry = &entries[symbol - symbol_map->symbol_list];
+        entry->counter.executions += counter->executions;
+        entry->counter.host_ns += counter->host_ns;
+    }
+
+    qsort(entries, symbol_map->symbols_count, sizeof(ProfilerReportEntry), report_entries_compare);
+
+    fprintf(report_file, "\nLabels by executions:\n");
+    fprintf(report_file, "%-32s %14s %8s %16s\n", "label", "executions", "%", "host ns");
+    for(uint32_t i = 0; i < symbol_map->symbols_count && entries[i].counter.executions != 0; i ++){
+        ProfilerCounter* counter = &entries[i].counter;
+        fprintf(report_file, ":%-31s %14lu %7.2f%% %16lu\n", symbol_map->symbol_list[entries[i].index].name,
+                counter->executions, percent(counter->executions, total->executions), counter->host_ns);
+    }
+
+    free(entries);
+}
+
+void profiler_write_report(Profiler* profiler, const char* report_file_name, const uint8_t* program_buffer){
+    FILE* report_file = fopen(report_file_name, "w");
+    if(!report_file){
+        fprintf(stderr, "Error opening profile report file %s!\n", report_file_name);
+        abort();
+    }
+
+    ProfilerCounter total = {0, 0};
+    for(uint32_t op_code = 0; op_code < PROFILER_OP_SLOTS; op_code ++){
+        total.executions += profiler->op_counters[op_code].executions;
+        total.host_ns += profiler->op_counters[op_code].host_ns;
+    }
+
+    fprintf(report_file, "Instructions executed: %lu\nHost time in handlers: %lu ns\n",
+            total.executions, total.host_ns);
+
+    write_op_section(profiler, report_file, &total);
+    write_label_section(profiler, report_file, &total);
+    write_pc_section(profiler, report_file, &total, program_buffer);
+
+    fclose(report_file);
+}
@@ -0,0 +1,475 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "cpu_emulator/cpu.h"
+#include "cpu_emulator/spmd.h"
+#include "cpu_emulator/cpu_instructions.h"
+#include "cpu_emulator/host_calls.h"
+#include "instructions/instructions.h"
+#include "binary_format/binary_format.h"
+#include "stack/stack.h"
+
+//---------------------ERROR_HANDLING---------------------
+
+static void spmd_critical_error(uint32_t lane, const char* error_message){
+    fprintf(stderr, "Lane %u: %s", lane, error_message);
+    abort();
+}
+
+//---------------------LANE_IO---------------------
+
+static void lane_io_push(SpmdLaneIo* lane_io, uint32_t value){
+    if(lane_io->count == lane_io->capacity){
+        lane_io->capacity = lane_io->capacity ? lane_io->capacity * 2 : SPMD_LANE_IO_INIT_SIZE;
+        lane_io->values = (uint32_t*)realloc(lane_io->values, lane_io->capacity * sizeof(uint32_t));
+        if(!lane_io->values){
+            fprintf(stderr, "Failed to allocate lane io buffer!\n");
+            abort();
+        }
+    }
+    lane_io->values[lane_io->count ++] = value;
+}
+
+static void lane_io_reset(SpmdLaneIo* lane_io){
+    lane_io->count  = 0;
+    lane_io->cursor = 0;
+}
+
+static void lane_io_free(SpmdLaneIo* lane_io){
+    free(lane_io->values);
+    lane_io->values   = NULL;
+    lane_io->capacity = 0;
+}
+
+// Reads up to SPMD_LANES input lines, one line per program instance
+static uint32_t read_input_batch(SpmdCpu* spmd, FILE* input_file){
+    char* line_buf = NULL;
+    size_t len = 0;
+    uint32_t instances_count = 0;
+
+    while(instances_count < SPMD_LANES && getline(&line_buf, &len, input_file) != -1){
+        SpmdLaneIo* lane_input = &spmd->input[instances_count];
+        char* cursor = line_buf;
+
+        while(true){
+            char* end_of_value = NULL;
+            unsigned long value = strtoul(cursor, &end_of_value, 16);
+            if(end_of_value == cursor)
+                break;
+
+            lane_io_push(lane_input, (uint32_t)value);
+            cursor = end_of_value;
+        }
+
+        instances_count ++;
+    }
+
+    free(line_buf);
+    return instances_count;
+}
+
+static void write_output_batch(SpmdCpu* spmd, uint32_t instances_count, FILE* output_file){
+    for(uint32_t lane = 0; lane < instances_count; lane ++){
+        SpmdLaneIo* lane_output = &spmd->output[lane];
+        for(uint32_t i = 0; i < lane_output->count; i ++){
+            fprintf(output_file, i == 0 ? "%x" : " %x", lane_output->values[i]);
+        }
+        fprintf(output_file, "\n");
+    }
+}
+
+//---------------------SIMD_KERNELS---------------------
+
+// Executes mov/add/sub/mul over all lanes and stores result only in lanes from active_mask
+static void spmd_alu_kernel(uint32_t op_code, uint32_t* dst, const uint32_t* src1, const uint32_t* src2,
+                            uint32_t active_mask){
+#if defined(__AVX512F__)
+    __m512i a = _mm512_loadu_si512(src1);
+    __m512i b = _mm512_loadu_si512(src2);
+    __m512i result;
+
+    switch(op_code){
+        case OP_ADD: result = _mm512_add_epi32(a, b);   break;
+        case OP_SUB: result = _mm512_sub_epi32(a, b);   break;
+        case OP_MUL: result = _mm512_mullo_epi32(a, b); break;
+        default:     result = a;                        break;
+    }
+
+    _mm512_mask_storeu_epi32(dst, (__mmask16)active_mask, result);
+
+#elif defined(__AVX2__)
+    const __m256i lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+
+    for(int half = 0; half < SPMD_LANES / 8; half ++){
+        __m256i a = _mm256_loadu_si256((const __m256i*)(src1 + half * 8));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src2 + half * 8));
+        __m256i result;
+
+        switch(op_code){
+            case OP_ADD: result = _mm256_add_epi32(a, b);   break;
+            case OP_SUB: result = _mm256_sub_epi32(a, b);   break;
+            case OP_MUL: result = _mm256_mullo_epi32(a, b); break;
+            default:     result = a;                        break;
+        }
+
+        __m256i half_mask = _mm256_set1_epi32((int)((active_mask >> (half * 8)) & 0xFF));
+        __m256i store_mask = _mm256_cmpeq_epi32(_mm256_and_si256(half_mask, lane_bits), lane_bits);
+        _mm256_maskstore_epi32((int*)(dst + half * 8), store_mask, result);
+    }
+
+#else
+    for(uint32_t lane = 0; lane < SPMD_LANES; lane ++){
+        if(!(active_mask & (1u << lane)))
+            continue;
+
+        switch(op_code){
+            case OP_ADD: dst[lane] = src1[lane] + src2[lane]; break;
+            case OP_SUB: dst[lane] = src1[lane] - src2[lane]; break;
+            case OP_MUL: dst[lane] = src1[lane] * src2[lane]; break;
+            default:     dst[lane] = src1[lane];              break;
+        }
+    }
+#endif
+}
+
+// Returns mask of lanes, for which branch condition is true
+static uint32_t spmd_compare_kernel(uint32_t op_code, const uint32_t* src1, const uint32_t* src2){
+#if defined(__AVX512F__)
+    __m512i a = _mm512_loadu_si512(src1);
+    __m512i b = _mm512_loadu_si512(src2);
+
+    switch(op_code){
+        case OP_BNE: return _mm512_cmp_epu32_mask(a, b, _MM_CMPINT_NE);
+        case OP_BEQ: return _mm512_cmp_epu32_mask(a, b, _MM_CMPINT_EQ);
+        case OP_BGT: return _mm512_cmp_epu32_mask(a, b, _MM_CMPINT_NLE);
+        case OP_BLT: return _mm512_cmp_epu32_mask(a, b, _MM_CMPINT_LT);
+        case OP_BGE: return _mm512_cmp_epu32_mask(a, b, _MM_CMPINT_NLT);
+        case OP_BLE: return _mm512_cmp_epu32_mask(a, b, _MM_CMPINT_LE);
+        default:     return SPMD_ALL_LANES;
+    }
+
+#elif defined(__AVX2__)
+    // AVX2 has only signed compare, so sign bits are flipped before comparison
+    const __m256i sign_bit = _mm256_set1_epi32((int)0x80000000);
+    uint32_t result_mask = 0;
+
+    for(int half = 0; half < SPMD_LANES / 8; half ++){
+        __m256i a = _mm256_loadu_si256((const __m256i*)(src1 + half * 8));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src2 + half * 8));
+        __m256i a_signed = _mm256_xor_si256(a, sign_bit);
+        __m256i b_signed = _mm256_xor_si256(b, sign_bit);
+
+        __m256i equal   = _mm256_cmpeq_epi32(a, b);
+        __m256i greater = _mm256_cmpgt_epi32(a_signed, b_signed);
+        __m256i less    = _mm256_cmpgt_epi32(b_signed, a_signed);
+
+        __m256i condition;
+        switch(op_code){
+            case OP_BNE: condition = _mm256_xor_si256(equal, _mm256_set1_epi32(-1)); break;
+            case OP_BEQ: condition = equal;                                          break;
+            case OP_BGT: condition = greater;                                        break;
+            case OP_BLT: condition = less;                                           break;
+            case OP_BGE: condition = _mm256_or_si256(greater, equal);                break;
+            case OP_BLE: condition = _mm256_or_si256(less, equal);                   break;
+            default:     condition = _mm256_set1_epi32(-1);                          break;
+        }
+
+        uint32_t half_mask = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(condition));
+        result_mask |= half_mask << (half * 8);
+    }
+    return result_mask;
+
+#else
+    uint32_t result_mask = 0;
+    for(uint32_t lane = 0; lane < SPMD_LANES; lane ++){
+        bool condition;
+        switch(op_code){
+            case OP_BNE: condition = src1[lane] != src2[lane]; break;
+            case OP_BEQ: condition = src1[lane] == src2[lane]; break;
+            case OP_BGT: condition = src1[lane] >  src2[lane]; break;
+            case OP_BLT: condition = src1[lane] <  src2[lane]; break;
+            case OP_BGE: condition = src1[lane] >= src2[lane]; break;
+            case OP_BLE: condition = src1[lane] <= src2[lane]; break;
+            default:     condition = true;                     break;
+        }
+        if(condition)
+            result_mask |= 1u << lane;
+    }
+    return result_mask;
+#endif
+}
+
+//---------------------OPERANDS---------------------
+
+// Returns vector of operand values over lanes or NULL, if operand must be processed per lane
+static const uint32_t* spmd_operand_vector(SpmdCpu* spmd, uint32_t header, uint32_t arg_value, int arg_count,
+                                           uint32_t* broadcast){
+    int byte_position = 16 - (arg_count * 8);
+    bool in_reg  = header & (1 << (byte_position + 1));
+    bool abst_op = header & (1 << (byte_position + 0));
+
+    if(abst_op)
+        return NULL;
+
+    if(in_reg)
+        return spmd->regs[arg_value];
+
+    for(uint32_t lane = 0; lane < SPMD_LANES; lane ++){
+        broadcast[lane] = arg_value;
+    }
+    return broadcast;
+}
+
+// Returns destination register vector or NULL, if destination is not a plain register
+static uint32_t* spmd_destination_vector(SpmdCpu* spmd, uint32_t header, uint32_t arg_value){
+    bool in_reg  = header & (1 << 17);
+    bool abst_op = header & (1 << 16);
+
+    if(abst_op || !in_reg)
+        return NULL;
+
+    return spmd->regs[arg_value];
+}
+
+//---------------------LANES---------------------
+
+static void spmd_lane_load(SpmdCpu* spmd, uint32_t lane){
+    for(int reg = 0; reg < NUM_OF_REGISTERS; reg ++){
+        spmd->lanes[lane].regs[reg] = spmd->regs[reg][lane];
+    }
+}
+
+static void spmd_lane_store(SpmdCpu* spmd, uint32_t lane){
+    for(int reg = 0; reg < NUM_OF_REGISTERS; reg ++){
+        spmd->regs[reg][lane] = spmd->lanes[lane].regs[reg];
+    }
+
+    if(!spmd->lanes[lane].running)
+        spmd->running_mask &= ~(1u << lane);
+}
+
+static void spmd_lane_inp(SpmdCpu* spmd, uint32_t lane){
+    Cpu* lane_cpu = &spmd->lanes[lane];
+    SpmdLaneIo* lane_input = &spmd->input[lane];
+
+    if(lane_input->cursor == lane_input->count)
+        spmd_critical_error(lane, "Not enough input values for inp!\n");
+
+    CpuInstructionArgs cpu_instruction_args;
+    parse_instruction_operands(lane_cpu, &cpu_instruction_args, instruction_set[OP_INP].num_of_args);
+    set_runtime_operand_value(lane_cpu, &cpu_instruction_args.cpu_imm_args[0],
+                              lane_input->values[lane_input->cursor ++]);
+
+    lane_cpu->regs[RPC] += BIN_INSTRUCTION_SIZE;
+}
+
+static void spmd_lane_out(SpmdCpu* spmd, uint32_t lane){
+    Cpu* lane_cpu = &spmd->lanes[lane];
+
+    CpuInstructionArgs cpu_instruction_args;
+    parse_instruction_operands(lane_cpu, &cpu_instruction_args, instruction_set[OP_OUT].num_of_args);
+    lane_io_push(&spmd->output[lane], get_runtime_operand_value(lane_cpu, &cpu_instruction_args.cpu_imm_args[0]));
+
+    lane_cpu->regs[RPC] += BIN_INSTRUCTION_SIZE;
+}
+
+// Executes instruction in every active lane one by one using scalar implementation
+static void spmd_scalar_fallback(SpmdCpu* spmd, uint32_t op_code, uint32_t active_mask){
+    for(uint32_t mask = active_mask; mask != 0; mask &= mask - 1){
+        uint32_t lane = __builtin_ctz(mask);
+
+        spmd_lane_load(spmd, lane);
+
+        if(op_code == OP_INP)
+            spmd_lane_inp(spmd, lane);
+        else if(op_code == OP_OUT)
+            spmd_lane_out(spmd, lane);
+        else
+            instruction_set[op_code].cpu_instruction_pointer(&spmd->lanes[lane]);
+
+        spmd_lane_store(spmd, lane);
+    }
+}
+
+//---------------------EXECUTION---------------------
+
+static bool spmd_alu_execute(SpmdCpu* spmd, uint32_t op_code, uint32_t pc, uint32_t active_mask){
+    uint32_t* instruction = (uint32_t*)(spmd->program_buffer + pc);
+    uint32_t header = instruction[0];
+
+    alignas(64) uint32_t broadcast1[SPMD_LANES];
+    alignas(64) uint32_t broadcast2[SPMD_LANES];
+
+    uint32_t* dst = spmd_destination_vector(spmd, header, instruction[1]);
+    const uint32_t* src1 = spmd_operand_vector(spmd, header, instruction[2], 1, broadcast1);
+    const uint32_t* src2 = src1;
+    if(op_code != OP_MOV)
+        src2 = spmd_operand_vector(spmd, header, instruction[3], 2, broadcast2);
+
+    if(!dst || !src1 || !src2)
+        return false;
+
+    spmd_alu_kernel(op_code, dst, src1, src2, active_mask);
+    return true;
+}
+
+static bool spmd_branch_execute(SpmdCpu* spmd, uint32_t op_code, uint32_t pc, uint32_t active_mask){
+    uint32_t* instruction = (uint32_t*)(spmd->program_buffer + pc);
+    uint32_t header = instruction[0];
+
+    uint32_t target = instruction[1];
+    uint32_t taken_mask = active_mask;
+
+    if(op_code != OP_BAW){
+        alignas(64) uint32_t broadcast1[SPMD_LANES];
+        alignas(64) uint32_t broadcast2[SPMD_LANES];
+
+        const uint32_t* src1 = spmd_operand_vector(spmd, header, instruction[1], 0, broadcast1);
+        const uint32_t* src2 = spmd_operand_vector(spmd, header, instruction[2], 1, broadcast2);
+        if(!src1 || !src2)
+            return false;
+
+        target = instruction[3];
+        taken_mask = spmd_compare_kernel(op_code, src1, src2) & active_mask;
+    }
+
+    for(uint32_t mask = active_mask; mask != 0; mask &= mask - 1){
+        uint32_t lane = __builtin_ctz(mask);
+        spmd->regs[RPC][lane] = (taken_mask & (1u << lane)) ? target : pc + BIN_INSTRUCTION_SIZE;
+    }
+    return true;
+}
+
+static void spmd_step(SpmdCpu* spmd){
+    // Lanes with the lowest pc go first, so diverged lanes reconverge as soon as possible
+    uint32_t pc = UINT32_MAX;
+    for(uint32_t mask = spmd->running_mask; mask != 0; mask &= mask - 1){
+        uint32_t lane = __builtin_ctz(mask);
+        if(spmd->regs[RPC][lane] < pc)
+            pc = spmd->regs[RPC][lane];
+    }
+
+    uint32_t active_mask = 0;
+    for(uint32_t mask = spmd->running_mask; mask != 0; mask &= mask - 1){
+        uint32_t lane = __builtin_ctz(mask);
+        if(spmd->regs[RPC][lane] == pc)
+            active_mask |= 1u << lane;
+    }
+
+    // Program is verified at load, so pc and op code are always valid
+    uint32_t op_code = (*(uint32_t*)(spmd->program_buffer + pc) >> 24) & 0xFF;
+
+    bool vectorized = false;
+    switch(op_code){
+        case OP_MOV:
+        case OP_ADD:
+        case OP_SUB:
+        case OP_MUL:
+            vectorized = spmd_alu_execute(spmd, op_code, pc, active_mask);
+            if(vectorized){
+                for(uint32_t mask = active_mask; mask != 0; mask &= mask - 1){
+                    spmd->regs[RPC][__builtin_ctz(mask)] += BIN_INSTRUCTION_SIZE;
+                }
+            }
+            break;
+
+        case OP_BNE:
+        case OP_BEQ:
+        case OP_BGT:
+        case OP_BLT:
+        case OP_BGE:
+        case OP_BLE:
+        case OP_BAW:
+            vectorized = spmd_branch_execute(spmd, op_code, pc, active_mask);
+            break;
+
+        case OP_HLT:
+            spmd->running_mask &= ~active_mask;
+            vectorized = true;
+            break;
+
+        default:
+            break;
+    }
+
+    if(!vectorized)
+        spmd_scalar_fallback(spmd, op_code, active_mask);
+
+    for(uint32_t mask = active_mask; mask != 0; mask &= mask - 1){
+        spmd->regs[RCC][__builtin_ctz(mask)] ++;
+    }
+}
+
+static void spmd_batch_init(SpmdCpu* spmd, uint32_t instances_count, const BinaryImage* image){
+    spmd->running_mask = (instances_count == SPMD_LANES) ? SPMD_ALL_LANES : ((1u << instances_count) - 1);
+    memset(spmd->regs, 0, sizeof(spmd->regs));
+
+    for(uint32_t lane = 0; lane < SPMD_LANES; lane ++){
+        Cpu* lane_cpu = &spmd->lanes[lane];
+
+        cpu_stacks_init(&spmd->data_stacks[lane], &spmd->call_stacks[lane], image);
+        spmd->regs[RPC][lane] = image->entry_point;
+
+        lane_cpu->program_buffer = spmd->program_buffer;
+        lane_cpu->data_stack = &spmd->data_stacks[lane];
+        lane_cpu->call_stack = &spmd->call_stacks[lane];
+        lane_cpu->running = true;
+        lane_cpu->error_code = 0;
+        lane_cpu->host_calls = &standard_host_calls;
+    }
+}
+
+static void spmd_batch_deinit(SpmdCpu* spmd){
+    for(uint32_t lane = 0; lane < SPMD_LANES; lane ++){
+        stack_free(&spmd->data_stacks[lane]);
+        stack_free(&spmd->call_stacks[lane]);
+
+        lane_io_reset(&spmd->input[lane]);
+        lane_io_reset(&spmd->output[lane]);
+    }
+}
+
+void spmd_execute_file(const char* bin_file_name, FILE* input_file, FILE* output_file){
+    SpmdCpu* spmd = NULL;
+    if(posix_memalign((void**)&spmd, 64, sizeof(SpmdCpu)) != 0){
+        fprintf(stderr, "Failed to allocate SPMD cpu!\n");
+        abort();
+    }
+    memset(spmd, 0, sizeof(SpmdCpu));
+
+    // Program is loaded once and shared by all lanes
+    spmd->program_buffer = (uint8_t*)calloc(CODE_MEM_SIZE, sizeof(uint8_t));
+    spmd->lanes[0].program_buffer = spmd->program_buffer;
+
+    BinaryImage image;
+    binary_image_read(bin_file_name, &image);
+    cpu_load_program(&spmd->lanes[0], (const uint8_t*)image.code.bin_instruction_list,
+                     image.code.count * sizeof(BinInstruction));
+
+    uint32_t instances_count = 0;
+    while((instances_count = read_input_batch(spmd, input_file)) != 0){
+        spmd_batch_init(spmd, instances_count, &image);
+
+        while(spmd->running_mask)
+            spmd_step(spmd);
+
+        write_output_batch(spmd, instances_count, output_file);
+        spmd_batch_deinit(spmd);
+    }
+
+    for(uint32_t lane = 0; lane < SPMD_LANES; lane ++){
+        lane_io_free(&spmd->input[lane]);
+        lane_io_free(&spmd->output[lane]);
+        free(spmd->lanes[lane].vector_scratch);
+    }
+
+    binary_image_free(&image);
+    free(spmd->program_buffer);
+    free(spmd);
+}
@@ -0,0 +1,270 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "cpu_emulator/cpu.h"
+#include "cpu_emulator/timing.h"
+#include "instructions/instructions.h"
+
+#define TIMING_CONFIG_LINE_SIZE 256
+
+static const char* const predictor_names[] = {
+    "static",
+    "bimodal",
+    "gshare"
+};
+
+//-------------------------CONFIG-------------------------
+
+static void set_default_latencies(TimingModel* timing){
+    for(uint32_t op_code = 0; op_code < TIMING_OP_SLOTS; op_code ++)
+        timing->op_latency[op_code] = 1;
+
+    timing->op_latency[OP_MUL] = 3;
+    timing->op_latency[OP_DIV] = 20;
+    timing->op_latency[OP_SQR] = 15;
+    timing->op_latency[OP_STR] = 2;
+    timing->op_latency[OP_LDR] = 2;
+    timing->op_latency[OP_CFN] = 2;
+    timing->op_latency[OP_RET] = 2;
+    timing->op_latency[OP_VAD] = 4;
+    timing->op_latency[OP_VML] = 6;
+    timing->op_latency[OP_VCM] = 4;
+    timing->op_latency[OP_VSM] = 4;
+    timing->op_latency[OP_BMV] = 4;
+    timing->op_latency[OP_BFL] = 4;
+    timing->op_latency[OP_HCL] = 20;
+}
+
+static PredictorKind parse_predictor(const char* predictor_name){
+    for(uint32_t kind = 0; kind < sizeof(predictor_names) / sizeof(predictor_names[0]); kind ++){
+        if(strcmp(predictor_name, predictor_names[kind]) == 0)
+            return (PredictorKind)kind;
+    }
+
+    fprintf(stderr, "Error: Unknown branch predictor %s, expected static, bimodal or gshare!\n", predictor_name);
+    abort();
+}
+
+static int find_op_code(const char* op_name){
+    for(int op_code = 0; op_code < INSTRUCTIONS_SET_NUMBER; op_code ++){
+        if(strcmp(op_name, instruction_set[op_code].op_name) == 0)
+            return op_code;
+    }
+    return -1;
+}
+
+static void read_config_file(TimingModel* timing, const char* config_file_name){
+    FILE* config_file = fopen(config_file_name, "r");
+    if(!config_file){
+        fprintf(stderr, "Error opening timing config %s!\n", config_file_name);
+        abort();
+    }
+
+    char line[TIMING_CONFIG_LINE_SIZE];
+    uint32_t line_number = 0;
+    while(fgets(line, sizeof(line), config_file)){
+        line_number ++;
+
+        char* comment = strchr(line, '#');
+        if(comment)
+            *comment = '\0';
+
+        char key[64] = "";
+        char value[64] = "";
+        int fields = sscanf(line, "%63s %63s", key, value);
+        if(fields <= 0)
+            continue;
+
+        if(fields != 2){
+            fprintf(stderr, "Error: %s:%u: expected \"<key> <value>\"!\n", config_file_name, line_number);
+            abort();
+        }
+
+        if(strcmp(key, "predictor") == 0){
+            timing->predictor = parse_predictor(value);
+            continue;
+        }
+
+        uint32_t number = (uint32_t)strtoul(value, NULL, 10);
+        int op_code = find_op_code(key);
+
+        if(op_code >= 0)
+            timing->op_latency[op_code] = number;
+        else if(strcmp(key, "mispredict_penalty") == 0)
+            timing->mispredict_penalty = number;
+        else if(strcmp(key, "table_bits") == 0)
+            timing->table_bits = number;
+        else if(strcmp(key, "ras_depth") == 0)
+            timing->ras_depth = number;
+        else{
+            fprintf(stderr, "Error: %s:%u: unknown key %s!\n", config_file_name, line_number, key);
+            abort();
+        }
+    }
+
+    fclose(config_file);
+}
+
+void timing_model_init(TimingModel* timing, const char* config_file_name, const char* predictor_name){
+    memset(timing, 0, sizeof(TimingModel));
+
+    set_default_latencies(timing);
+    timing->mispredict_penalty = TIMING_DEFAULT_MISPREDICT_PENALTY;
+    timing->predictor = PREDICTOR_GSHARE;
+    timing->table_bits = TIMING_DEFAULT_TABLE_BITS;
+    timing->ras_depth = TIMING_DEFAULT_RAS_DEPTH;
+
+    if(config_file_name)
+        read_config_file(timing, config_file_name);
+
+    if(predictor_name)
+        timing->predictor = parse_predictor(predictor_name);
+
+    if(timing->table_bits == 0 || timing->table_bits > TIMING_MAX_TABLE_BITS){
+        fprintf(stderr, "Error: table_bits must be in range 1..%d!\n", TIMING_MAX_TABLE_BITS);
+        abort();
+    }
+
+    if(timing->ras_depth == 0 || timing->ras_depth > TIMING_MAX_RAS_DEPTH){
+        fprintf(stderr, "Error: ras_depth must be in range 1..%d!\n", TIMING_MAX_RAS_DEPTH);
+        abort();
+    }
+
+    // Counters start weakly taken
+    timing->counters = (uint8_t*)malloc(1u << timing->table_bits);
+    if(!timing->counters){
+        fprintf(stderr, "Error: Cannot allocate branch predictor table!\n");
+        abort();
+    }
+    memset(timing->counters, 2, 1u << timing->table_bits);
+}
+
+void timing_model_free(TimingModel* timing){
+    free(timing->counters);
+    timing->counters = NULL;
+}
+
+//-------------------------MODEL-------------------------
+
+static bool predict_and_update(TimingModel* timing, uint32_t pc, uint32_t target, bool taken){
+    if(timing->predictor == PREDICTOR_STATIC)
+        return target <= pc;
+
+    uint32_t table_mask = (1u << timing->table_bits) - 1;
+    uint32_t index = pc / BIN_INSTRUCTION_SIZE;
+    if(timing->predictor == PREDICTOR_GSHARE)
+        index ^= timing->history;
+    index &= table_mask;
+
+    uint8_t* counter = &timing->counters[index];
+    bool prediction = *counter >= 2;
+
+    if(taken && *counter < 3)
+        (*counter) ++;
+    else if(!taken && *counter > 0)
+        (*counter) --;
+
+    timing->history = ((timing->history << 1) | (taken ? 1 : 0)) & table_mask;
+    return prediction;
+}
+
+static void return_stack_push(TimingModel* timing, uint32_t return_address){
+    timing->return_stack_top = (timing->return_stack_top + 1) % timing->ras_depth;
+    timing->return_stack[timing->return_stack_top] = return_address;
+
+    // On overflow oldest entries are overwritten
+    if(timing->return_stack_count < timing->ras_depth)
+        timing->return_stack_count ++;
+}
+
+static bool return_stack_pop(TimingModel* timing, uint32_t* return_address){
+    if(timing->return_stack_count == 0)
+        return false;
+
+    *return_address = timing->return_stack[timing->return_stack_top];
+    timing->return_stack_top = (timing->return_stack_top + timing->ras_depth - 1) % timing->ras_depth;
+    timing->return_stack_count --;
+    return true;
+}
+
+void timing_model_record(TimingModel* timing, Cpu* cpu, uint32_t pc, uint32_t op_code){
+    uint64_t cycles = timing->op_latency[op_code];
+    uint32_t next_pc = cpu->regs[RPC];
+
+    if(op_code >= OP_BNE && op_code <= OP_BLE){
+        BinInstruction* instruction = (BinInstruction*)(cpu->program_buffer + pc);
+        bool taken = next_pc != pc + BIN_INSTRUCTION_SIZE;
+
+        timing->branches ++;
+        if(taken)
+            timing->branches_taken ++;
+
+        if(predict_and_update(timing, pc, instruction->arg_list[2], taken) != taken){
+            timing->branch_mispredicts ++;
+            cycles += timing->mispredict_penalty;
+        }
+    }
+    else if(op_code == OP_CFN){
+        return_stack_push(timing, pc + BIN_INSTRUCTION_SIZE);
+    }
+    else if(op_code == OP_RET){
+        uint32_t predicted_address = 0;
+        timing->returns ++;
+
+        if(!return_stack_pop(timing, &predicted_address) || predicted_address != next_pc){
+            timing->return_mispredicts ++;
+            cycles += timing->mispredict_penalty;
+        }
+    }
+
+    timing->cycles += cycles;
+    timing->instructions ++;
+    timing->op_counters[op_code].executions ++;
+    timing->op_counters[op_code].cycles += cycles;
+}
+
+//-------------------------REPORT-------------------------
+
+static double percent(uint64_t part, uint64_t total){
+    return total ? 100.0 * (double)part / (double)total : 0.0;
+}
+
+void timing_model_write_report(TimingModel* timing, const char* report_file_name){
+    FILE* report_file = fopen(report_file_name, "w");
+    if(!report_file){
+        fprintf(stderr, "Error opening timing report file %s!\n", report_file_name);
+        abort();
+    }
+
+    fprintf(report_file, "Modeled cycles:        %lu\n", timing->cycles);
+    fprintf(report_file, "Instructions:          %lu\n", timing->instructions);
+    fprintf(report_file, "CPI:                   %.3f\n",
+            timing->instructions ? (double)timing->cycles / (double)timing->instructions : 0.0);
+
+    fprintf(report_file, "\nBranch predictor:      %s (table bits %u, mispredict penalty %u)\n",
+            predictor_names[timing->predictor], timing->table_bits, timing->mispredict_penalty);
+    fprintf(report_file, "Conditional branches:  %lu (%.2f%% taken)\n",
+            timing->branches, percent(timing->branches_taken, timing->branches));
+    fprintf(report_file, "Branch mispredicts:    %lu (%.2f%%)\n",
+            timing->branch_mispredicts, percent(timing->branch_mispredicts, timing->branches));
+    fprintf(report_file, "Returns:               %lu (return stack depth %u)\n", timing->returns, timing->ras_depth);
+    fprintf(report_file, "Return mispredicts:    %lu (%.2f%%)\n",
+            timing->return_mispredicts, percent(timing->return_mispredicts, timing->returns));
+
+    fprintf(report_file, "\nCycles by opcode:\n");
+    fprintf(report_file, "%-6s %8s %14s %16s %8s\n", "op", "latency", "executions", "cycles", "%");
+    for(uint32_t op_code = 0; op_code < TIMING_OP_SLOTS; op_code ++){
+        TimingOpCounter* counter = &timing->op_counters[op_code];
+        if(counter->executions == 0)
+            continue;
+
+        fprintf(report_file, "%-6s %8u %14lu %16lu %7.2f%%\n",
+                op_code < INSTRUCTIONS_SET_NUMBER ? instruction_set[op_code].op_name : "???",
+                timing->op_latency[op_code], counter->executions, counter->cycles,
+                percent(counter->cycles, timing->cycles));
+    }
+
+    fclose(report_file);
+}
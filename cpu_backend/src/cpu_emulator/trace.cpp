@@ -0,0 +1,192 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "cpu_emulator/cpu.h"
+#include "cpu_emulator/trace.h"
+#include "instructions/instructions.h"
+#include "stack/stack.h"
+#include "exceptions/exceptions.h"
+
+//-------------------------FILE_WRITING-------------------------
+
+static void write_trace_header(Tracer* tracer, uint64_t first_record){
+    TraceFileHeader header = {};
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.record_size = tracer->record_size;
+    header.first_record = first_record;
+
+    if(fwrite(&header, sizeof(header), 1, tracer->trace_file) != 1){
+        fprintf(stderr, "Error while writing trace file header!\n");
+        abort();
+    }
+}
+
+// Writes records [first, last) from ring buffer
+static void write_trace_records(Tracer* tracer, uint64_t first, uint64_t last){
+    while(first != last){
+        uint64_t position = first & (tracer->capacity - 1);
+        uint64_t chunk = tracer->capacity - position;
+        if(chunk > last - first)
+            chunk = last - first;
+
+        if(fwrite(tracer->buffer + position * tracer->record_size, tracer->record_size, chunk,
+                  tracer->trace_file) != chunk){
+            fprintf(stderr, "Error while writing trace file!\n");
+            abort();
+        }
+        first += chunk;
+    }
+}
+
+static void* trace_writer(void* arg){
+    Tracer* tracer = (Tracer*)arg;
+    struct timespec idle_time = {0, TRACE_WRITER_IDLE_NS};
+
+    while(true){
+        // Finished flag is read first, so head read after it is final
+        bool finished = __atomic_load_n(&tracer->finished, __ATOMIC_ACQUIRE);
+        uint64_t head = __atomic_load_n(&tracer->head, __ATOMIC_ACQUIRE);
+        uint64_t tail = tracer->tail;
+
+        if(head == tail){
+            if(finished)
+                break;
+            nanosleep(&idle_time, NULL);
+            continue;
+        }
+
+        write_trace_records(tracer, tail, head);
+        __atomic_store_n(&tracer->tail, head, __ATOMIC_RELEASE);
+    }
+
+    return NULL;
+}
+
+//-------------------------TRACER-------------------------
+
+void tracer_init(Tracer* tracer, const char* trace_file_name, bool streaming, bool operands){
+    tracer->record_size = operands ? TRACE_FULL_RECORD_SIZE : TRACE_SHORT_RECORD_SIZE;
+    tracer->capacity = TRACE_RING_RECORDS;
+    tracer->head = 0;
+    tracer->tail = 0;
+    tracer->streaming = streaming;
+    tracer->operands = operands;
+    tracer->finished = false;
+
+    // Buffer has space for full record at any position, even if records are short
+    tracer->buffer = (uint8_t*)calloc(tracer->capacity * tracer->record_size + TRACE_FULL_RECORD_SIZE, 1);
+    if(!tracer->buffer){
+        fprintf(stderr, "Error: Cannot allocate trace buffer!\n");
+        abort();
+    }
+
+    tracer->trace_file = fopen(trace_file_name, "wb");
+    if(!tracer->trace_file){
+        fprintf(stderr, "Error opening trace file %s!\n", trace_file_name);
+        abort();
+    }
+
+    if(streaming){
+        write_trace_header(tracer, 0);
+        if(pthread_create(&tracer->writer_thread, NULL, trace_writer, tracer) != 0){
+            fprintf(stderr, "Error: Cannot start trace writer thread!\n");
+            abort();
+        }
+    }
+}
+
+void tracer_wait_space(Tracer* tracer){
+    while(tracer->head - __atomic_load_n(&tracer->tail, __ATOMIC_ACQUIRE) == tracer->capacity){
+        sched_yield();
+    }
+}
+
+static uint32_t peek_data_word(Cpu* cpu, uint32_t address){
+    Stack* stack = cpu->data_stack;
+    if((uint64_t)address + sizeof(uint32_t) > stack->count)
+        return 0;
+
+    volatile uint32_t value = 0;
+    TRY{
+        uint32_t word = 0;
+        memcpy(&word, stack_get_element(stack, address), sizeof(uint32_t));
+        value = word;
+    }
+    CATCH_ALL{
+        value = 0;
+    }
+    END_TRY;
+
+    return value;
+}
+
+void tracer_capture_operands(Tracer* tracer, Cpu* cpu, TraceRecord* record){
+    (void)tracer;
+
+    uint32_t* instruction = (uint32_t*)(cpu->program_buffer + record->pc);
+    uint32_t header = instruction[0];
+    int num_of_args = record->op_code < INSTRUCTIONS_SET_NUMBER ? instruction_set[record->op_code].num_of_args : 0;
+
+    record->flags = TRACE_HAS_OPERANDS;
+    record->memory_address = TRACE_NO_MEMORY_ADDRESS;
+
+    for(int arg_count = 0; arg_count < 3; arg_count ++){
+        uint32_t arg_value = instruction[arg_count + 1];
+        int byte_position = 16 - (arg_count * 8);
+        bool in_reg  = header & (1 << (byte_position + 1));
+        bool abst_op = header & (1 << (byte_position + 0));
+
+        uint32_t value = 0;
+        if(arg_count >= num_of_args){
+            value = 0;
+        }
+        else if(in_reg && arg_value >= NUM_OF_REGISTERS){
+            value = 0;
+        }
+        else if(abst_op){
+            uint32_t address = in_reg ? cpu->regs[arg_value] : arg_value;
+            value = peek_data_word(cpu, address);
+
+            if(record->memory_address == TRACE_NO_MEMORY_ADDRESS)
+                record->memory_address = address;
+        }
+        else{
+            value = in_reg ? cpu->regs[arg_value] : arg_value;
+        }
+
+        record->operand_values[arg_count] = value;
+    }
+
+    // str and ldr access top of data stack
+    if(record->op_code == OP_STR)
+        record->memory_address = (uint32_t)cpu->data_stack->count;
+    else if(record->op_code == OP_LDR && cpu->data_stack->count >= sizeof(uint32_t))
+        record->memory_address = (uint32_t)cpu->data_stack->count - sizeof(uint32_t);
+
+    if(record->memory_address != TRACE_NO_MEMORY_ADDRESS)
+        record->flags |= TRACE_HAS_MEMORY;
+}
+
+void tracer_finish(Tracer* tracer){
+    __atomic_store_n(&tracer->finished, true, __ATOMIC_RELEASE);
+
+    if(tracer->streaming){
+        pthread_join(tracer->writer_thread, NULL);
+    }
+    else{
+        // Only last records are kept in ring buffer
+        uint64_t first_record = tracer->head > tracer->capacity ? tracer->head - tracer->capacity : 0;
+        write_trace_header(tracer, first_record);
+        write_trace_records(tracer, first_record, tracer->head);
+    }
+
+    fclose(tracer->trace_file);
+    free(tracer->buffer);
+    tracer->buffer = NULL;
+}
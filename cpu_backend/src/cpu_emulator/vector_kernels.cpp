@@ -0,0 +1,125 @@
+#include <stdint.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "cpu_emulator/vector_kernels.h"
+
+//---------------------SSE2_HELPERS---------------------
+
+#if defined(__SSE2__)
+static inline __m128i mullo_epi32_128(__m128i a, __m128i b){
+#if defined(__SSE4_1__)
+    return _mm_mullo_epi32(a, b);
+#else
+    // SSE2 multiplies only even words into 64 bit products, odd words are shifted into even positions
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+#endif
+}
+
+static inline uint32_t horizontal_sum_128(__m128i sum){
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (uint32_t)_mm_cvtsi128_si32(sum);
+}
+#endif
+
+//---------------------ELEMENTWISE---------------------
+
+void vector_add(uint32_t* result, const uint32_t* src1, const uint32_t* src2, uint32_t count){
+    uint32_t i = 0;
+
+#if defined(__AVX2__)
+    for(; i + 8 <= count; i += 8){
+        __m256i a = _mm256_loadu_si256((const __m256i*)(src1 + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src2 + i));
+        _mm256_storeu_si256((__m256i*)(result + i), _mm256_add_epi32(a, b));
+    }
+#endif
+#if defined(__SSE2__)
+    for(; i + 4 <= count; i += 4){
+        __m128i a = _mm_loadu_si128((const __m128i*)(src1 + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src2 + i));
+        _mm_storeu_si128((__m128i*)(result + i), _mm_add_epi32(a, b));
+    }
+#endif
+
+    for(; i < count; i ++)
+        result[i] = src1[i] + src2[i];
+}
+
+void vector_mul(uint32_t* result, const uint32_t* src1, const uint32_t* src2, uint32_t count){
+    uint32_t i = 0;
+
+#if defined(__AVX2__)
+    for(; i + 8 <= count; i += 8){
+        __m256i a = _mm256_loadu_si256((const __m256i*)(src1 + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src2 + i));
+        _mm256_storeu_si256((__m256i*)(result + i), _mm256_mullo_epi32(a, b));
+    }
+#endif
+#if defined(__SSE2__)
+    for(; i + 4 <= count; i += 4){
+        __m128i a = _mm_loadu_si128((const __m128i*)(src1 + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src2 + i));
+        _mm_storeu_si128((__m128i*)(result + i), mullo_epi32_128(a, b));
+    }
+#endif
+
+    for(; i < count; i ++)
+        result[i] = src1[i] * src2[i];
+}
+
+void vector_compare(uint32_t* result, const uint32_t* src1, const uint32_t* src2, uint32_t count){
+    uint32_t i = 0;
+
+    // Equal words give all ones mask, its top bit shifted down is 1
+#if defined(__AVX2__)
+    for(; i + 8 <= count; i += 8){
+        __m256i a = _mm256_loadu_si256((const __m256i*)(src1 + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src2 + i));
+        _mm256_storeu_si256((__m256i*)(result + i), _mm256_srli_epi32(_mm256_cmpeq_epi32(a, b), 31));
+    }
+#endif
+#if defined(__SSE2__)
+    for(; i + 4 <= count; i += 4){
+        __m128i a = _mm_loadu_si128((const __m128i*)(src1 + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src2 + i));
+        _mm_storeu_si128((__m128i*)(result + i), _mm_srli_epi32(_mm_cmpeq_epi32(a, b), 31));
+    }
+#endif
+
+    for(; i < count; i ++)
+        result[i] = src1[i] == src2[i];
+}
+
+//---------------------REDUCTION---------------------
+
+uint32_t vector_sum(const uint32_t* src, uint32_t count){
+    uint32_t i = 0;
+    uint32_t sum = 0;
+
+#if defined(__AVX2__)
+    __m256i wide_sum = _mm256_setzero_si256();
+    for(; i + 8 <= count; i += 8)
+        wide_sum = _mm256_add_epi32(wide_sum, _mm256_loadu_si256((const __m256i*)(src + i)));
+
+    sum += horizontal_sum_128(_mm_add_epi32(_mm256_castsi256_si128(wide_sum),
+                                            _mm256_extracti128_si256(wide_sum, 1)));
+#endif
+#if defined(__SSE2__)
+    __m128i narrow_sum = _mm_setzero_si128();
+    for(; i + 4 <= count; i += 4)
+        narrow_sum = _mm_add_epi32(narrow_sum, _mm_loadu_si128((const __m128i*)(src + i)));
+
+    sum += horizontal_sum_128(narrow_sum);
+#endif
+
+    for(; i < count; i ++)
+        sum += src[i];
+    return sum;
+}
@@ -0,0 +1,137 @@
+#include "cpu_emulator/metrics.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/mman.h>
+
+#define CPU_TOP_MAX_VMS 256
+#define CPU_TOP_INTERVAL_NS 1000000000l
+#define SHM_DIRECTORY "/dev/shm"
+
+//---------------------------------------READING---------------------------------------
+
+static bool read_vm_metrics(const char* shm_name, MetricsSnapshot* snapshot){
+    int fd = shm_open(shm_name, O_RDONLY, 0);
+    if(fd == -1)
+        return false;
+
+    void* mapped_mem = mmap(NULL, sizeof(MetricsSnapshot), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if(mapped_mem == MAP_FAILED)
+        return false;
+
+    bool readed = metrics_read_shared((const MetricsSnapshot*)mapped_mem, snapshot);
+    munmap(mapped_mem, sizeof(MetricsSnapshot));
+    return readed;
+}
+
+// Segment names of all running emulators
+static int find_vms(char shm_names[][METRICS_SHM_NAME_SIZE]){
+    DIR* shm_directory = opendir(SHM_DIRECTORY);
+    if(!shm_directory)
+        return 0;
+
+    // Prefix without leading '/'
+    const char* prefix = METRICS_SHM_PREFIX + 1;
+    size_t prefix_size = strlen(prefix);
+
+    int vms_count = 0;
+    struct dirent* entry = NULL;
+    while((entry = readdir(shm_directory)) != NULL && vms_count < CPU_TOP_MAX_VMS){
+        if(strncmp(entry->d_name, prefix, prefix_size) != 0)
+            continue;
+
+        // Longer name can't be made by emulator, truncated one would open other segment
+        int name_size = snprintf(shm_names[vms_count], METRICS_SHM_NAME_SIZE, "/%s", entry->d_name);
+        if(name_size < 0 || name_size >= METRICS_SHM_NAME_SIZE)
+            continue;
+
+        // Emulator killed by signal can't remove its segment, it is removed here
+        long pid = strtol(entry->d_name + prefix_size, NULL, 10);
+        if(pid <= 0)
+            continue;
+        if(kill((pid_t)pid, 0) == -1 && errno == ESRCH){
+            shm_unlink(shm_names[vms_count]);
+            continue;
+        }
+
+        vms_count ++;
+    }
+
+    closedir(shm_directory);
+    return vms_count;
+}
+
+//---------------------------------------PRINTING---------------------------------------
+
+static void print_header(){
+    printf("%8s %4s %14s %12s %10s %10s %9s %12s %10s %10s\n", "PID", "RUN", "RETIRED", "IPS",
+           "DATA_HW", "CALL_HW", "REALLOCS", "HASH_MS", "IN", "OUT_BYTES");
+}
+
+static void print_vm(MetricsSnapshot* snapshot){
+    printf("%8ld %4s %14lu %12.0f %10lu %10lu %9lu %12.1f %10lu %10lu\n", snapshot->pid,
+           snapshot->running ? "yes" : "no", snapshot->instructions_retired, snapshot->instructions_per_second,
+           snapshot->data_stack.high_water, snapshot->call_stack.high_water,
+           snapshot->data_stack.reallocs + snapshot->call_stack.reallocs,
+           (double)(snapshot->data_stack.hash_ns + snapshot->call_stack.hash_ns) / 1e6,
+           snapshot->input_values, snapshot->output_bytes);
+}
+
+//---------------------------------------MAIN----------------------------------------
+
+int main(int argc, char* argv[]){
+    long iterations = -1;
+    int first_pid_arg = 1;
+
+    if(argc >= 3 && strcmp(argv[1], "-n") == 0){
+        iterations = strtol(argv[2], NULL, 10);
+        first_pid_arg = 3;
+    }
+
+    static char shm_names[CPU_TOP_MAX_VMS][METRICS_SHM_NAME_SIZE];
+    struct timespec interval = {CPU_TOP_INTERVAL_NS / 1000000000l, CPU_TOP_INTERVAL_NS % 1000000000l};
+
+    for(long iteration = 0; iterations < 0 || iteration < iterations; iteration ++){
+        int vms_count = 0;
+
+        // Watch given pids or every running emulator
+        if(first_pid_arg < argc){
+            for(int arg_count = first_pid_arg; arg_count < argc && vms_count < CPU_TOP_MAX_VMS; arg_count ++){
+                snprintf(shm_names[vms_count ++], METRICS_SHM_NAME_SIZE, METRICS_SHM_PREFIX "%s", argv[arg_count]);
+            }
+        }
+        else{
+            vms_count = find_vms(shm_names);
+        }
+
+        if(iteration != 0)
+            printf("\n");
+        print_header();
+
+        int alive_count = 0;
+        for(int vm = 0; vm < vms_count; vm ++){
+            MetricsSnapshot snapshot;
+            if(read_vm_metrics(shm_names[vm], &snapshot)){
+                print_vm(&snapshot);
+                alive_count ++;
+            }
+        }
+        fflush(stdout);
+
+        if(alive_count == 0)
+            break;
+
+        nanosleep(&interval, NULL);
+    }
+
+    return 0;
+}
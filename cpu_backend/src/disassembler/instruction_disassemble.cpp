@@ -0,0 +1,74 @@
+#include "instructions/instructions.h"
+#include "disassembler/disassembler.h"
+
+#include <stdio.h>
+#include <string.h>
+
+//--------------------------PRINT_DISASSEMBLED_INSTRUCTIONS--------------------------
+
+void print_text_instruction(TextInstruction* text_instruction, uint32_t address){
+    // Fixed widths that work for most cases
+    // Address: 8 hex digits + space
+    // Operation: 10 chars + 2 spaces
+    printf("%08x  %-10s  ", address, text_instruction->operation.operation_name);
+    
+    for(uint32_t j = 0; j < text_instruction->operation.num_of_args; j++){
+        // Print flag (if any) and hex with consistent width
+        if(strlen(text_instruction->imm[j].imm_flag) > 0){
+            printf("%s%08x  ", text_instruction->imm[j].imm_flag, text_instruction->imm[j].imm);
+        } else {
+            printf(" %08x  ", text_instruction->imm[j].imm); // pad for missing flag
+        }
+    }
+}
+
+//------------------------------------DISASSEMBLER-----------------------------------
+
+static void flag_disassemble(BinInstruction* bin_instruction, TextInstruction* text_instruction, int arg_count){
+    uint32_t current_operation = bin_instruction->operation;
+
+    // Read all setted flags
+    int flag_count = 0;
+    int text_flag_count = 0;
+    while(flag_count < INSTRUCTIONS_FLAGS_NUMBER){
+        uint32_t flag_mask = 1 << (16 - arg_count * 8 + flag_count);
+
+        if((current_operation & flag_mask) == flag_mask){
+            text_instruction->imm[arg_count].imm_flag[text_flag_count] = instruction_flag[flag_count];
+            text_flag_count ++;
+        }
+
+        flag_count ++;
+    }
+
+    // Fill rest of flags buffer by spaces
+    if(flag_count != text_flag_count){
+        for(int i = text_flag_count; i < flag_count; i ++){
+            text_instruction->imm[arg_count].imm_flag[i] = ' ';
+        }
+    }
+}
+
+void instruction_disassemble(BinInstruction* bin_instruction, TextInstruction* text_instruction){
+    // Instruction name disassemble
+    uint32_t instruction_code = (bin_instruction->operation >> 24) & 0xFF;
+
+    text_instruction->operation.op_code     = instruction_code;
+    if(instruction_code < INSTRUCTIONS_SET_NUMBER){
+        text_instruction->operation.num_of_args = instruction_set[instruction_code].num_of_args;
+        strcpy(text_instruction->operation.operation_name, instruction_set[instruction_code].op_name);
+    }
+    else{
+        text_instruction->operation.num_of_args = 0;
+        strcpy(text_instruction->operation.operation_name, "???");
+        printf("\nStrange code: %d\n", instruction_code);
+    }
+
+    // Instruction imms disassemble
+    for(uint32_t imm_count = 0; imm_count < text_instruction->operation.num_of_args; imm_count ++){
+        flag_disassemble(bin_instruction, text_instruction, imm_count);
+        
+        // Imm value disassembling
+        text_instruction->imm[imm_count].imm = bin_instruction->arg_list[imm_count];
+    }
+}
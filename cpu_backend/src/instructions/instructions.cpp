@@ -7,24 +7,31 @@ const char ignorable_symbols[IGNORABLE_SYMBOLS_NUMBER] = {' ',  '\t'};
 const char parse_stoping_symbols[PARSE_STOPING_SYMB_NUMBER] = {'\n', '\0', '\r', ';'};
 
 const InstructionSet instruction_set[] = {  
-    {"inp", 1, &inp},
-    {"out", 1, &out},
-    {"mov", 2, &mov},
-    {"add", 3, &add},
-    {"sub", 3, &sub},
-    {"mul", 3, &mul},
-    {"div", 3, &div},
-    {"sqr", 2, &sqr},
-    {"bne", 3, &bne},
-    {"beq", 3, &beq},
-    {"bgt", 3, &bgt},
-    {"blt", 3, &blt},
-    {"bge", 3, &bge},
-    {"ble", 3, &ble},
-    {"baw", 1, &baw},
-    {"str", 1, &str},
-    {"ldr", 1, &ldr},
-    {"cfn", 1, &cfn},
-    {"ret", 0, &ret},
-    {"hlt", 0, &hlt}
+    {"inp", 1, &inp, {ARG_DESTINATION},                          FLOW_NEXT},
+    {"out", 1, &out, {ARG_SOURCE},                               FLOW_NEXT},
+    {"mov", 2, &mov, {ARG_DESTINATION, ARG_SOURCE},              FLOW_NEXT},
+    {"add", 3, &add, {ARG_DESTINATION, ARG_SOURCE, ARG_SOURCE},  FLOW_NEXT},
+    {"sub", 3, &sub, {ARG_DESTINATION, ARG_SOURCE, ARG_SOURCE},  FLOW_NEXT},
+    {"mul", 3, &mul, {ARG_DESTINATION, ARG_SOURCE, ARG_SOURCE},  FLOW_NEXT},
+    {"div", 3, &div, {ARG_DESTINATION, ARG_SOURCE, ARG_SOURCE},  FLOW_NEXT},
+    {"sqr", 2, &sqr, {ARG_DESTINATION, ARG_SOURCE},              FLOW_NEXT},
+    {"bne", 3, &bne, {ARG_SOURCE, ARG_SOURCE, ARG_TARGET},       FLOW_BRANCH},
+    {"beq", 3, &beq, {ARG_SOURCE, ARG_SOURCE, ARG_TARGET},       FLOW_BRANCH},
+    {"bgt", 3, &bgt, {ARG_SOURCE, ARG_SOURCE, ARG_TARGET},       FLOW_BRANCH},
+    {"blt", 3, &blt, {ARG_SOURCE, ARG_SOURCE, ARG_TARGET},       FLOW_BRANCH},
+    {"bge", 3, &bge, {ARG_SOURCE, ARG_SOURCE, ARG_TARGET},       FLOW_BRANCH},
+    {"ble", 3, &ble, {ARG_SOURCE, ARG_SOURCE, ARG_TARGET},       FLOW_BRANCH},
+    {"baw", 1, &baw, {ARG_TARGET},                               FLOW_JUMP},
+    {"str", 1, &str, {ARG_SOURCE_REGISTER},                      FLOW_NEXT},
+    {"ldr", 1, &ldr, {ARG_DESTINATION_REGISTER},                 FLOW_NEXT},
+    {"cfn", 1, &cfn, {ARG_TARGET},                               FLOW_CALL},
+    {"ret", 0, &ret, {},                                         FLOW_RETURN},
+    {"hlt", 0, &hlt, {},                                         FLOW_HALT},
+    {"vad", 3, &vad, {ARG_DESTINATION_ADDRESS, ARG_SOURCE_ADDRESS, ARG_SOURCE}, FLOW_NEXT},
+    {"vml", 3, &vml, {ARG_DESTINATION_ADDRESS, ARG_SOURCE_ADDRESS, ARG_SOURCE}, FLOW_NEXT},
+    {"vcm", 3, &vcm, {ARG_DESTINATION_ADDRESS, ARG_SOURCE_ADDRESS, ARG_SOURCE}, FLOW_NEXT},
+    {"vsm", 3, &vsm, {ARG_DESTINATION, ARG_SOURCE_ADDRESS, ARG_SOURCE},         FLOW_NEXT},
+    {"bmv", 3, &bmv, {ARG_DESTINATION_ADDRESS, ARG_SOURCE_ADDRESS, ARG_SOURCE}, FLOW_NEXT},
+    {"bfl", 3, &bfl, {ARG_DESTINATION_ADDRESS, ARG_SOURCE, ARG_SOURCE},         FLOW_NEXT},
+    {"hcl", 1, &hcl, {ARG_SOURCE},                               FLOW_NEXT}
 };
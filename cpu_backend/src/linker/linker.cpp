@@ -0,0 +1,218 @@
+#include "instructions/instructions.h"
+#include "text_asm_parser/label_table.h"
+#include "assembler/assembler.h"
+#include "object/object.h"
+#include "symbols/symbols.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct LinkerOptions{
+    const char* output_bin_file;
+    ProgramOptions program;
+    uint32_t objects_count;
+    // Objects are placed in bin in command line order, program starts from first one unless entry is given
+    char** object_file_list;
+}LinkerOptions;
+
+typedef struct LinkedObject{
+    ObjectFile object_file;
+    const char* file_name;
+    uint32_t base_address;
+}LinkedObject;
+
+//------------------------------------EXPORTS-----------------------------------
+
+// Exported labels of all objects, definers_list counts objects defining every label
+typedef struct ExportTable{
+    LabelTable label_table;
+    uint32_t* definers_list;
+}ExportTable;
+
+static void collect_exports(ExportTable* export_table, LinkedObject* object_list, uint32_t objects_count){
+    uint32_t symbols_count = 0;
+    for(uint32_t i = 0; i < objects_count; i ++){
+        symbols_count += object_list[i].object_file.header.symbols_count;
+    }
+
+    label_table_init(&export_table->label_table);
+    export_table->definers_list = (uint32_t*)calloc(symbols_count + 1, sizeof(uint32_t));
+    if(!export_table->definers_list){
+        fprintf(stderr, "Error: Cannot allocate export table!\n");
+        abort();
+    }
+
+    for(uint32_t i = 0; i < objects_count; i ++){
+        ObjectFile* object_file = &object_list[i].object_file;
+
+        for(uint32_t j = 0; j < object_file->header.symbols_count; j ++){
+            ObjectSymbol* symbol = &object_file->symbol_list[j];
+            if(!(symbol->flags & OBJECT_SYMBOL_DEFINED))
+                continue;
+
+            Label* label = label_table_insert(&export_table->label_table, object_symbol_name(object_file, symbol),
+                                              symbol->name_size);
+            uint32_t label_index = (uint32_t)(label - export_table->label_table.label_list);
+
+            // First definer is kept, so address is known even if label turns out ambiguous
+            if(export_table->definers_list[label_index] ++ == 0)
+                label->address = object_list[i].base_address + symbol->address;
+        }
+    }
+}
+
+static void free_export_table(ExportTable* export_table){
+    free_label_table(&export_table->label_table);
+    free(export_table->definers_list);
+}
+
+//------------------------------------LINKING-----------------------------------
+
+// Labels defined in object itself are resolved locally, others must have exactly one definer
+static uint32_t resolve_symbol(ExportTable* export_table, LinkedObject* linked_object, ObjectSymbol* symbol){
+    if(symbol->flags & OBJECT_SYMBOL_DEFINED)
+        return linked_object->base_address + symbol->address;
+
+    const char* name = object_symbol_name(&linked_object->object_file, symbol);
+    Label* label = label_table_find(&export_table->label_table, name, symbol->name_size);
+
+    if(!label){
+        fprintf(stderr, "Error: Undefined label %s referenced in %s!\n", name, linked_object->file_name);
+        abort();
+    }
+
+    uint32_t definers = export_table->definers_list[label - export_table->label_table.label_list];
+    if(definers > 1){
+        fprintf(stderr, "Error: Label %s referenced in %s is defined in %u objects!\n",
+                name, linked_object->file_name, definers);
+        abort();
+    }
+
+    return label->address;
+}
+
+static void link_objects(LinkedObject* object_list, uint32_t objects_count, BinInstructionArray* bin_instructions_array,
+                         SymbolMap* symbol_map){
+    ExportTable export_table;
+    collect_exports(&export_table, object_list, objects_count);
+
+    for(uint32_t i = 0; i < objects_count; i ++){
+        LinkedObject* linked_object = &object_list[i];
+        ObjectFile* object_file = &linked_object->object_file;
+        BinInstruction* bin_instruction_list = bin_instructions_array->bin_instruction_list +
+                                               linked_object->base_address / BIN_INSTRUCTION_SIZE;
+
+        memcpy(bin_instruction_list, object_file->instruction_list,
+               object_file->header.instructions_count * sizeof(BinInstruction));
+
+        for(uint32_t j = 0; j < object_file->header.relocations_count; j ++){
+            ObjectRelocation* relocation = &object_file->relocation_list[j];
+            bin_instruction_list[relocation->instruction].arg_list[relocation->arg] =
+                resolve_symbol(&export_table, linked_object, &object_file->symbol_list[relocation->symbol]);
+        }
+
+        for(uint32_t j = 0; j < object_file->header.symbols_count; j ++){
+            ObjectSymbol* symbol = &object_file->symbol_list[j];
+            if(symbol->flags & OBJECT_SYMBOL_DEFINED)
+                symbol_map_add_symbol(symbol_map, object_symbol_name(object_file, symbol), symbol->name_size,
+                                      linked_object->base_address + symbol->address);
+        }
+
+        for(uint32_t j = 0; j < object_file->header.lines_count; j ++){
+            symbol_map_add_line(symbol_map, linked_object->base_address + object_file->line_list[j].address,
+                                object_file->line_list[j].line);
+        }
+    }
+
+    free_export_table(&export_table);
+}
+
+//---------------------------------------MAIN----------------------------------------
+
+static void parse_options(int argc, char* argv[], LinkerOptions* options){
+    options->output_bin_file = NULL;
+    program_options_init(&options->program);
+    options->objects_count = 0;
+    options->object_file_list = (char**)calloc(argc, sizeof(char*));
+    if(!options->object_file_list){
+        fprintf(stderr, "Error: Cannot allocate memory!\n");
+        abort();
+    }
+
+    for(int arg_count = 1; arg_count < argc; arg_count ++){
+        const char* arg = argv[arg_count];
+
+        if(parse_program_option(argc, argv, &arg_count, &options->program))
+            continue;
+
+        if(strcmp(arg, "-o") == 0 && arg_count + 1 < argc){
+            options->output_bin_file = argv[++ arg_count];
+        }
+        else if(arg[0] != '-'){
+            options->object_file_list[options->objects_count ++] = argv[arg_count];
+        }
+        else{
+            fprintf(stderr, "Unknown option %s!\n", arg);
+            options->output_bin_file = NULL;
+            break;
+        }
+    }
+
+    if(!options->output_bin_file || options->objects_count == 0){
+        fprintf(stderr, "Usage: linker " PROGRAM_OPTIONS_USAGE " -o program.bin main.myo [module.myo ...]\n");
+        abort();
+    }
+}
+
+int main(int argc, char* argv[]){
+    LinkerOptions options;
+    parse_options(argc, argv, &options);
+
+    LinkedObject* object_list = (LinkedObject*)calloc(options.objects_count, sizeof(LinkedObject));
+    if(!object_list){
+        fprintf(stderr, "Error: Cannot allocate memory!\n");
+        abort();
+    }
+
+    uint64_t instructions_count = 0;
+    for(uint32_t i = 0; i < options.objects_count; i ++){
+        object_list[i].file_name = options.object_file_list[i];
+        object_file_read(&object_list[i].object_file, options.object_file_list[i]);
+
+        object_list[i].base_address = (uint32_t)(instructions_count * BIN_INSTRUCTION_SIZE);
+        instructions_count += object_list[i].object_file.header.instructions_count;
+    }
+
+    // Addresses are 32 bit
+    if(instructions_count * BIN_INSTRUCTION_SIZE > UINT32_MAX){
+        fprintf(stderr, "Error: Linked program has too many instructions (%lu)!\n", instructions_count);
+        abort();
+    }
+
+    BinInstructionArray bin_instructions_array;
+    bin_instructions_array.count = (uint32_t)instructions_count;
+    bin_instructions_array.bin_instruction_list = (BinInstruction*)calloc(instructions_count + 1,
+                                                                          sizeof(BinInstruction));
+    if(!bin_instructions_array.bin_instruction_list){
+        fprintf(stderr, "Error: Cannot allocate memory!\n");
+        abort();
+    }
+
+    SymbolMap symbol_map;
+    symbol_map_init(&symbol_map);
+
+    link_objects(object_list, options.objects_count, &bin_instructions_array, &symbol_map);
+
+    write_symbol_sidecar(&symbol_map, options.output_bin_file);
+    write_program_file(&bin_instructions_array, &symbol_map, &options.program, options.output_bin_file);
+
+    symbol_map_free(&symbol_map);
+    free(bin_instructions_array.bin_instruction_list);
+    for(uint32_t i = 0; i < options.objects_count; i ++){
+        object_file_free(&object_list[i].object_file);
+    }
+    free(object_list);
+    free(options.object_file_list);
+    return 0;
+}
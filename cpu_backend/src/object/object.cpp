@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "object/object.h"
+
+//---------------------------------MEMORY---------------------------------
+
+void object_file_alloc(ObjectFile* object_file){
+    ObjectFileHeader* header = &object_file->header;
+
+    // One extra element, so empty sections are not NULL
+    object_file->instruction_list = (BinInstruction*)calloc((size_t)header->instructions_count + 1, sizeof(BinInstruction));
+    object_file->symbol_list = (ObjectSymbol*)calloc((size_t)header->symbols_count + 1, sizeof(ObjectSymbol));
+    object_file->relocation_list = (ObjectRelocation*)calloc((size_t)header->relocations_count + 1, sizeof(ObjectRelocation));
+    object_file->line_list = (SourceLine*)calloc((size_t)header->lines_count + 1, sizeof(SourceLine));
+    object_file->names = (char*)calloc((size_t)header->names_size + 1, sizeof(char));
+
+    if(!object_file->instruction_list || !object_file->symbol_list || !object_file->relocation_list ||
+       !object_file->line_list || !object_file->names){
+        fprintf(stderr, "Error: Cannot allocate object file!\n");
+        abort();
+    }
+}
+
+void object_file_free(ObjectFile* object_file){
+    free(object_file->instruction_list);
+    free(object_file->symbol_list);
+    free(object_file->relocation_list);
+    free(object_file->line_list);
+    free(object_file->names);
+
+    object_file->instruction_list = NULL;
+    object_file->symbol_list = NULL;
+    object_file->relocation_list = NULL;
+    object_file->line_list = NULL;
+    object_file->names = NULL;
+}
+
+//---------------------------------WRITING---------------------------------
+
+void object_file_write(ObjectFile* object_file, const char* file_name){
+    ObjectFileHeader* header = &object_file->header;
+    memcpy(header->magic, OBJECT_FILE_MAGIC, sizeof(header->magic));
+    header->version = OBJECT_FILE_VERSION;
+
+    FILE* file = fopen(file_name, "wb");
+    if(!file){
+        fprintf(stderr, "Error opening object file %s!\n", file_name);
+        abort();
+    }
+
+    bool written = fwrite(header, sizeof(ObjectFileHeader), 1, file) == 1 &&
+        fwrite(object_file->instruction_list, sizeof(BinInstruction), header->instructions_count, file) ==
+            header->instructions_count &&
+        fwrite(object_file->symbol_list, sizeof(ObjectSymbol), header->symbols_count, file) ==
+            header->symbols_count &&
+        fwrite(object_file->relocation_list, sizeof(ObjectRelocation), header->relocations_count, file) ==
+            header->relocations_count &&
+        fwrite(object_file->line_list, sizeof(SourceLine), header->lines_count, file) == header->lines_count &&
+        fwrite(object_file->names, sizeof(char), header->names_size, file) == header->names_size;
+
+    if(fclose(file) != 0 || !written){
+        fprintf(stderr, "Error writing object file %s!\n", file_name);
+        abort();
+    }
+}
+
+//---------------------------------READING---------------------------------
+
+static void object_file_error(const char* file_name, const char* message){
+    fprintf(stderr, "Error: %s is not a valid object file: %s!\n", file_name, message);
+    abort();
+}
+
+static void validate_object_file(ObjectFile* object_file, const char* file_name){
+    ObjectFileHeader* header = &object_file->header;
+
+    for(uint32_t i = 0; i < header->symbols_count; i ++){
+        ObjectSymbol* symbol = &object_file->symbol_list[i];
+        if((uint64_t)symbol->name_offset + symbol->name_size >= header->names_size ||
+           object_file->names[symbol->name_offset + symbol->name_size] != '\0'){
+            object_file_error(file_name, "symbol name is out of names section");
+        }
+    }
+
+    for(uint32_t i = 0; i < header->relocations_count; i ++){
+        ObjectRelocation* relocation = &object_file->relocation_list[i];
+        if(relocation->instruction >= header->instructions_count || relocation->arg >= 3 ||
+           relocation->symbol >= header->symbols_count){
+            object_file_error(file_name, "relocation is out of range");
+        }
+    }
+}
+
+void object_file_read(ObjectFile* object_file, const char* file_name){
+    FILE* file = fopen(file_name, "rb");
+    if(!file){
+        fprintf(stderr, "Error opening object file %s!\n", file_name);
+        abort();
+    }
+
+    ObjectFileHeader* header = &object_file->header;
+    if(fread(header, sizeof(ObjectFileHeader), 1, file) != 1 ||
+       memcmp(header->magic, OBJECT_FILE_MAGIC, sizeof(header->magic)) != 0){
+        fclose(file);
+        object_file_error(file_name, "wrong magic");
+    }
+    if(header->version != OBJECT_FILE_VERSION){
+        fclose(file);
+        object_file_error(file_name, "unsupported version");
+    }
+
+    // Counts are checked against file size before allocating, so broken header can't request huge sections
+    long sections_offset = ftell(file);
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, sections_offset, SEEK_SET);
+
+    uint64_t sections_size = (uint64_t)header->instructions_count * sizeof(BinInstruction) +
+        (uint64_t)header->symbols_count * sizeof(ObjectSymbol) +
+        (uint64_t)header->relocations_count * sizeof(ObjectRelocation) +
+        (uint64_t)header->lines_count * sizeof(SourceLine) + header->names_size;
+    if(sections_offset < 0 || file_size < sections_offset || sections_size > (uint64_t)(file_size - sections_offset)){
+        fclose(file);
+        object_file_error(file_name, "sections are larger than file");
+    }
+
+    object_file_alloc(object_file);
+
+    bool readed = fread(object_file->instruction_list, sizeof(BinInstruction), header->instructions_count, file) ==
+            header->instructions_count &&
+        fread(object_file->symbol_list, sizeof(ObjectSymbol), header->symbols_count, file) ==
+            header->symbols_count &&
+        fread(object_file->relocation_list, sizeof(ObjectRelocation), header->relocations_count, file) ==
+            header->relocations_count &&
+        fread(object_file->line_list, sizeof(SourceLine), header->lines_count, file) == header->lines_count &&
+        fread(object_file->names, sizeof(char), header->names_size, file) == header->names_size;
+    fclose(file);
+
+    if(!readed){
+        object_file_error(file_name, "file is truncated");
+    }
+
+    validate_object_file(object_file, file_name);
+}
@@ -0,0 +1,1178 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "optimizer/optimizer.h"
+#include "assembler/assembler.h"
+#include "verifier/verifier.h"
+#include "cpu_emulator/cpu.h"
+
+#define ALL_REGISTERS ((1u << NUM_OF_REGISTERS) - 1)
+// Host call can read and write any of x0-xf
+#define HOST_CALL_REGISTERS ((1u << (RPC)) - 1)
+#define NO_INDEX UINT32_MAX
+#define OPTIMIZER_MAX_PENDING_STORES 64
+
+// Outcomes of unsigned comparison of branch operands
+#define OUTCOME_LT (1u << 0)
+#define OUTCOME_EQ (1u << 1)
+#define OUTCOME_GT (1u << 2)
+#define OUTCOME_ALL (OUTCOME_LT | OUTCOME_EQ | OUTCOME_GT)
+
+// Instruction can be reached not only by fallthrough from previous one
+#define MARK_ROOT (1u << 0)
+#define MARK_TARGET (1u << 1)
+#define MARK_RETURN_SITE (1u << 2)
+
+typedef enum ArgKind{
+    ARG_KIND_IMMEDIATE,
+    ARG_KIND_REGISTER,
+    ARG_KIND_MEMORY,
+    ARG_KIND_MEMORY_REGISTER
+}ArgKind;
+
+typedef enum BranchDecision{
+    BRANCH_UNKNOWN,
+    BRANCH_TAKEN,
+    BRANCH_NOT_TAKEN
+}BranchDecision;
+
+typedef struct Optimizer{
+    TextInstructionArray* program;
+    LabelTable* label_table;
+    // Index of entry label instruction, NO_INDEX if program has only first instruction as entry
+    uint32_t entry;
+
+    // Per instruction arrays, they are reallocated when inlining grows program
+    uint8_t* marks;
+    bool* removed;
+    uint32_t* new_index;
+
+    // Inlining doesn't grow program beyond this count
+    uint32_t max_count;
+
+    bool changed;
+}Optimizer;
+
+//-------------------------------INSTRUCTIONS-------------------------------
+
+static void* optimizer_calloc(size_t count, size_t size){
+    void* memory = calloc(count + 1, size);
+    if(!memory){
+        fprintf(stderr, "Error: Cannot allocate optimizer memory!\n");
+        abort();
+    }
+    return memory;
+}
+
+static const InstructionSet* instruction_info(const TextInstruction* instruction){
+    return &instruction_set[instruction->operation.op_code];
+}
+
+static ArgKind arg_kind(const TextInstructionArg* arg){
+    bool in_memory = strchr(arg->imm_flag, '*') != NULL;
+    bool in_register = strchr(arg->imm_flag, 'x') != NULL;
+
+    if(in_memory)
+        return in_register ? ARG_KIND_MEMORY_REGISTER : ARG_KIND_MEMORY;
+    return in_register ? ARG_KIND_REGISTER : ARG_KIND_IMMEDIATE;
+}
+
+static bool arg_in_memory(const TextInstructionArg* arg){
+    ArgKind kind = arg_kind(arg);
+    return kind == ARG_KIND_MEMORY || kind == ARG_KIND_MEMORY_REGISTER;
+}
+
+// Immediate, which is not label address, so it doesn't change with code layout
+static bool arg_is_constant(const TextInstructionArg* arg){
+    return arg_kind(arg) == ARG_KIND_IMMEDIATE && arg->label == 0;
+}
+
+static bool args_equal(const TextInstructionArg* arg1, const TextInstructionArg* arg2){
+    return arg_kind(arg1) == arg_kind(arg2) && arg1->imm == arg2->imm && arg1->label == arg2->label;
+}
+
+static void set_immediate(TextInstructionArg* arg, uint32_t value){
+    strcpy(arg->imm_flag, "  ");
+    arg->imm = (int32_t)value;
+    arg->label = 0;
+}
+
+static void set_operation(TextInstruction* instruction, uint32_t op_code){
+    strcpy(instruction->operation.operation_name, instruction_set[op_code].op_name);
+    instruction->operation.op_code = (short)op_code;
+    instruction->operation.num_of_args = (uint32_t)instruction_set[op_code].num_of_args;
+}
+
+// Index of target arg, -1 if instruction has no target
+static int target_arg(const TextInstruction* instruction){
+    const InstructionSet* info = instruction_info(instruction);
+    for(int arg = 0; arg < info->num_of_args; arg ++){
+        if(info->arg_roles[arg] == ARG_TARGET)
+            return arg;
+    }
+    return -1;
+}
+
+static uint32_t target_index(const TextInstruction* instruction, int arg){
+    return (uint32_t)instruction->imm[arg].imm / BIN_INSTRUCTION_SIZE;
+}
+
+static bool is_arithmetic(uint32_t op_code){
+    return op_code >= OP_MOV && op_code <= OP_SQR;
+}
+
+// Registers, which instruction reads, including registers with memory addresses
+static uint32_t instruction_uses(const TextInstruction* instruction){
+    const InstructionSet* info = instruction_info(instruction);
+    uint32_t uses = 0;
+
+    for(int arg = 0; arg < info->num_of_args; arg ++){
+        const TextInstructionArg* instruction_arg = &instruction->imm[arg];
+        ArgKind kind = arg_kind(instruction_arg);
+        bool used = false;
+
+        switch(info->arg_roles[arg]){
+            case ARG_SOURCE:
+                used = kind == ARG_KIND_REGISTER || kind == ARG_KIND_MEMORY_REGISTER;
+                break;
+            case ARG_DESTINATION:
+            case ARG_SOURCE_ADDRESS:
+            case ARG_DESTINATION_ADDRESS:
+                used = kind == ARG_KIND_MEMORY_REGISTER;
+                break;
+            case ARG_SOURCE_REGISTER:
+                used = true;
+                break;
+            default:
+                break;
+        }
+        if(used)
+            uses |= 1u << (uint32_t)instruction_arg->imm;
+    }
+
+    if(instruction->operation.op_code == OP_HCL)
+        uses |= HOST_CALL_REGISTERS;
+    return uses;
+}
+
+static uint32_t instruction_defines(const TextInstruction* instruction){
+    const InstructionSet* info = instruction_info(instruction);
+    uint32_t defines = 0;
+
+    for(int arg = 0; arg < info->num_of_args; arg ++){
+        const TextInstructionArg* instruction_arg = &instruction->imm[arg];
+        if((info->arg_roles[arg] == ARG_DESTINATION && arg_kind(instruction_arg) == ARG_KIND_REGISTER) ||
+           info->arg_roles[arg] == ARG_DESTINATION_REGISTER){
+            defines |= 1u << (uint32_t)instruction_arg->imm;
+        }
+    }
+
+    if(instruction->operation.op_code == OP_HCL)
+        defines |= HOST_CALL_REGISTERS;
+    return defines;
+}
+
+// Register write without other effects: it doesn't touch memory and can't fail
+static bool is_pure_register_write(const TextInstruction* instruction){
+    uint32_t op_code = instruction->operation.op_code;
+    if(!is_arithmetic(op_code) || arg_kind(&instruction->imm[0]) != ARG_KIND_REGISTER)
+        return false;
+
+    for(uint32_t arg = 1; arg < instruction->operation.num_of_args; arg ++){
+        if(arg_in_memory(&instruction->imm[arg]))
+            return false;
+    }
+
+    return op_code != OP_DIV || (arg_is_constant(&instruction->imm[2]) && instruction->imm[2].imm != 0);
+}
+
+//-------------------------------COMPARISONS-------------------------------
+
+// Outcomes, on which branch is taken
+static uint32_t branch_outcomes(uint32_t op_code){
+    switch(op_code){
+        case OP_BNE: return OUTCOME_LT | OUTCOME_GT;
+        case OP_BEQ: return OUTCOME_EQ;
+        case OP_BGT: return OUTCOME_GT;
+        case OP_BLT: return OUTCOME_LT;
+        case OP_BGE: return OUTCOME_EQ | OUTCOME_GT;
+        case OP_BLE: return OUTCOME_LT | OUTCOME_EQ;
+        default:     return 0;
+    }
+}
+
+static uint32_t inverted_branch(uint32_t op_code){
+    switch(op_code){
+        case OP_BNE: return OP_BEQ;
+        case OP_BEQ: return OP_BNE;
+        case OP_BGT: return OP_BLE;
+        case OP_BLT: return OP_BGE;
+        case OP_BGE: return OP_BLT;
+        default:     return OP_BGT;
+    }
+}
+
+// Outcomes of comparison with swapped operands
+static uint32_t mirror_outcomes(uint32_t outcomes){
+    return (outcomes & OUTCOME_EQ) | ((outcomes & OUTCOME_LT) ? OUTCOME_GT : 0) |
+           ((outcomes & OUTCOME_GT) ? OUTCOME_LT : 0);
+}
+
+static uint32_t compare_values(uint32_t value1, uint32_t value2){
+    if(value1 < value2)
+        return OUTCOME_LT;
+    return value1 == value2 ? OUTCOME_EQ : OUTCOME_GT;
+}
+
+//-------------------------------LAYOUT-------------------------------
+
+static void optimizer_alloc_arrays(Optimizer* optimizer, uint32_t count){
+    free(optimizer->marks);
+    free(optimizer->removed);
+    free(optimizer->new_index);
+
+    optimizer->marks = (uint8_t*)optimizer_calloc(count, sizeof(uint8_t));
+    optimizer->removed = (bool*)optimizer_calloc(count, sizeof(bool));
+    optimizer->new_index = (uint32_t*)optimizer_calloc(count, sizeof(uint32_t));
+}
+
+static void mark_program(Optimizer* optimizer){
+    TextInstruction* instruction_list = optimizer->program->text_instruction_list;
+    uint32_t count = optimizer->program->count;
+
+    memset(optimizer->marks, 0, count);
+    optimizer->marks[0] |= MARK_ROOT;
+    if(optimizer->entry != NO_INDEX)
+        optimizer->marks[optimizer->entry] |= MARK_ROOT;
+
+    for(uint32_t i = 0; i < count; i ++){
+        int arg = target_arg(&instruction_list[i]);
+        if(arg >= 0)
+            optimizer->marks[target_index(&instruction_list[i], arg)] |= MARK_TARGET;
+
+        if(instruction_info(&instruction_list[i])->flow == FLOW_CALL && i + 1 < count)
+            optimizer->marks[i + 1] |= MARK_RETURN_SITE;
+    }
+}
+
+// Removed instructions are dropped, their labels and uses move to next kept instruction
+static void compact_program(Optimizer* optimizer){
+    TextInstruction* instruction_list = optimizer->program->text_instruction_list;
+    uint32_t count = optimizer->program->count;
+    uint32_t kept = 0;
+
+    for(uint32_t i = 0; i < count; i ++){
+        optimizer->new_index[i] = kept;
+        if(!optimizer->removed[i])
+            instruction_list[kept ++] = instruction_list[i];
+        optimizer->removed[i] = false;
+    }
+    optimizer->new_index[count] = kept;
+
+    if(kept == count)
+        return;
+
+    LabelTable* label_table = optimizer->label_table;
+    for(uint32_t i = 0; i < label_table->count; i ++){
+        Label* label = &label_table->label_list[i];
+        if(label->address != LABEL_UNDEFINED)
+            label->address = optimizer->new_index[label->address / BIN_INSTRUCTION_SIZE] * BIN_INSTRUCTION_SIZE;
+    }
+
+    for(uint32_t i = 0; i < kept; i ++){
+        TextInstruction* instruction = &instruction_list[i];
+        int target = target_arg(instruction);
+
+        for(int arg = 0; arg < (int)instruction->operation.num_of_args; arg ++){
+            TextInstructionArg* instruction_arg = &instruction->imm[arg];
+            Label* label = instruction_arg->label ? &label_table->label_list[instruction_arg->label - 1] : NULL;
+
+            if(label && label->address != LABEL_UNDEFINED)
+                instruction_arg->imm = (int32_t)label->address;
+            else if(arg == target)
+                instruction_arg->imm = (int32_t)(optimizer->new_index[target_index(instruction, arg)] *
+                                                 BIN_INSTRUCTION_SIZE);
+        }
+    }
+
+    if(optimizer->entry != NO_INDEX)
+        optimizer->entry = optimizer->new_index[optimizer->entry];
+
+    optimizer->program->count = kept;
+    optimizer->changed = true;
+}
+
+static uint32_t next_kept(Optimizer* optimizer, uint32_t index){
+    do{
+        index ++;
+    }while(index < optimizer->program->count && optimizer->removed[index]);
+    return index;
+}
+
+// Instructions (from, to] are entered only by fallthrough
+static bool is_straight_line(Optimizer* optimizer, uint32_t from, uint32_t to){
+    for(uint32_t i = from + 1; i <= to; i ++){
+        if(optimizer->marks[i])
+            return false;
+    }
+    return true;
+}
+
+//-------------------------------CFG-------------------------------
+
+typedef struct BasicBlock{
+    uint32_t start;
+    // One past last instruction
+    uint32_t end;
+}BasicBlock;
+
+typedef struct ControlFlowGraph{
+    BasicBlock* block_list;
+    uint32_t count;
+    // Block of every instruction
+    uint32_t* block_of;
+}ControlFlowGraph;
+
+// Blocks start at marked instructions and after every control flow instruction
+static void cfg_build(Optimizer* optimizer, ControlFlowGraph* cfg){
+    TextInstruction* instruction_list = optimizer->program->text_instruction_list;
+    uint32_t count = optimizer->program->count;
+
+    cfg->block_list = (BasicBlock*)optimizer_calloc(count, sizeof(BasicBlock));
+    cfg->block_of = (uint32_t*)optimizer_calloc(count, sizeof(uint32_t));
+    cfg->count = 0;
+
+    for(uint32_t i = 0; i < count; i ++){
+        if(i == 0 || optimizer->marks[i] || instruction_info(&instruction_list[i - 1])->flow != FLOW_NEXT){
+            if(cfg->count > 0)
+                cfg->block_list[cfg->count - 1].end = i;
+            cfg->block_list[cfg->count ++].start = i;
+        }
+        cfg->block_of[i] = cfg->count - 1;
+    }
+    cfg->block_list[cfg->count - 1].end = count;
+}
+
+static void cfg_free(ControlFlowGraph* cfg){
+    free(cfg->block_list);
+    free(cfg->block_of);
+    cfg->block_list = NULL;
+    cfg->block_of = NULL;
+}
+
+//-------------------------------CONSTANTS-------------------------------
+
+typedef enum ValueKind{
+    // Block isn't reached yet
+    VALUE_UNDEFINED,
+    VALUE_CONSTANT,
+    VALUE_UNKNOWN
+}ValueKind;
+
+typedef struct RegisterValue{
+    ValueKind kind;
+    uint32_t value;
+}RegisterValue;
+
+typedef struct RegisterState{
+    RegisterValue regs[NUM_OF_REGISTERS];
+}RegisterState;
+
+static void state_set_unknown(RegisterState* state){
+    for(uint32_t reg = 0; reg < NUM_OF_REGISTERS; reg ++){
+        state->regs[reg].kind = VALUE_UNKNOWN;
+        state->regs[reg].value = 0;
+    }
+}
+
+// Returns true if state is changed
+static bool state_meet(RegisterState* state, const RegisterState* incoming){
+    bool changed = false;
+
+    for(uint32_t reg = 0; reg < NUM_OF_REGISTERS; reg ++){
+        RegisterValue* value = &state->regs[reg];
+        const RegisterValue* incoming_value = &incoming->regs[reg];
+
+        if(incoming_value->kind == VALUE_UNDEFINED || value->kind == VALUE_UNKNOWN)
+            continue;
+
+        if(value->kind == VALUE_UNDEFINED){
+            *value = *incoming_value;
+            changed = true;
+        }
+        else if(incoming_value->kind == VALUE_UNKNOWN || incoming_value->value != value->value){
+            value->kind = VALUE_UNKNOWN;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+static bool arg_value(const RegisterState* state, const TextInstructionArg* arg, uint32_t* value){
+    if(arg_is_constant(arg)){
+        *value = (uint32_t)arg->imm;
+        return true;
+    }
+
+    if(arg_kind(arg) == ARG_KIND_REGISTER && state->regs[arg->imm].kind == VALUE_CONSTANT){
+        *value = state->regs[arg->imm].value;
+        return true;
+    }
+    return false;
+}
+
+// Result of arithmetic instruction, false if it isn't known at assembly time
+static bool evaluate_arithmetic(const RegisterState* state, const TextInstruction* instruction, uint32_t* result){
+    uint32_t op_code = instruction->operation.op_code;
+    uint32_t value1 = 0;
+    uint32_t value2 = 0;
+
+    if(!arg_value(state, &instruction->imm[1], &value1))
+        return false;
+    if(instruction->operation.num_of_args == 3 && !arg_value(state, &instruction->imm[2], &value2))
+        return false;
+
+    switch(op_code){
+        case OP_MOV: *result = value1;           return true;
+        case OP_ADD: *result = value1 + value2;  return true;
+        case OP_SUB: *result = value1 - value2;  return true;
+        case OP_MUL: *result = value1 * value2;  return true;
+        case OP_DIV:
+            // Division by zero is left to fail at run time
+            if(value2 == 0)
+                return false;
+            *result = value1 / value2;
+            return true;
+        case OP_SQR:
+            *result = (uint32_t)sqrt((double)value1 + 0.5);
+            return true;
+        default:
+            return false;
+    }
+}
+
+static BranchDecision evaluate_branch(const RegisterState* state, const TextInstruction* instruction){
+    uint32_t value1 = 0;
+    uint32_t value2 = 0;
+
+    if(!arg_value(state, &instruction->imm[0], &value1) || !arg_value(state, &instruction->imm[1], &value2))
+        return BRANCH_UNKNOWN;
+
+    bool taken = branch_outcomes(instruction->operation.op_code) & compare_values(value1, value2);
+    return taken ? BRANCH_TAKEN : BRANCH_NOT_TAKEN;
+}
+
+static void state_transfer(RegisterState* state, const TextInstruction* instruction){
+    uint32_t defines = instruction_defines(instruction);
+    if(!defines)
+        return;
+
+    uint32_t reg = (uint32_t)__builtin_ctz(defines);
+    uint32_t result = 0;
+
+    if(is_arithmetic(instruction->operation.op_code) && evaluate_arithmetic(state, instruction, &result)){
+        state->regs[reg].kind = VALUE_CONSTANT;
+        state->regs[reg].value = result;
+    }
+    else{
+        for(uint32_t mask = defines; mask != 0; mask &= mask - 1)
+            state->regs[__builtin_ctz(mask)].kind = VALUE_UNKNOWN;
+    }
+}
+
+typedef struct ConstantsPass{
+    ControlFlowGraph cfg;
+    RegisterState* state_list;
+    bool* reached_list;
+
+    uint32_t* worklist;
+    bool* in_worklist;
+    uint32_t worklist_size;
+}ConstantsPass;
+
+static void constants_propagate(ConstantsPass* pass, uint32_t instruction, const RegisterState* state){
+    uint32_t block = pass->cfg.block_of[instruction];
+
+    if(state_meet(&pass->state_list[block], state) || !pass->reached_list[block]){
+        pass->reached_list[block] = true;
+        if(!pass->in_worklist[block]){
+            pass->in_worklist[block] = true;
+            pass->worklist[pass->worklist_size ++] = block;
+        }
+    }
+}
+
+static void constants_solve(Optimizer* optimizer, ConstantsPass* pass){
+    TextInstruction* instruction_list = optimizer->program->text_instruction_list;
+    uint32_t count = optimizer->program->count;
+
+    RegisterState unknown_state;
+    state_set_unknown(&unknown_state);
+
+    constants_propagate(pass, 0, &unknown_state);
+    if(optimizer->entry != NO_INDEX)
+        constants_propagate(pass, optimizer->entry, &unknown_state);
+
+    while(pass->worklist_size > 0){
+        uint32_t block = pass->worklist[-- pass->worklist_size];
+        pass->in_worklist[block] = false;
+
+        BasicBlock* basic_block = &pass->cfg.block_list[block];
+        RegisterState state = pass->state_list[block];
+        for(uint32_t i = basic_block->start; i < basic_block->end; i ++){
+            state_transfer(&state, &instruction_list[i]);
+        }
+
+        TextInstruction* last = &instruction_list[basic_block->end - 1];
+        int arg = target_arg(last);
+        BranchDecision decision = BRANCH_UNKNOWN;
+
+        switch(instruction_info(last)->flow){
+            case FLOW_NEXT:
+                if(basic_block->end < count)
+                    constants_propagate(pass, basic_block->end, &state);
+                break;
+
+            case FLOW_BRANCH:
+                decision = evaluate_branch(&state, last);
+                if(decision != BRANCH_NOT_TAKEN)
+                    constants_propagate(pass, target_index(last, arg), &state);
+                if(decision != BRANCH_TAKEN)
+                    constants_propagate(pass, basic_block->end, &state);
+                break;
+
+            case FLOW_JUMP:
+                constants_propagate(pass, target_index(last, arg), &state);
+                break;
+
+            // Callee can change any register before return
+            case FLOW_CALL:
+                constants_propagate(pass, target_index(last, arg), &state);
+                if(basic_block->end < count)
+                    constants_propagate(pass, basic_block->end, &unknown_state);
+                break;
+
+            case FLOW_RETURN:
+            case FLOW_HALT:
+                break;
+        }
+    }
+}
+
+static void simplify_arithmetic(Optimizer* optimizer, TextInstruction* instruction){
+    uint32_t op_code = instruction->operation.op_code;
+    TextInstructionArg* arg1 = &instruction->imm[1];
+    TextInstructionArg* arg2 = &instruction->imm[2];
+
+    bool arg1_constant = arg_is_constant(arg1);
+    bool arg2_constant = arg_is_constant(arg2);
+    uint32_t value1 = (uint32_t)arg1->imm;
+    uint32_t value2 = (uint32_t)arg2->imm;
+
+    // x + 0, 0 + x, x - 0, x * 1, 1 * x, x / 1 are moves of x
+    if(arg2_constant && (((op_code == OP_ADD || op_code == OP_SUB) && value2 == 0) ||
+                         ((op_code == OP_MUL || op_code == OP_DIV) && value2 == 1))){
+        set_operation(instruction, OP_MOV);
+        optimizer->changed = true;
+    }
+    else if((op_code == OP_ADD && arg1_constant && value1 == 0) || (op_code == OP_MUL && arg1_constant && value1 == 1)){
+        *arg1 = *arg2;
+        set_operation(instruction, OP_MOV);
+        optimizer->changed = true;
+    }
+    // x * 0 is 0, if x read can't fail
+    else if(op_code == OP_MUL && ((arg1_constant && value1 == 0 && !arg_in_memory(arg2)) ||
+                                  (arg2_constant && value2 == 0 && !arg_in_memory(arg1)))){
+        set_immediate(arg1, 0);
+        set_operation(instruction, OP_MOV);
+        optimizer->changed = true;
+    }
+}
+
+static void rewrite_instruction(Optimizer* optimizer, const RegisterState* state, uint32_t index){
+    TextInstruction* instruction = &optimizer->program->text_instruction_list[index];
+    const InstructionSet* info = instruction_info(instruction);
+    uint32_t op_code = instruction->operation.op_code;
+
+    // Registers with known values are replaced by immediates, so writes of them become dead
+    for(int arg = 0; arg < info->num_of_args; arg ++){
+        uint32_t value = 0;
+        if(info->arg_roles[arg] == ARG_SOURCE && arg_kind(&instruction->imm[arg]) == ARG_KIND_REGISTER &&
+           arg_value(state, &instruction->imm[arg], &value)){
+            set_immediate(&instruction->imm[arg], value);
+            optimizer->changed = true;
+        }
+    }
+
+    if(is_arithmetic(op_code)){
+        uint32_t result = 0;
+        if(op_code != OP_MOV && evaluate_arithmetic(state, instruction, &result)){
+            set_immediate(&instruction->imm[1], result);
+            set_operation(instruction, OP_MOV);
+            optimizer->changed = true;
+        }
+        else if(op_code != OP_MOV){
+            simplify_arithmetic(optimizer, instruction);
+        }
+
+        if(instruction->operation.op_code == OP_MOV && arg_kind(&instruction->imm[0]) == ARG_KIND_REGISTER &&
+           args_equal(&instruction->imm[0], &instruction->imm[1])){
+            optimizer->removed[index] = true;
+        }
+    }
+    else if(info->flow == FLOW_BRANCH){
+        switch(evaluate_branch(state, instruction)){
+            case BRANCH_TAKEN:
+                instruction->imm[0] = instruction->imm[2];
+                set_operation(instruction, OP_BAW);
+                optimizer->changed = true;
+                break;
+            case BRANCH_NOT_TAKEN:
+                optimizer->removed[index] = true;
+                break;
+            case BRANCH_UNKNOWN:
+                break;
+        }
+    }
+}
+
+// str, which value isn't loaded back yet in current block
+typedef struct PendingStore{
+    uint32_t index;
+    uint32_t reg;
+    RegisterValue value;
+    // Register is written after str
+    bool clobbered;
+}PendingStore;
+
+typedef struct PendingStores{
+    PendingStore store_list[OPTIMIZER_MAX_PENDING_STORES];
+    uint32_t count;
+}PendingStores;
+
+// str xA ... ldr xB pair in one block without memory args between is replaced by mov xB of stored value,
+// inner pairs are balanced, so stack positions of other data don't matter
+static void forward_stored_value(Optimizer* optimizer, PendingStores* pending, const RegisterState* state,
+                                 uint32_t index){
+    TextInstruction* instruction = &optimizer->program->text_instruction_list[index];
+    uint32_t op_code = instruction->operation.op_code;
+
+    for(uint32_t arg = 0; arg < instruction->operation.num_of_args; arg ++){
+        if(arg_in_memory(&instruction->imm[arg]))
+            pending->count = 0;
+    }
+    // Host function can write any memory inside stack
+    if(op_code == OP_HCL)
+        pending->count = 0;
+
+    if(op_code == OP_STR){
+        // Older stores are forgotten, loads, which reach them, are kept as is
+        if(pending->count == OPTIMIZER_MAX_PENDING_STORES)
+            pending->count = 0;
+
+        uint32_t reg = (uint32_t)instruction->imm[0].imm;
+        PendingStore* store = &pending->store_list[pending->count ++];
+        store->index = index;
+        store->reg = reg;
+        store->value = state->regs[reg];
+        store->clobbered = false;
+        return;
+    }
+
+    if(op_code == OP_LDR && pending->count > 0){
+        PendingStore* store = &pending->store_list[-- pending->count];
+        uint32_t reg = (uint32_t)instruction->imm[0].imm;
+
+        if(store->value.kind == VALUE_CONSTANT){
+            set_operation(instruction, OP_MOV);
+            set_immediate(&instruction->imm[1], store->value.value);
+        }
+        else if(!store->clobbered){
+            set_operation(instruction, OP_MOV);
+            instruction->imm[1] = instruction->imm[0];
+            instruction->imm[1].imm = (int32_t)store->reg;
+            if(store->reg == reg)
+                optimizer->removed[index] = true;
+        }
+        else{
+            return;
+        }
+
+        optimizer->removed[store->index] = true;
+        optimizer->changed = true;
+    }
+
+    uint32_t defines = instruction_defines(instruction);
+    for(uint32_t i = 0; i < pending->count; i ++){
+        if(defines & (1u << pending->store_list[i].reg))
+            pending->store_list[i].clobbered = true;
+    }
+}
+
+// Forward dataflow over CFG, entry state of roots and return sites is unknown.
+// Edges of branches on constants aren't followed, blocks, which are never reached, are removed.
+static void propagate_constants(Optimizer* optimizer){
+    TextInstruction* instruction_list = optimizer->program->text_instruction_list;
+
+    ConstantsPass pass = {};
+    mark_program(optimizer);
+    cfg_build(optimizer, &pass.cfg);
+
+    pass.state_list = (RegisterState*)optimizer_calloc(pass.cfg.count, sizeof(RegisterState));
+    pass.reached_list = (bool*)optimizer_calloc(pass.cfg.count, sizeof(bool));
+    pass.worklist = (uint32_t*)optimizer_calloc(pass.cfg.count, sizeof(uint32_t));
+    pass.in_worklist = (bool*)optimizer_calloc(pass.cfg.count, sizeof(bool));
+
+    constants_solve(optimizer, &pass);
+
+    for(uint32_t block = 0; block < pass.cfg.count; block ++){
+        BasicBlock* basic_block = &pass.cfg.block_list[block];
+
+        if(!pass.reached_list[block]){
+            for(uint32_t i = basic_block->start; i < basic_block->end; i ++){
+                optimizer->removed[i] = true;
+            }
+            continue;
+        }
+
+        RegisterState state = pass.state_list[block];
+        PendingStores pending;
+        pending.count = 0;
+
+        for(uint32_t i = basic_block->start; i < basic_block->end; i ++){
+            rewrite_instruction(optimizer, &state, i);
+            forward_stored_value(optimizer, &pending, &state, i);
+            if(!optimizer->removed[i])
+                state_transfer(&state, &instruction_list[i]);
+        }
+    }
+
+    free(pass.state_list);
+    free(pass.reached_list);
+    free(pass.worklist);
+    free(pass.in_worklist);
+    cfg_free(&pass.cfg);
+}
+
+//-------------------------------BRANCHES-------------------------------
+
+// Targets of jumps are followed to final target, jumps to ret and hlt are replaced by them
+static void thread_branches(Optimizer* optimizer){
+    TextInstruction* instruction_list = optimizer->program->text_instruction_list;
+    uint32_t count = optimizer->program->count;
+
+    for(uint32_t i = 0; i < count; i ++){
+        TextInstruction* instruction = &instruction_list[i];
+        int arg = target_arg(instruction);
+        if(arg < 0)
+            continue;
+
+        // Chain is limited by program size, so cycles of jumps are left as is
+        TextInstructionArg* final_target = NULL;
+        uint32_t target = target_index(instruction, arg);
+        for(uint32_t steps = 0; steps < count && instruction_list[target].operation.op_code == OP_BAW; steps ++){
+            final_target = &instruction_list[target].imm[0];
+            if(target_index(&instruction_list[target], 0) == target)
+                break;
+            target = target_index(&instruction_list[target], 0);
+        }
+
+        if(final_target && (uint32_t)final_target->imm != (uint32_t)instruction->imm[arg].imm){
+            instruction->imm[arg] = *final_target;
+            optimizer->changed = true;
+        }
+
+        uint32_t target_op_code = instruction_list[target].operation.op_code;
+        if(instruction->operation.op_code == OP_BAW && (target_op_code == OP_RET || target_op_code == OP_HLT)){
+            set_operation(instruction, target_op_code);
+            optimizer->changed = true;
+        }
+    }
+}
+
+// bX a b :next                 -> removed
+// bX a b :l1, bY a b :l2       -> second is removed or becomes baw :l2, if first decides it
+// bX a b :l1, baw :l2, :l1     -> b!X a b :l2
+// baw :l1, :l2 ... :l1 bX a b :l2  -> b!X a b (:l1 + 16), loop condition is checked at loop end
+static void simplify_branches(Optimizer* optimizer){
+    TextInstruction* instruction_list = optimizer->program->text_instruction_list;
+    uint32_t count = optimizer->program->count;
+
+    mark_program(optimizer);
+
+    for(uint32_t i = 0; i < count; i ++){
+        if(optimizer->removed[i])
+            continue;
+
+        TextInstruction* instruction = &instruction_list[i];
+        InstructionFlow flow = instruction_info(instruction)->flow;
+        if(flow != FLOW_BRANCH && flow != FLOW_JUMP)
+            continue;
+
+        int arg = target_arg(instruction);
+        uint32_t next = next_kept(optimizer, i);
+
+        bool reads_memory = flow == FLOW_BRANCH &&
+                            (arg_in_memory(&instruction->imm[0]) || arg_in_memory(&instruction->imm[1]));
+        if(reads_memory)
+            continue;
+
+        if(target_index(instruction, arg) == next){
+            optimizer->removed[i] = true;
+            optimizer->changed = true;
+            continue;
+        }
+
+        if(flow == FLOW_JUMP){
+            uint32_t target = target_index(instruction, arg);
+            TextInstruction* target_instruction = &instruction_list[target];
+
+            if(!optimizer->removed[target] && instruction_info(target_instruction)->flow == FLOW_BRANCH &&
+               target_index(target_instruction, 2) == next){
+                uint32_t line = instruction->line;
+                *instruction = *target_instruction;
+                instruction->line = line;
+
+                set_operation(instruction, inverted_branch(target_instruction->operation.op_code));
+                set_immediate(&instruction->imm[2], (target + 1) * BIN_INSTRUCTION_SIZE);
+                optimizer->marks[target + 1] |= MARK_TARGET;
+                optimizer->changed = true;
+            }
+            continue;
+        }
+
+        if(next >= count || !is_straight_line(optimizer, i, next))
+            continue;
+
+        TextInstruction* next_instruction = &instruction_list[next];
+        uint32_t next_op_code = next_instruction->operation.op_code;
+
+        if(instruction_info(next_instruction)->flow == FLOW_BRANCH){
+            uint32_t next_outcomes = branch_outcomes(next_op_code);
+            if(args_equal(&instruction->imm[0], &next_instruction->imm[1]) &&
+               args_equal(&instruction->imm[1], &next_instruction->imm[0])){
+                next_outcomes = mirror_outcomes(next_outcomes);
+            }
+            else if(!args_equal(&instruction->imm[0], &next_instruction->imm[0]) ||
+                    !args_equal(&instruction->imm[1], &next_instruction->imm[1])){
+                continue;
+            }
+
+            // Outcomes, with which execution falls through first branch
+            uint32_t outcomes = OUTCOME_ALL & ~branch_outcomes(instruction->operation.op_code);
+            if((outcomes & ~next_outcomes) == 0){
+                next_instruction->imm[0] = next_instruction->imm[2];
+                set_operation(next_instruction, OP_BAW);
+                optimizer->changed = true;
+            }
+            else if((outcomes & next_outcomes) == 0){
+                optimizer->removed[next] = true;
+                optimizer->changed = true;
+            }
+        }
+        else if(next_op_code == OP_BAW && target_index(instruction, arg) == next_kept(optimizer, next)){
+            set_operation(instruction, inverted_branch(instruction->operation.op_code));
+            instruction->imm[arg] = next_instruction->imm[0];
+            optimizer->marks[target_index(instruction, arg)] |= MARK_TARGET;
+            optimizer->removed[next] = true;
+            optimizer->changed = true;
+        }
+    }
+}
+
+//-------------------------------LIVENESS-------------------------------
+
+static uint32_t liveness_transfer(const TextInstruction* instruction, uint32_t live){
+    switch(instruction_info(instruction)->flow){
+        // Callee and caller after return can read any register
+        case FLOW_CALL:
+        case FLOW_RETURN:
+            return ALL_REGISTERS;
+        case FLOW_HALT:
+            return 0;
+        default:
+            return (live & ~instruction_defines(instruction)) | instruction_uses(instruction);
+    }
+}
+
+static uint32_t block_live_out(Optimizer* optimizer, ControlFlowGraph* cfg, uint32_t* live_in_list, uint32_t block){
+    TextInstruction* instruction_list = optimizer->program->text_instruction_list;
+    uint32_t count = optimizer->program->count;
+
+    BasicBlock* basic_block = &cfg->block_list[block];
+    TextInstruction* last = &instruction_list[basic_block->end - 1];
+    int arg = target_arg(last);
+    uint32_t live = 0;
+
+    switch(instruction_info(last)->flow){
+        case FLOW_NEXT:
+            if(basic_block->end < count)
+                live = live_in_list[block + 1];
+            break;
+        case FLOW_BRANCH:
+            live = live_in_list[cfg->block_of[target_index(last, arg)]];
+            if(basic_block->end < count)
+                live |= live_in_list[block + 1];
+            break;
+        case FLOW_JUMP:
+            live = live_in_list[cfg->block_of[target_index(last, arg)]];
+            break;
+        default:
+            break;
+    }
+    return live;
+}
+
+// Backward liveness of registers over CFG, register writes without other effects, which are never read, are removed
+static void remove_dead_writes(Optimizer* optimizer){
+    TextInstruction* instruction_list = optimizer->program->text_instruction_list;
+
+    ControlFlowGraph cfg = {};
+    mark_program(optimizer);
+    cfg_build(optimizer, &cfg);
+
+    uint32_t* live_in_list = (uint32_t*)optimizer_calloc(cfg.count, sizeof(uint32_t));
+
+    bool changed = true;
+    while(changed){
+        changed = false;
+        for(uint32_t block = cfg.count; block -- > 0;){
+            uint32_t live = block_live_out(optimizer, &cfg, live_in_list, block);
+            for(uint32_t i = cfg.block_list[block].end; i -- > cfg.block_list[block].start;){
+                live = liveness_transfer(&instruction_list[i], live);
+            }
+
+            if(live != live_in_list[block]){
+                live_in_list[block] = live;
+                changed = true;
+            }
+        }
+    }
+
+    for(uint32_t block = 0; block < cfg.count; block ++){
+        uint32_t live = block_live_out(optimizer, &cfg, live_in_list, block);
+        for(uint32_t i = cfg.block_list[block].end; i -- > cfg.block_list[block].start;){
+            TextInstruction* instruction = &instruction_list[i];
+            if(is_pure_register_write(instruction) && !(instruction_defines(instruction) & live)){
+                optimizer->removed[i] = true;
+                optimizer->changed = true;
+                continue;
+            }
+            live = liveness_transfer(instruction, live);
+        }
+    }
+
+    free(live_in_list);
+    cfg_free(&cfg);
+}
+
+//-------------------------------CALLS-------------------------------
+
+// Number of instructions before ret of function, NO_INDEX if function can't be inlined:
+// it must be short, call nothing and branch only inside itself
+static uint32_t inline_body_size(Optimizer* optimizer, uint32_t function){
+    TextInstruction* instruction_list = optimizer->program->text_instruction_list;
+    uint32_t count = optimizer->program->count;
+
+    uint32_t end = function;
+    while(end < count && end - function <= OPTIMIZER_INLINE_MAX_SIZE &&
+          instruction_list[end].operation.op_code != OP_RET){
+        end ++;
+    }
+    if(end == count || end - function > OPTIMIZER_INLINE_MAX_SIZE)
+        return NO_INDEX;
+
+    for(uint32_t i = function; i < end; i ++){
+        if(instruction_info(&instruction_list[i])->flow == FLOW_CALL)
+            return NO_INDEX;
+
+        int arg = target_arg(&instruction_list[i]);
+        if(arg >= 0 && (target_index(&instruction_list[i], arg) < function ||
+                        target_index(&instruction_list[i], arg) > end)){
+            return NO_INDEX;
+        }
+    }
+    return end - function;
+}
+
+// Copy of instruction at new place, targets inside inlined body are relocated, others are mapped by new_index
+static void place_instruction(Optimizer* optimizer, TextInstruction* placed, const TextInstruction* instruction,
+                              uint32_t body_start, uint32_t body_end, uint32_t new_body_start){
+    *placed = *instruction;
+
+    int target = target_arg(placed);
+    for(int arg = 0; arg < (int)placed->operation.num_of_args; arg ++){
+        TextInstructionArg* placed_arg = &placed->imm[arg];
+        Label* label = placed_arg->label ? &optimizer->label_table->label_list[placed_arg->label - 1] : NULL;
+        uint32_t address = (uint32_t)placed_arg->imm / BIN_INSTRUCTION_SIZE;
+
+        if(arg == target && address >= body_start && address <= body_end)
+            set_immediate(placed_arg, (new_body_start + address - body_start) * BIN_INSTRUCTION_SIZE);
+        else if(label && label->address != LABEL_UNDEFINED)
+            placed_arg->imm = (int32_t)label->address;
+        else if(arg == target)
+            placed_arg->imm = (int32_t)(optimizer->new_index[address] * BIN_INSTRUCTION_SIZE);
+    }
+}
+
+// cfn of small leaf function is replaced by copy of its body, cfn directly followed by ret becomes baw,
+// so tail recursion runs without growing call stack
+static void inline_calls(Optimizer* optimizer){
+    TextInstruction* instruction_list = optimizer->program->text_instruction_list;
+    uint32_t count = optimizer->program->count;
+
+    // Body size for inlined calls, NO_INDEX for instructions, which are kept
+    uint32_t* body_size_list = (uint32_t*)optimizer_calloc(count, sizeof(uint32_t));
+    uint32_t new_count = count;
+    bool inlined = false;
+
+    for(uint32_t i = 0; i < count; i ++){
+        TextInstruction* instruction = &instruction_list[i];
+        body_size_list[i] = NO_INDEX;
+        if(instruction->operation.op_code != OP_CFN)
+            continue;
+
+        uint32_t body_size = inline_body_size(optimizer, target_index(instruction, 0));
+        if(body_size != NO_INDEX && new_count + body_size - 1 <= optimizer->max_count){
+            body_size_list[i] = body_size;
+            new_count += body_size - 1;
+            inlined = true;
+        }
+        else if(i + 1 < count && instruction_list[i + 1].operation.op_code == OP_RET){
+            set_operation(instruction, OP_BAW);
+            optimizer->changed = true;
+        }
+    }
+
+    if(!inlined){
+        free(body_size_list);
+        return;
+    }
+
+    uint32_t position = 0;
+    for(uint32_t i = 0; i < count; i ++){
+        optimizer->new_index[i] = position;
+        position += body_size_list[i] != NO_INDEX ? body_size_list[i] : 1;
+    }
+    optimizer->new_index[count] = position;
+
+    LabelTable* label_table = optimizer->label_table;
+    for(uint32_t i = 0; i < label_table->count; i ++){
+        Label* label = &label_table->label_list[i];
+        if(label->address != LABEL_UNDEFINED)
+            label->address = optimizer->new_index[label->address / BIN_INSTRUCTION_SIZE] * BIN_INSTRUCTION_SIZE;
+    }
+
+    TextInstruction* new_instruction_list = (TextInstruction*)optimizer_calloc(new_count, sizeof(TextInstruction));
+    for(uint32_t i = 0; i < count; i ++){
+        uint32_t new_index = optimizer->new_index[i];
+
+        if(body_size_list[i] == NO_INDEX){
+            place_instruction(optimizer, &new_instruction_list[new_index], &instruction_list[i], NO_INDEX, 0, 0);
+            continue;
+        }
+
+        uint32_t function = target_index(&instruction_list[i], 0);
+        for(uint32_t j = 0; j < body_size_list[i]; j ++){
+            place_instruction(optimizer, &new_instruction_list[new_index + j], &instruction_list[function + j],
+                              function, function + body_size_list[i], new_index);
+        }
+    }
+
+    if(optimizer->entry != NO_INDEX)
+        optimizer->entry = optimizer->new_index[optimizer->entry];
+
+    free(instruction_list);
+    free(body_size_list);
+    optimizer->program->text_instruction_list = new_instruction_list;
+    optimizer->program->count = new_count;
+    optimizer->program->capacity = new_count + 1;
+
+    optimizer_alloc_arrays(optimizer, new_count);
+    optimizer->changed = true;
+}
+
+//-------------------------------PROGRAM-------------------------------
+
+static bool program_is_optimizable(TextInstructionArray* program){
+    if(program->count == 0)
+        return false;
+
+    BinInstructionArray bin_instructions_array;
+    bin_instructions_array.count = program->count;
+    bin_instructions_array.bin_instruction_list = (BinInstruction*)optimizer_calloc(program->count,
+                                                                                    sizeof(BinInstruction));
+    assemble_text_instructions_array(&bin_instructions_array, program);
+
+    VerifierError error;
+    bool verified = program_verify(bin_instructions_array.bin_instruction_list, program->count, &error);
+    free(bin_instructions_array.bin_instruction_list);
+    if(!verified)
+        return false;
+
+    // Values of rpc and cycle counter depend on code layout
+    for(uint32_t i = 0; i < program->count; i ++){
+        TextInstruction* instruction = &program->text_instruction_list[i];
+        uint32_t registers = instruction_uses(instruction) | instruction_defines(instruction);
+        for(uint32_t arg = 0; arg < instruction->operation.num_of_args; arg ++){
+            if(arg_kind(&instruction->imm[arg]) != ARG_KIND_IMMEDIATE &&
+               arg_kind(&instruction->imm[arg]) != ARG_KIND_MEMORY){
+                registers |= 1u << (uint32_t)instruction->imm[arg].imm;
+            }
+        }
+
+        if(registers & ((1u << (RPC)) | (1u << (RCC))))
+            return false;
+    }
+    return true;
+}
+
+void optimize_text_instructions(TextInstructionArray* text_instructions_array, LabelTable* label_table,
+                                const char* entry_label){
+    if(!program_is_optimizable(text_instructions_array))
+        return;
+
+    Optimizer optimizer = {};
+    optimizer.program = text_instructions_array;
+    optimizer.label_table = label_table;
+    optimizer.entry = NO_INDEX;
+
+    if(entry_label){
+        if(entry_label[0] == ':')
+            entry_label ++;
+        Label* label = label_table_find(label_table, entry_label, (uint32_t)strlen(entry_label));
+        if(label && label->address != LABEL_UNDEFINED &&
+           label->address < text_instructions_array->count * BIN_INSTRUCTION_SIZE){
+            optimizer.entry = label->address / BIN_INSTRUCTION_SIZE;
+        }
+    }
+
+    optimizer_alloc_arrays(&optimizer, text_instructions_array->count);
+    optimizer.max_count = text_instructions_array->count * OPTIMIZER_INLINE_MAX_GROWTH;
+
+    uint32_t rounds = 0;
+    do{
+        optimizer.changed = false;
+
+        inline_calls(&optimizer);
+
+        propagate_constants(&optimizer);
+        compact_program(&optimizer);
+
+        thread_branches(&optimizer);
+        simplify_branches(&optimizer);
+        compact_program(&optimizer);
+
+        remove_dead_writes(&optimizer);
+        compact_program(&optimizer);
+
+        rounds ++;
+    }while(optimizer.changed && rounds < OPTIMIZER_MAX_ROUNDS);
+
+    free(optimizer.marks);
+    free(optimizer.removed);
+    free(optimizer.new_index);
+}
@@ -0,0 +1,502 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "stack_depth/stack_depth.h"
+#include "verifier/verifier.h"
+#include "cpu_emulator/cpu.h"
+
+#define DEPTH_UNBOUNDED_HIGH INT64_MAX
+#define DEPTH_UNBOUNDED_LOW INT64_MIN
+#define CALL_DEPTH_UNBOUNDED UINT32_MAX
+
+typedef enum FunctionState{
+    FUNCTION_NEW,
+    // Callees are analyzed, call of active function is recursion
+    FUNCTION_ACTIVE,
+    FUNCTION_DONE
+}FunctionState;
+
+// Change of data stack size relative to function start
+typedef struct DepthRange{
+    int64_t low;
+    int64_t high;
+}DepthRange;
+
+typedef struct FunctionSummary{
+    FunctionState state;
+    // Range at any point of function and its callees
+    DepthRange extent;
+    // Range at ret, valid if function returns
+    DepthRange exit;
+    bool returns;
+    // Return addresses pushed by function and its callees
+    uint32_t call_depth;
+}FunctionSummary;
+
+typedef struct DepthAnalysis{
+    const BinInstruction* instruction_list;
+    uint32_t count;
+
+    // Indexed by first instruction of function
+    FunctionSummary* summary_list;
+
+    // Per instruction state of current walk, valid if its stamp is current one
+    uint32_t stamp;
+    uint32_t* stamp_list;
+    uint32_t* queued_list;
+    DepthRange* range_list;
+    uint32_t* updates_list;
+
+    uint32_t* worklist;
+    uint32_t worklist_size;
+
+    uint64_t steps_left;
+    bool exhausted;
+
+    bool recursion;
+    uint32_t recursion_address;
+}DepthAnalysis;
+
+//-------------------------------RANGES-------------------------------
+
+static int64_t high_add(int64_t high, int64_t delta){
+    if(high == DEPTH_UNBOUNDED_HIGH || delta == DEPTH_UNBOUNDED_HIGH)
+        return DEPTH_UNBOUNDED_HIGH;
+    return high + delta;
+}
+
+static int64_t low_add(int64_t low, int64_t delta){
+    if(low == DEPTH_UNBOUNDED_LOW || delta == DEPTH_UNBOUNDED_LOW)
+        return DEPTH_UNBOUNDED_LOW;
+    return low + delta;
+}
+
+static DepthRange range_add(DepthRange range, DepthRange delta){
+    DepthRange sum = {low_add(range.low, delta.low), high_add(range.high, delta.high)};
+    return sum;
+}
+
+static void range_merge(DepthRange* range, DepthRange other){
+    if(other.low < range->low)
+        range->low = other.low;
+    if(other.high > range->high)
+        range->high = other.high;
+}
+
+// Change of data stack size by instruction itself
+static int64_t instruction_depth_change(const BinInstruction* instruction){
+    switch(instruction->operation >> 24){
+        case OP_STR: return (int64_t)sizeof(uint32_t);
+        case OP_LDR: return -(int64_t)sizeof(uint32_t);
+        default:     return 0;
+    }
+}
+
+static uint32_t instruction_target(const BinInstruction* instruction){
+    const InstructionSet* info = &instruction_set[instruction->operation >> 24];
+    for(int arg = 0; arg < info->num_of_args; arg ++){
+        if(info->arg_roles[arg] == ARG_TARGET)
+            return instruction->arg_list[arg] / BIN_INSTRUCTION_SIZE;
+    }
+    return 0;
+}
+
+//-------------------------------WALK-------------------------------
+
+static void walk_start(DepthAnalysis* analysis){
+    analysis->stamp ++;
+    analysis->worklist_size = 0;
+}
+
+static void walk_push(DepthAnalysis* analysis, uint32_t instruction){
+    if(analysis->queued_list[instruction] != analysis->stamp){
+        analysis->queued_list[instruction] = analysis->stamp;
+        analysis->worklist[analysis->worklist_size ++] = instruction;
+    }
+}
+
+// False when worklist is empty or analysis is out of steps
+static bool walk_continues(DepthAnalysis* analysis){
+    if(analysis->worklist_size == 0)
+        return false;
+    if(analysis->steps_left == 0){
+        analysis->exhausted = true;
+        return false;
+    }
+    analysis->steps_left --;
+    return true;
+}
+
+static uint32_t walk_pop(DepthAnalysis* analysis){
+    uint32_t instruction = analysis->worklist[-- analysis->worklist_size];
+    analysis->queued_list[instruction] = 0;
+    return instruction;
+}
+
+// Range, which grows after STACK_DEPTH_MAX_UPDATES updates, is widened to unbounded
+static void walk_propagate(DepthAnalysis* analysis, uint32_t instruction, DepthRange range){
+    DepthRange* current = &analysis->range_list[instruction];
+
+    if(analysis->stamp_list[instruction] != analysis->stamp){
+        analysis->stamp_list[instruction] = analysis->stamp;
+        analysis->updates_list[instruction] = 0;
+        *current = range;
+        walk_push(analysis, instruction);
+        return;
+    }
+
+    DepthRange merged = *current;
+    range_merge(&merged, range);
+    if(merged.low == current->low && merged.high == current->high)
+        return;
+
+    if(++ analysis->updates_list[instruction] > STACK_DEPTH_MAX_UPDATES){
+        if(merged.low < current->low)
+            merged.low = DEPTH_UNBOUNDED_LOW;
+        if(merged.high > current->high)
+            merged.high = DEPTH_UNBOUNDED_HIGH;
+    }
+
+    *current = merged;
+    walk_push(analysis, instruction);
+}
+
+//-------------------------------FUNCTIONS-------------------------------
+
+// Targets of calls in instructions reachable from function start without passing ret
+static uint32_t collect_callees(DepthAnalysis* analysis, uint32_t function, uint32_t** callee_list){
+    const BinInstruction* instruction_list = analysis->instruction_list;
+    uint32_t callees_count = 0;
+    uint32_t capacity = 16;
+
+    *callee_list = (uint32_t*)malloc(capacity * sizeof(uint32_t));
+    if(!*callee_list){
+        fprintf(stderr, "Error: Cannot allocate stack depth analysis memory!\n");
+        abort();
+    }
+
+    walk_start(analysis);
+    analysis->stamp_list[function] = analysis->stamp;
+    walk_push(analysis, function);
+
+    while(walk_continues(analysis)){
+        uint32_t i = walk_pop(analysis);
+        const BinInstruction* instruction = &instruction_list[i];
+        uint32_t next_list[2];
+        uint32_t next_count = 0;
+
+        switch(instruction_set[instruction->operation >> 24].flow){
+            case FLOW_NEXT:
+                next_list[next_count ++] = i + 1;
+                break;
+            case FLOW_BRANCH:
+                next_list[next_count ++] = instruction_target(instruction);
+                next_list[next_count ++] = i + 1;
+                break;
+            case FLOW_JUMP:
+                next_list[next_count ++] = instruction_target(instruction);
+                break;
+            case FLOW_CALL:
+                if(callees_count == capacity){
+                    capacity *= 2;
+                    uint32_t* new_list = (uint32_t*)realloc(*callee_list, capacity * sizeof(uint32_t));
+                    if(!new_list){
+                        fprintf(stderr, "Error: Cannot allocate stack depth analysis memory!\n");
+                        abort();
+                    }
+                    *callee_list = new_list;
+                }
+                (*callee_list)[callees_count ++] = instruction_target(instruction);
+                next_list[next_count ++] = i + 1;
+                break;
+            case FLOW_RETURN:
+            case FLOW_HALT:
+                break;
+        }
+
+        for(uint32_t j = 0; j < next_count; j ++){
+            if(analysis->stamp_list[next_list[j]] != analysis->stamp){
+                analysis->stamp_list[next_list[j]] = analysis->stamp;
+                walk_push(analysis, next_list[j]);
+            }
+        }
+    }
+    return callees_count;
+}
+
+// Forward dataflow of data stack range over function, calls are replaced by summaries of callees
+static void compute_summary(DepthAnalysis* analysis, uint32_t function){
+    const BinInstruction* instruction_list = analysis->instruction_list;
+    FunctionSummary* summary = &analysis->summary_list[function];
+
+    DepthRange start = {0, 0};
+    summary->extent = start;
+    summary->returns = false;
+    summary->call_depth = 0;
+
+    walk_start(analysis);
+    walk_propagate(analysis, function, start);
+
+    while(walk_continues(analysis)){
+        uint32_t i = walk_pop(analysis);
+        const BinInstruction* instruction = &instruction_list[i];
+
+        DepthRange range = analysis->range_list[i];
+        int64_t change = instruction_depth_change(instruction);
+        range.low = low_add(range.low, change);
+        range.high = high_add(range.high, change);
+        range_merge(&summary->extent, range);
+
+        switch(instruction_set[instruction->operation >> 24].flow){
+            case FLOW_NEXT:
+                walk_propagate(analysis, i + 1, range);
+                break;
+
+            case FLOW_BRANCH:
+                walk_propagate(analysis, instruction_target(instruction), range);
+                walk_propagate(analysis, i + 1, range);
+                break;
+
+            case FLOW_JUMP:
+                walk_propagate(analysis, instruction_target(instruction), range);
+                break;
+
+            case FLOW_CALL:{
+                FunctionSummary* callee = &analysis->summary_list[instruction_target(instruction)];
+
+                // Callee in recursion has no summary yet
+                DepthRange unbounded = {DEPTH_UNBOUNDED_LOW, DEPTH_UNBOUNDED_HIGH};
+                bool done = callee->state == FUNCTION_DONE;
+                DepthRange extent = done ? callee->extent : unbounded;
+                DepthRange exit = done ? callee->exit : unbounded;
+                uint32_t call_depth = done ? callee->call_depth : CALL_DEPTH_UNBOUNDED;
+
+                range_merge(&summary->extent, range_add(range, extent));
+                if(call_depth == CALL_DEPTH_UNBOUNDED)
+                    summary->call_depth = CALL_DEPTH_UNBOUNDED;
+                else if(call_depth + 1 > summary->call_depth)
+                    summary->call_depth = call_depth + 1;
+
+                if(!done || callee->returns)
+                    walk_propagate(analysis, i + 1, range_add(range, exit));
+                break;
+            }
+
+            case FLOW_RETURN:
+                if(!summary->returns)
+                    summary->exit = range;
+                else
+                    range_merge(&summary->exit, range);
+                summary->returns = true;
+                break;
+
+            case FLOW_HALT:
+                break;
+        }
+    }
+}
+
+// Depth first over call graph, so callees have summaries before their callers
+static void analyze_function(DepthAnalysis* analysis, uint32_t function){
+    FunctionSummary* summary = &analysis->summary_list[function];
+
+    if(summary->state == FUNCTION_DONE || analysis->exhausted)
+        return;
+    if(summary->state == FUNCTION_ACTIVE){
+        if(!analysis->recursion)
+            analysis->recursion_address = function * BIN_INSTRUCTION_SIZE;
+        analysis->recursion = true;
+        return;
+    }
+
+    summary->state = FUNCTION_ACTIVE;
+
+    uint32_t* callee_list = NULL;
+    uint32_t callees_count = collect_callees(analysis, function, &callee_list);
+    for(uint32_t i = 0; i < callees_count; i ++){
+        analyze_function(analysis, callee_list[i]);
+    }
+    free(callee_list);
+
+    compute_summary(analysis, function);
+    summary->state = FUNCTION_DONE;
+}
+
+//-------------------------------PROGRAM-------------------------------
+
+typedef struct MemoryWrites{
+    // Program has str, ldr or writes into memory
+    bool changes_data;
+    // Write by address in register
+    bool indirect;
+    // Bulk write of size from register or memory
+    bool unknown_size;
+    // End of highest write by immediate address
+    uint64_t direct_end;
+}MemoryWrites;
+
+static void scan_memory_writes(const BinInstruction* instruction_list, uint32_t count, MemoryWrites* writes){
+    writes->changes_data = false;
+    writes->indirect = false;
+    writes->unknown_size = false;
+    writes->direct_end = 0;
+
+    for(uint32_t i = 0; i < count; i ++){
+        const BinInstruction* instruction = &instruction_list[i];
+        const InstructionSet* info = &instruction_set[instruction->operation >> 24];
+
+        if(instruction_depth_change(instruction) != 0)
+            writes->changes_data = true;
+
+        for(int arg = 0; arg < info->num_of_args; arg ++){
+            if(!(instruction->operation & ARG_FLAG_MEMORY(arg)))
+                continue;
+
+            // Vector instructions write only inside stack, bulk ones write size bytes from arg 2
+            uint64_t size = sizeof(uint32_t);
+            if(info->arg_roles[arg] == ARG_DESTINATION_ADDRESS){
+                uint32_t op_code = instruction->operation >> 24;
+                if(op_code != OP_BMV && op_code != OP_BFL)
+                    continue;
+
+                if(instruction->operation & (ARG_FLAG_MEMORY(2) | ARG_FLAG_REGISTER(2)))
+                    writes->unknown_size = true;
+                size = instruction->arg_list[2];
+            }
+            else if(info->arg_roles[arg] != ARG_DESTINATION){
+                continue;
+            }
+
+            writes->changes_data = true;
+            if(instruction->operation & ARG_FLAG_REGISTER(arg)){
+                writes->indirect = true;
+            }
+            else{
+                uint64_t end = (uint64_t)instruction->arg_list[arg] + size;
+                if(end > writes->direct_end)
+                    writes->direct_end = end;
+            }
+        }
+    }
+}
+
+static void* analysis_calloc(size_t count, size_t size){
+    void* memory = calloc(count + 1, size);
+    if(!memory){
+        fprintf(stderr, "Error: Cannot allocate stack depth analysis memory!\n");
+        abort();
+    }
+    return memory;
+}
+
+static void data_stack_bound(DepthAnalysis* analysis, DepthRange extent, uint32_t data_size, StackDepth* depth){
+    MemoryWrites writes;
+    scan_memory_writes(analysis->instruction_list, analysis->count, &writes);
+
+    depth->data_bounded = false;
+    depth->data_stack_size = 0;
+
+    if(!writes.changes_data){
+        depth->data_bounded = true;
+        depth->data_stack_size = data_size;
+        return;
+    }
+    if(writes.indirect){
+        depth->data_reason = "memory is written by address from register";
+        return;
+    }
+    if(writes.unknown_size){
+        depth->data_reason = "memory range of size from register is written";
+        return;
+    }
+    if(extent.high == DEPTH_UNBOUNDED_HIGH){
+        depth->data_reason = analysis->recursion ? "data stack size depends on recursion depth"
+                                                 : "data stack grows in loop";
+        return;
+    }
+
+    int64_t size = (int64_t)data_size + extent.high;
+
+    // Write by address can extend stack, then str pushes above it
+    if(writes.direct_end > 0){
+        if(extent.low == DEPTH_UNBOUNDED_LOW){
+            depth->data_reason = "data stack shrinks in loop below memory written by address";
+            return;
+        }
+        int64_t extended = (int64_t)writes.direct_end + extent.high - extent.low;
+        if(extended > size)
+            size = extended;
+    }
+
+    if(size > UINT32_MAX){
+        depth->data_reason = "data stack is larger than address space";
+        return;
+    }
+
+    depth->data_bounded = true;
+    depth->data_stack_size = (uint32_t)(size > 0 ? size : 0);
+}
+
+void stack_depth_analyze(const BinInstruction* instruction_list, uint32_t count, uint32_t entry_point,
+                         uint32_t data_size, StackDepth* depth){
+    depth->data_bounded = false;
+    depth->data_stack_size = 0;
+    depth->data_reason = NULL;
+    depth->calls_bounded = false;
+    depth->call_stack_size = 0;
+    depth->calls_reason = NULL;
+    depth->recursion = false;
+    depth->recursion_address = 0;
+
+    VerifierError error;
+    if(count == 0 || !program_verify(instruction_list, count, &error) ||
+       entry_point % BIN_INSTRUCTION_SIZE != 0 || entry_point / BIN_INSTRUCTION_SIZE >= count){
+        depth->data_reason = "program is rejected by verifier";
+        depth->calls_reason = depth->data_reason;
+        return;
+    }
+
+    DepthAnalysis analysis = {};
+    analysis.instruction_list = instruction_list;
+    analysis.count = count;
+    analysis.summary_list = (FunctionSummary*)analysis_calloc(count, sizeof(FunctionSummary));
+    analysis.stamp_list = (uint32_t*)analysis_calloc(count, sizeof(uint32_t));
+    analysis.queued_list = (uint32_t*)analysis_calloc(count, sizeof(uint32_t));
+    analysis.range_list = (DepthRange*)analysis_calloc(count, sizeof(DepthRange));
+    analysis.updates_list = (uint32_t*)analysis_calloc(count, sizeof(uint32_t));
+    analysis.worklist = (uint32_t*)analysis_calloc(count, sizeof(uint32_t));
+    analysis.steps_left = (uint64_t)count * STACK_DEPTH_MAX_STEPS;
+
+    uint32_t entry = entry_point / BIN_INSTRUCTION_SIZE;
+    analyze_function(&analysis, entry);
+
+    FunctionSummary* summary = &analysis.summary_list[entry];
+    DepthRange extent = summary->extent;
+    uint32_t call_depth = summary->call_depth;
+
+    if(analysis.exhausted){
+        depth->data_reason = "program is too large for analysis";
+        depth->calls_reason = depth->data_reason;
+    }
+    else if(analysis.recursion || call_depth == CALL_DEPTH_UNBOUNDED){
+        depth->calls_reason = "recursion";
+        depth->recursion = true;
+        depth->recursion_address = analysis.recursion_address;
+    }
+    else{
+        depth->calls_bounded = true;
+        depth->call_stack_size = call_depth;
+    }
+
+    if(!analysis.exhausted)
+        data_stack_bound(&analysis, extent, data_size, depth);
+
+    free(analysis.summary_list);
+    free(analysis.stamp_list);
+    free(analysis.queued_list);
+    free(analysis.range_list);
+    free(analysis.updates_list);
+    free(analysis.worklist);
+}
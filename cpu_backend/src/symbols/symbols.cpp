@@ -0,0 +1,216 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "symbols/symbols.h"
+
+//---------------------------------INIT---------------------------------
+
+void symbol_map_init(SymbolMap* symbol_map){
+    symbol_map->symbols_count = 0;
+    symbol_map->symbols_capacity = SYMBOL_MAP_INIT_SIZE;
+    symbol_map->symbol_list = (Symbol*)calloc(symbol_map->symbols_capacity, sizeof(Symbol));
+
+    symbol_map->lines_count = 0;
+    symbol_map->lines_capacity = SYMBOL_MAP_INIT_SIZE;
+    symbol_map->line_list = (SourceLine*)calloc(symbol_map->lines_capacity, sizeof(SourceLine));
+
+    if(!symbol_map->symbol_list || !symbol_map->line_list){
+        fprintf(stderr, "Error: Cannot allocate symbol map!\n");
+        abort();
+    }
+}
+
+void symbol_map_free(SymbolMap* symbol_map){
+    for(uint32_t i = 0; i < symbol_map->symbols_count; i ++){
+        free(symbol_map->symbol_list[i].name);
+    }
+    free(symbol_map->symbol_list);
+    free(symbol_map->line_list);
+
+    symbol_map->symbol_list = NULL;
+    symbol_map->line_list = NULL;
+    symbol_map->symbols_count = 0;
+    symbol_map->lines_count = 0;
+}
+
+//---------------------------------FILLING---------------------------------
+
+void symbol_map_add_symbol(SymbolMap* symbol_map, const char* name, uint32_t name_size, uint32_t address){
+    if(symbol_map->symbols_count == symbol_map->symbols_capacity){
+        symbol_map->symbols_capacity *= 2;
+        symbol_map->symbol_list = (Symbol*)realloc(symbol_map->symbol_list,
+                                                   symbol_map->symbols_capacity * sizeof(Symbol));
+        if(!symbol_map->symbol_list){
+            fprintf(stderr, "Error: Cannot reallocate symbol map!\n");
+            abort();
+        }
+    }
+
+    Symbol* symbol = &symbol_map->symbol_list[symbol_map->symbols_count ++];
+    symbol->address = address;
+    symbol->name_size = name_size;
+    symbol->name = (char*)calloc(name_size + 1, sizeof(char));
+    memcpy(symbol->name, name, name_size);
+}
+
+void symbol_map_add_line(SymbolMap* symbol_map, uint32_t address, uint32_t line){
+    if(symbol_map->lines_count == symbol_map->lines_capacity){
+        symbol_map->lines_capacity *= 2;
+        symbol_map->line_list = (SourceLine*)realloc(symbol_map->line_list,
+                                                     symbol_map->lines_capacity * sizeof(SourceLine));
+        if(!symbol_map->line_list){
+            fprintf(stderr, "Error: Cannot reallocate symbol map!\n");
+            abort();
+        }
+    }
+
+    symbol_map->line_list[symbol_map->lines_count].address = address;
+    symbol_map->line_list[symbol_map->lines_count].line = line;
+    symbol_map->lines_count ++;
+}
+
+void symbol_map_reserve_lines(SymbolMap* symbol_map, uint32_t lines_count){
+    if(symbol_map->lines_count + lines_count <= symbol_map->lines_capacity)
+        return;
+
+    symbol_map->lines_capacity = symbol_map->lines_count + lines_count;
+    symbol_map->line_list = (SourceLine*)realloc(symbol_map->line_list,
+                                                 symbol_map->lines_capacity * sizeof(SourceLine));
+    if(!symbol_map->line_list){
+        fprintf(stderr, "Error: Cannot reallocate symbol map!\n");
+        abort();
+    }
+}
+
+static int symbols_compare(const void* first, const void* second){
+    const Symbol* symbol_1 = (const Symbol*)first;
+    const Symbol* symbol_2 = (const Symbol*)second;
+
+    if(symbol_1->address != symbol_2->address)
+        return symbol_1->address < symbol_2->address ? -1 : 1;
+
+    return strcmp(symbol_1->name, symbol_2->name);
+}
+
+static int lines_compare(const void* first, const void* second){
+    const SourceLine* line_1 = (const SourceLine*)first;
+    const SourceLine* line_2 = (const SourceLine*)second;
+
+    if(line_1->address != line_2->address)
+        return line_1->address < line_2->address ? -1 : 1;
+
+    return 0;
+}
+
+void symbol_map_sort(SymbolMap* symbol_map){
+    qsort(symbol_map->symbol_list, symbol_map->symbols_count, sizeof(Symbol), symbols_compare);
+    qsort(symbol_map->line_list, symbol_map->lines_count, sizeof(SourceLine), lines_compare);
+}
+
+//---------------------------------FILE_IO---------------------------------
+
+void symbol_map_write(SymbolMap* symbol_map, const char* file_name){
+    FILE* symbol_file = fopen(file_name, "w");
+    if(!symbol_file){
+        fprintf(stderr, "Error opening symbol file %s!\n", file_name);
+        abort();
+    }
+
+    for(uint32_t i = 0; i < symbol_map->symbols_count; i ++){
+        fprintf(symbol_file, "label %08x %s\n", symbol_map->symbol_list[i].address, symbol_map->symbol_list[i].name);
+    }
+
+    for(uint32_t i = 0; i < symbol_map->lines_count; i ++){
+        fprintf(symbol_file, "line %08x %u\n", symbol_map->line_list[i].address, symbol_map->line_list[i].line);
+    }
+
+    fclose(symbol_file);
+}
+
+bool symbol_map_read(SymbolMap* symbol_map, const char* file_name){
+    FILE* symbol_file = fopen(file_name, "r");
+    if(!symbol_file)
+        return false;
+
+    char* line_buf = NULL;
+    size_t len = 0;
+    ssize_t read;
+
+    while((read = getline(&line_buf, &len, symbol_file)) != -1){
+        char kind[8] = {};
+        unsigned int address = 0;
+        int name_start = 0;
+
+        if(sscanf(line_buf, "%7s %x %n", kind, &address, &name_start) < 2)
+            continue;
+
+        char* value = line_buf + name_start;
+        uint32_t value_size = 0;
+        while(value[value_size] != '\0' && !isspace(value[value_size])){
+            value_size ++;
+        }
+
+        if(strcmp(kind, "label") == 0 && value_size != 0){
+            symbol_map_add_symbol(symbol_map, value, value_size, address);
+        }
+        else if(strcmp(kind, "line") == 0){
+            symbol_map_add_line(symbol_map, address, (uint32_t)strtoul(value, NULL, 10));
+        }
+    }
+
+    free(line_buf);
+    fclose(symbol_file);
+
+    symbol_map_sort(symbol_map);
+    return true;
+}
+
+//---------------------------------LOOKUP---------------------------------
+
+const Symbol* symbol_map_find_name(const SymbolMap* symbol_map, const char* name){
+    // Symbols are sorted by address, so name lookup is linear
+    for(uint32_t i = 0; i < symbol_map->symbols_count; i ++){
+        if(strcmp(symbol_map->symbol_list[i].name, name) == 0)
+            return &symbol_map->symbol_list[i];
+    }
+    return NULL;
+}
+
+const Symbol* symbol_map_find(const SymbolMap* symbol_map, uint32_t address){
+    // Binary search of last symbol with address <= given
+    uint32_t left = 0;
+    uint32_t right = symbol_map->symbols_count;
+
+    while(left < right){
+        uint32_t middle = left + (right - left) / 2;
+        if(symbol_map->symbol_list[middle].address <= address)
+            left = middle + 1;
+        else
+            right = middle;
+    }
+
+    if(left == 0)
+        return NULL;
+
+    return &symbol_map->symbol_list[left - 1];
+}
+
+uint32_t symbol_map_find_line(const SymbolMap* symbol_map, uint32_t address){
+    uint32_t left = 0;
+    uint32_t right = symbol_map->lines_count;
+
+    while(left < right){
+        uint32_t middle = left + (right - left) / 2;
+        if(symbol_map->line_list[middle].address < address)
+            left = middle + 1;
+        else
+            right = middle;
+    }
+
+    if(left < symbol_map->lines_count && symbol_map->line_list[left].address == address)
+        return symbol_map->line_list[left].line;
+
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "text_asm_parser/label_table.h"
+#include "exceptions/exceptions.h"
+#include "errors/errors.h"
+
+//----------------------------------ARENA----------------------------------
+
+static const char* arena_store_name(LabelTable* label_table, const char* name, uint32_t name_size){
+    LabelArenaBlock* block = label_table->arena;
+
+    if(!block || block->capacity - block->used < (size_t)name_size + 1){
+        // Names longer than block get block of their own
+        size_t capacity = LABEL_ARENA_BLOCK_SIZE;
+        if((size_t)name_size + 1 > capacity)
+            capacity = (size_t)name_size + 1;
+
+        block = (LabelArenaBlock*)malloc(sizeof(LabelArenaBlock) + capacity);
+        if(!block){
+            THROW(LABEL_TABLE_REALLOC_FAILUR, "Error: Failed to allocate label names arena!\n");
+        }
+
+        block->next = label_table->arena;
+        block->used = 0;
+        block->capacity = capacity;
+        label_table->arena = block;
+    }
+
+    char* stored_name = block->data + block->used;
+    memcpy(stored_name, name, name_size);
+    stored_name[name_size] = '\0';
+    block->used += (size_t)name_size + 1;
+
+    return stored_name;
+}
+
+//----------------------------------HASH_TABLE----------------------------------
+
+static uint32_t label_hash(const char* name, uint32_t name_size){
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for(uint32_t i = 0; i < name_size; i ++){
+        hash ^= (uint8_t)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t* find_slot(LabelTable* label_table, const char* name, uint32_t name_size, uint32_t hash){
+    uint32_t mask = label_table->slots_capacity - 1;
+    uint32_t slot = hash & mask;
+
+    while(label_table->slots[slot] != 0){
+        Label* label = &label_table->label_list[label_table->slots[slot] - 1];
+        if(label->hash == hash && label->label_size == name_size && memcmp(label->name, name, name_size) == 0)
+            return &label_table->slots[slot];
+
+        slot = (slot + 1) & mask;
+    }
+    return &label_table->slots[slot];
+}
+
+static void grow_slots(LabelTable* label_table){
+    free(label_table->slots);
+
+    label_table->slots_capacity *= 2;
+    label_table->slots = (uint32_t*)calloc(label_table->slots_capacity, sizeof(uint32_t));
+    if(!label_table->slots){
+        THROW(LABEL_TABLE_REALLOC_FAILUR, "Error: Failed to reallocate label hash table!\n");
+    }
+
+    for(uint32_t i = 0; i < label_table->count; i ++){
+        Label* label = &label_table->label_list[i];
+        *find_slot(label_table, label->name, label->label_size, label->hash) = i + 1;
+    }
+}
+
+void label_table_init(LabelTable* label_table){
+    label_table->count = 0;
+    label_table->capacity = LABEL_TABLE_INIT_SIZE;
+    label_table->label_list = (Label*)calloc(label_table->capacity, sizeof(Label));
+
+    // Load factor is kept below 1/2
+    label_table->slots_capacity = LABEL_TABLE_INIT_SIZE * 2;
+    label_table->slots = (uint32_t*)calloc(label_table->slots_capacity, sizeof(uint32_t));
+
+    label_table->arena = NULL;
+
+    if(!label_table->label_list || !label_table->slots){
+        THROW(LABEL_TABLE_REALLOC_FAILUR, "Error: Failed to allocate label table!\n");
+    }
+}
+
+void free_label_table(LabelTable* label_table){
+    LabelArenaBlock* block = label_table->arena;
+    while(block){
+        LabelArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    label_table->arena = NULL;
+
+    free(label_table->slots);
+    label_table->slots = NULL;
+
+    free(label_table->label_list);
+    label_table->label_list = NULL;
+    label_table->count = 0;
+}
+
+Label* label_table_find(LabelTable* label_table, const char* name, uint32_t name_size){
+    uint32_t slot = *find_slot(label_table, name, name_size, label_hash(name, name_size));
+    return slot ? &label_table->label_list[slot - 1] : NULL;
+}
+
+Label* label_table_insert(LabelTable* label_table, const char* name, uint32_t name_size){
+    uint32_t hash = label_hash(name, name_size);
+    uint32_t* slot = find_slot(label_table, name, name_size, hash);
+
+    if(*slot)
+        return &label_table->label_list[*slot - 1];
+
+    if(label_table->count == label_table->capacity){
+        label_table->capacity *= 2;
+        Label* new_list = (Label*)realloc(label_table->label_list, label_table->capacity * sizeof(Label));
+        if(!new_list){
+            THROW(LABEL_TABLE_REALLOC_FAILUR, "Error: Failed to reallocate label table!\n");
+        }
+        label_table->label_list = new_list;
+    }
+
+    Label* label = &label_table->label_list[label_table->count];
+    label->name = arena_store_name(label_table, name, name_size);
+    label->label_size = name_size;
+    label->hash = hash;
+    label->address = LABEL_UNDEFINED;
+    label->fixups = 0;
+
+    label_table->count ++;
+    *slot = label_table->count;
+
+    if(label_table->count * 2 > label_table->slots_capacity)
+        grow_slots(label_table);
+
+    return label;
+}
@@ -0,0 +1,189 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "text_asm_parser/lexer.h"
+#include "instructions/instructions.h"
+#include "exceptions/exceptions.h"
+#include "errors/errors.h"
+
+uint8_t char_classes[256];
+uint8_t hex_digit_values[256];
+
+//----------------------------CHARACTER_CLASSES-----------------------------
+
+static bool char_classes_init(){
+    memset(hex_digit_values, HEX_DIGIT_INVALID, sizeof(hex_digit_values));
+
+    for(int i = 0; i < IGNORABLE_SYMBOLS_NUMBER; i ++)
+        char_classes[(uint8_t)ignorable_symbols[i]] |= CHAR_IGNORABLE;
+
+    for(int i = 0; i < PARSE_STOPING_SYMB_NUMBER; i ++)
+        char_classes[(uint8_t)parse_stoping_symbols[i]] |= CHAR_STOPING;
+
+    for(int i = 0; i < INSTRUCTIONS_FLAGS_NUMBER; i ++)
+        char_classes[(uint8_t)instruction_flag[i]] |= CHAR_FLAG;
+
+    for(int symbol = 0; symbol < 256; symbol ++){
+        if(isalpha(symbol))
+            char_classes[symbol] |= CHAR_LETTER | CHAR_LABEL;
+
+        if(isdigit(symbol))
+            hex_digit_values[symbol] = (uint8_t)(symbol - '0');
+        else if('a' <= tolower(symbol) && tolower(symbol) <= 'f')
+            hex_digit_values[symbol] = (uint8_t)(tolower(symbol) - 'a' + 10);
+
+        if(hex_digit_values[symbol] != HEX_DIGIT_INVALID)
+            char_classes[symbol] |= CHAR_HEX_DIGIT;
+    }
+    char_classes[(uint8_t)'_'] |= CHAR_LABEL;
+    return true;
+}
+
+// Tables are built once before main, so threads lexing different files only read them
+static bool char_classes_ready = char_classes_init();
+
+//----------------------------SOURCE-----------------------------
+
+void source_file_open(SourceFile* source_file, const char* file_name){
+    source_file->data = NULL;
+    source_file->size = 0;
+
+    int fd = open(file_name, O_RDONLY);
+    if(fd == -1){
+        THROW(FILE_OPENING_FAILURE, "Failed to open file");
+    }
+
+    struct stat file_stat;
+    if(fstat(fd, &file_stat) == -1){
+        close(fd);
+        THROW(FILE_OPENING_FAILURE, "Failed to measure file");
+    }
+
+    // Empty file can't be mapped, it is just source without lines
+    if(file_stat.st_size == 0){
+        close(fd);
+        return;
+    }
+
+    void* mapped_file = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if(mapped_file == MAP_FAILED){
+        THROW(FILE_OPENING_FAILURE, "Failed to map file");
+    }
+    madvise(mapped_file, (size_t)file_stat.st_size, MADV_SEQUENTIAL);
+
+    source_file->data = (const char*)mapped_file;
+    source_file->size = (size_t)file_stat.st_size;
+}
+
+void source_file_close(SourceFile* source_file){
+    if(source_file->data)
+        munmap((void*)source_file->data, source_file->size);
+
+    source_file->data = NULL;
+    source_file->size = 0;
+}
+
+//----------------------------SCANNING-----------------------------
+
+static const char* find_line_end_scalar(const char* position, const char* end){
+    while(position < end && *position != '\n' && *position != ';'){
+        position ++;
+    }
+    return position;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("sse2")))
+static const char* find_line_end_sse2(const char* position, const char* end){
+    const __m128i line_feed = _mm_set1_epi8('\n');
+    const __m128i comment = _mm_set1_epi8(';');
+
+    while(end - position >= 16){
+        __m128i chunk = _mm_loadu_si128((const __m128i*)position);
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, line_feed),
+                                                                 _mm_cmpeq_epi8(chunk, comment)));
+        if(mask)
+            return position + __builtin_ctz(mask);
+        position += 16;
+    }
+    return find_line_end_scalar(position, end);
+}
+
+__attribute__((target("avx2")))
+static const char* find_line_end_avx2(const char* position, const char* end){
+    const __m256i line_feed = _mm256_set1_epi8('\n');
+    const __m256i comment = _mm256_set1_epi8(';');
+
+    while(end - position >= 32){
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)position);
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, line_feed),
+                                                                       _mm256_cmpeq_epi8(chunk, comment)));
+        if(mask)
+            return position + __builtin_ctz(mask);
+        position += 32;
+    }
+    return find_line_end_sse2(position, end);
+}
+
+#endif
+
+typedef const char* (*FindLineEnd)(const char* position, const char* end);
+
+static FindLineEnd select_find_line_end(){
+#if defined(__x86_64__) || defined(__i386__)
+    if(__builtin_cpu_supports("avx2"))
+        return find_line_end_avx2;
+    if(__builtin_cpu_supports("sse2"))
+        return find_line_end_sse2;
+#endif
+    return find_line_end_scalar;
+}
+
+static FindLineEnd find_line_end = select_find_line_end();
+
+//----------------------------LINES-----------------------------
+
+void lexer_init(Lexer* lexer, SourceFile* source_file){
+    lexer_init_range(lexer, source_file->data, source_file->data + source_file->size);
+}
+
+void lexer_init_range(Lexer* lexer, const char* begin, const char* end){
+    lexer->position = begin;
+    lexer->end = end;
+    lexer->line_number = 0;
+}
+
+bool lexer_next_line(Lexer* lexer, StringView* line){
+    if(lexer->position >= lexer->end)
+        return false;
+
+    const char* line_end = find_line_end(lexer->position, lexer->end);
+
+    line->data = lexer->position;
+    line->size = (uint32_t)(line_end - lexer->position);
+
+    // Rest of line after ';' is comment
+    if(line_end < lexer->end && *line_end == ';'){
+        line_end = (const char*)memchr(line_end, '\n', lexer->end - line_end);
+        if(!line_end)
+            line_end = lexer->end;
+    }
+
+    lexer->position = line_end < lexer->end ? line_end + 1 : lexer->end;
+    lexer->line_number ++;
+    return true;
+}
@@ -1,17 +1,17 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
-#include <ctype.h>
 #include <string.h>
 #include <stdbool.h>
-#include <limits.h>
+#include <pthread.h>
 
 #include "text_asm_parser/text_asm_parser.h"
+#include "text_asm_parser/lexer.h"
 #include "instructions/instructions.h"
 #include "exceptions/exceptions.h"
 #include "errors/errors.h"
-
-// LABEL_SIZE must be bigger then 8, to be possible save ptr on allocated buffer
+#include "assembler/assembler.h"
+#include "symbols/symbols.h"
 
 //----------------------------------DEBUG----------------------------------
 
@@ -48,188 +48,64 @@ void print_parsed_asm(TextInstructionArray* text_instruction_array){
 void print_label_table(LabelTable* label_table){
     printf("Label List:\n");
     for (uint32_t i = 0; i < label_table->count; i ++){
-        printf("%u   %s\n", label_table->label_list[i].address, label_table->label_list[i].label);
-    }
-}
-
-//----------------------------TOKEN_RECOGNITION-----------------------------
-
-static bool is_flag_symbol(char flag){
-    for(int j = 0; j < INSTRUCTIONS_FLAGS_NUMBER; j ++){
-        if (flag == instruction_flag[j]) {
-            return true;
-        }
+        printf("%u   %s\n", label_table->label_list[i].address, label_table->label_list[i].name);
     }
-    return false;
-}
-
-static bool is_hex_digit(char digit) {
-    return isdigit(digit) || 
-           ('a' <= tolower(digit) && tolower(digit) <= 'f');
 }
 
-static bool is_ignorable_symbol(char symbol){
-    for(int i = 0; i < IGNORABLE_SYMBOLS_NUMBER; i ++){
-        if(symbol == ignorable_symbols[i])
-            return true;
-    }
-    return false;
-}
-
-static bool is_parse_stoping_symbol(char symbol){
-    for(int i = 0; i < PARSE_STOPING_SYMB_NUMBER; i ++){
-        if(symbol == parse_stoping_symbols[i])
-            return true;
-    }
-    return false;
-}
-
-//----------------------------LABEL_TABLE-----------------------------
-
-static Label* find_label(LabelTable* label_table, char* label, uint32_t label_length){
-    for(uint32_t i = 0; i < label_table->count; i ++){
-        
-        // If label less then LABEL_LENGTH
-        if(label_table->label_list[i].label_size == label_length && label_length <= LABEL_SIZE){
-            if(memcmp(label, label_table->label_list[i].label, label_length) == 0){
-                return &label_table->label_list[i];
-            }
-        }
-
-        // If label name have large length - FIXED: Added length check and proper comparison
-        if(label_table->label_list[i].label_size == label_length && label_length > LABEL_SIZE){
-            char* long_label;
-            memcpy(&long_label, label_table->label_list[i].label, sizeof(void*));
-            if(memcmp(label, long_label, label_length) == 0){  // Compare actual string content
-                return &label_table->label_list[i];
-            }
-        }
-    }
-    return NULL;
-}
+//----------------------------LABELS-----------------------------
 
-static void parse_label(char* line_buf, LabelTable* label_table, uint32_t address, int symb_count){
+// Returns index of defined label in label table
+static uint32_t parse_label(LineCursor* cursor, LabelTable* label_table, uint32_t address){
     // Move to first leter in label name
-    symb_count ++;
-    Label* current_label;
-    int current_label_size = 0;
-    // Measure label length
-    while(isalpha(line_buf[symb_count + current_label_size]) || line_buf[symb_count + current_label_size] == '_'){
-        current_label_size ++;
-    }
+    cursor->position ++;
+    StringView label_name = line_cursor_span(cursor, CHAR_LABEL);
 
     // Zero length label name case
-    if(current_label_size == 0){
+    if(label_name.size == 0){
         THROW(ZERO_LENGTH_LABEL, "Error: Label name must contain one or more symbol! Also shouldn't be spaces after :!\n");
     }
 
-    if(label_table->count == label_table->capacity){
-        label_table->capacity = (uint32_t)(label_table->capacity * 1.5);
-        Label* new_list = (Label*)realloc(label_table->label_list, label_table->capacity * sizeof(Label));
-        if(!new_list) {
-            THROW(LABEL_TABLE_REALLOC_FAILUR, "Error: Failed to reallocate label table!\n");
-        }
-        label_table->label_list = new_list;
-    }
-
-    current_label = find_label(label_table, &line_buf[symb_count], current_label_size);
-
-    // Verify if label is already in label table
-    if(current_label != NULL ){
-        if(current_label->address == UINT32_MAX)
-            current_label->address = address;
-        else{
-            if(current_label->address == address)
-                return;
-            else{
-                printf("Current label address: %u\n", current_label->address);
-                THROW(LABEL_REDEFINITION, "Error: Label redefinition!\n");
-            }
-        }
-    }
+    Label* current_label = label_table_insert(label_table, label_name.data, label_name.size);
 
-    // Case, when there now label with given name
-    else{
-        label_table->count ++;
-        current_label = &label_table->label_list[label_table->count - 1];
-        current_label->label_size = current_label_size;
+    // Label is defined first time or was only referenced before
+    if(current_label->address == LABEL_UNDEFINED){
         current_label->address = address;
-
-
-        // If label size is smaller then allocated buffer
-        if(current_label->label_size <= LABEL_SIZE){
-            memcpy(current_label->label, &line_buf[symb_count], current_label->label_size);
-            if(DEBUG)
-                printf("Saved label name: %s address: %u\n", current_label->label, current_label->address);
-        }
-
-        // If label size is bigger then allocated buffer
-        else{
-            void* label_buf = calloc(current_label->label_size, sizeof(char));
-            memcpy(label_buf, &line_buf[symb_count], current_label->label_size);
-            memcpy(current_label->label, &label_buf, sizeof(void*));
-        }
+        if(DEBUG)
+            printf("Saved label name: %s address: %u\n", current_label->name, current_label->address);
+    }
+    else if(current_label->address != address){
+        printf("Current label address: %u\n", current_label->address);
+        THROW(LABEL_REDEFINITION, "Error: Label redefinition!\n");
     }
-    
-    symb_count += current_label_size;
 
-    // Check rest of line
-    while (line_buf[symb_count] != '\n' && line_buf[symb_count] != '\0') {
-        if (line_buf[symb_count] == ' ') {
-            symb_count++;
-            continue;
-        }
-    
+    // Check rest of line, comment is already cut off by lexer
+    line_cursor_span(cursor, CHAR_IGNORABLE | CHAR_STOPING);
+    if(cursor->position != cursor->end){
         // Non-space symbol after label name
         THROW(WRONG_LABEL_NAME,
               "Error: non-space symbol after label name!\nLabel name can contain only latters and '_' symbol!\n");
     }
-}
 
-/*
-  void free_label_table(LabelTable* label_table){
-  // Deallocation of long strings
-     for(uint32_t i = 0; i < label_table->count; i ++){
-     if(label_table->label_list[i].label_size > LABEL_SIZE){
-     free(label_table->label_list[i].label);
-     }
-     }
-
-    // Labels buffer deallocation
-       free(label_table->label_list);
-       }
- */
-void free_label_table(LabelTable* label_table){
-    // Deallocation of long strings
-    for(uint32_t i = 0; i < label_table->count; i ++){
-        if(label_table->label_list[i].label_size > LABEL_SIZE){
-            // Extract the pointer stored in the label array
-            char* long_label_ptr;
-            memcpy(&long_label_ptr, label_table->label_list[i].label, sizeof(void*));
-            free(long_label_ptr);
-        }
-    }
+    return (uint32_t)(current_label - label_table->label_list);
+}
 
-    // Labels buffer deallocation
-    free(label_table->label_list);
+const char* get_label_name(Label* label){
+    return label->name;
 }
 
 
 //-------------------------INSTRUCTINS_PARSING--------------------------
-static void set_op_name(TextInstruction* text_instruction, char* op_name, int* symb_count){
-    int op_name_length = 0;
-    while(isalpha(*(op_name + op_name_length))){
-        op_name_length ++;
-    }
-    if(op_name_length == INSTRUCTION_SIZE){
-        memcpy(text_instruction->operation.operation_name, op_name, INSTRUCTION_SIZE);
+static void set_op_name(TextInstruction* text_instruction, LineCursor* cursor){
+    StringView op_name = line_cursor_span(cursor, CHAR_LETTER);
+
+    if(op_name.size == INSTRUCTION_SIZE){
+        memcpy(text_instruction->operation.operation_name, op_name.data, INSTRUCTION_SIZE);
         text_instruction->operation.operation_name[INSTRUCTION_SIZE] = '\0';
 
         for(int i = 0; i < INSTRUCTIONS_SET_NUMBER; i++){
             if(memcmp(text_instruction->operation.operation_name, instruction_set[i].op_name, INSTRUCTION_SIZE) == 0){
                 text_instruction->operation.num_of_args = instruction_set[i].num_of_args;
                 text_instruction->operation.op_code = i;
-                *symb_count += op_name_length;
                 return;
             }
         }
@@ -239,34 +115,26 @@ static void set_op_name(TextInstruction* text_instruction, char* op_name, int* s
 }
 
 
-static ParserState set_arg_flag (TextInstruction* text_instruction, char* arg_flag,
-                                 uint32_t* arg_count, int* symb_count, ParserState parser_state){
+static ParserState set_arg_flag(TextInstruction* text_instruction, LineCursor* cursor,
+                                uint32_t arg_count, ParserState parser_state){
 
     // Check that there no two flags in a row
     if(parser_state.flag_seted){
         THROW(SPACES_IN_FLAG, "Error: Flag cannot contain spaces!");
     }
 
-    int arg_length = 0;
-    while(!is_hex_digit(*(arg_flag + arg_length)) && *(arg_flag + arg_length) != ':' && *(arg_flag + arg_length) != ' '){
-        bool flag_found = is_flag_symbol(*(arg_flag + arg_length));
-        if(flag_found){
-            arg_length ++;
-            continue;
-        }
-        else{
-            fprintf(stderr, "Unknown flag %c!\n", *(arg_flag + arg_length));
-            THROW(UNKNOWN_FLAG,"\0");
-        }
+    StringView arg_flag = line_cursor_span(cursor, CHAR_FLAG);
+
+    char next_symbol = line_cursor_peek(cursor);
+    if(!char_is(next_symbol, CHAR_HEX_DIGIT) && next_symbol != ':' && next_symbol != ' '){
+        fprintf(stderr, "Unknown flag %c!\n", next_symbol);
+        THROW(UNKNOWN_FLAG,"\0");
     }
 
     // Flags more with length more then 2 is unsupported
-    assert(arg_length <= 2);
-    memcpy(text_instruction->imm[*arg_count].imm_flag, arg_flag, arg_length);
-    text_instruction->imm[*arg_count].imm_flag[arg_length] = '\0';
-
-
-    *symb_count += arg_length;
+    assert(arg_flag.size <= 2);
+    memcpy(text_instruction->imm[arg_count].imm_flag, arg_flag.data, arg_flag.size);
+    text_instruction->imm[arg_count].imm_flag[arg_flag.size] = '\0';
 
     parser_state.flag_seted = true;
     parser_state.arg_seted = false;
@@ -274,7 +142,7 @@ static ParserState set_arg_flag (TextInstruction* text_instruction, char* arg_fl
 }
 
 
-static ParserState set_num_arg(TextInstruction* text_instruction, char* num_arg, uint32_t arg_count, int* symb_count,
+static ParserState set_num_arg(TextInstruction* text_instruction, LineCursor* cursor, uint32_t arg_count,
                                ParserState parser_state){
     // Parse case without flag
     if(!parser_state.flag_seted){
@@ -282,14 +150,17 @@ static ParserState set_num_arg(TextInstruction* text_instruction, char* num_arg,
     }
 
     // Parse num arg
-    char* end_of_arg = NULL;
-    long long arg = strtoll(num_arg, &end_of_arg, 16);
-    if(arg > UINT_MAX){
-        THROW(TO_LARGE_IMM, "To large imm. Imm must me less then UINT_MAX!");
+    StringView num_arg = line_cursor_span(cursor, CHAR_HEX_DIGIT);
+    uint64_t arg = 0;
+    for(uint32_t i = 0; i < num_arg.size; i ++){
+        arg = (arg << 4) | hex_digit_values[(uint8_t)num_arg.data[i]];
+        if(arg > UINT32_MAX){
+            THROW(TO_LARGE_IMM, "To large imm. Imm must me less then UINT_MAX!");
+        }
     }
 
     text_instruction->imm[arg_count].imm = (uint32_t)arg;
-    *symb_count += (end_of_arg - num_arg);
+    text_instruction->imm[arg_count].label = 0;
 
     parser_state.flag_seted = false;
     parser_state.arg_seted = true;
@@ -297,61 +168,19 @@ static ParserState set_num_arg(TextInstruction* text_instruction, char* num_arg,
 }
 
 
-static ParserState set_label_arg(TextInstruction* text_instruction,LabelTable* label_table,
-                                 char* line_buf, int* symb_count, uint32_t arg_count, ParserState parser_state){
-    int arg_length = 0;
+static ParserState set_label_arg(TextInstruction* text_instruction, LabelTable* label_table,
+                                 LineCursor* cursor, uint32_t arg_count, ParserState parser_state){
+    StringView label_name = line_cursor_span(cursor, CHAR_LABEL);
 
-    //Measure label length 
-    while(isalpha(line_buf[*symb_count + arg_length]) || line_buf[*symb_count + arg_length] == '_'){
-        arg_length ++;
-    }
-
-    Label* label = find_label(label_table, &line_buf[*symb_count], arg_length);
-
-    // Case when label in label table
-    if(label != NULL){
-        if(label->address != UINT_MAX){
-            text_instruction->imm[arg_count].imm = label->address;
-        }
-    }
-
-    // Case when label not in label table
-    else{
-        // Realloc label list if needed
-        if(label_table->count == label_table->capacity){
-            label_table->capacity = (uint32_t)(label_table->capacity * 1.5);
-            Label* new_list = (Label*)realloc(label_table->label_list, label_table->capacity * sizeof(Label));
-            
-            if(new_list == NULL){
-                THROW(LABEL_TABLE_REALLOC_FAILUR, "Error while reallocating text label buffer");
-            }
-            label_table->label_list = new_list;
-        }
-
-        // Store label in label table
-        uint32_t index = label_table->count;
-        label_table->count++;
-        label_table->label_list[index].label_size = arg_length;
-
-        if(label_table->label_list[index].label_size <= LABEL_SIZE){
-            memcpy(label_table->label_list[index].label, &line_buf[*symb_count], arg_length);
-            // Null terminate if possible
-            if(arg_length < LABEL_SIZE) {
-                label_table->label_list[index].label[arg_length] = '\0';
-            }
-        }
-        else{
-            char* label_buf = (char*)calloc(arg_length + 1, sizeof(char));
-            memcpy(label_buf, &line_buf[*symb_count], arg_length);
-            label_buf[arg_length] = '\0';
-            memcpy(label_table->label_list[index].label, &label_buf, sizeof(void*));
-        }
-
-        label_table->label_list[index].address = UINT32_MAX;
+    // Label without flag is immediate address
+    if(!parser_state.flag_seted){
+        text_instruction->imm[arg_count].imm_flag[0] = '\0';
     }
 
-    // Update parser state variables
-    *symb_count += arg_length;
+    // Label, which isn't defined yet, is added with undefined address and resolved later
+    Label* label = label_table_insert(label_table, label_name.data, label_name.size);
+    text_instruction->imm[arg_count].imm = label->address != LABEL_UNDEFINED ? label->address : 0;
+    text_instruction->imm[arg_count].label = (uint32_t)(label - label_table->label_list) + 1;
 
     parser_state.arg_seted = true;
     parser_state.flag_seted = false;
@@ -359,8 +188,8 @@ static ParserState set_label_arg(TextInstruction* text_instruction,LabelTable* l
     return parser_state;
 }
 
-static bool finish_parsing(char* line_buf, TextInstruction* text_instruction, int* symb_count ,uint32_t arg_count){
-    if(is_parse_stoping_symbol(line_buf[*symb_count])){
+static bool finish_parsing(LineCursor* cursor, TextInstruction* text_instruction, uint32_t arg_count){
+    if(char_is(line_cursor_peek(cursor), CHAR_STOPING)){
         // Verify that required num of args readed 
         if(arg_count == text_instruction->operation.num_of_args){
             return false;
@@ -378,86 +207,91 @@ static bool finish_parsing(char* line_buf, TextInstruction* text_instruction, in
 
 //-------------------------INSTRUCTINS_PARSING--------------------------
 
-static void parse_instruction(char* line_buf, LabelTable* label_table, TextInstruction* text_instruction, int symb_count){
+static void parse_instruction(StringView line, LineCursor* cursor, LabelTable* label_table,
+                              TextInstruction* text_instruction){
     uint32_t arg_count = 0;
     // Read op_name
-    set_op_name(text_instruction, line_buf, &symb_count);
+    set_op_name(text_instruction, cursor);
+    uint32_t num_of_args = text_instruction->operation.num_of_args;
 
     ParserState parser_state;
     parser_state.flag_seted = false;
     parser_state.arg_seted = true;
     // Read args
-    while(symb_count <= (int)strlen(line_buf) && finish_parsing(line_buf, text_instruction, &symb_count, arg_count)){
+    while(finish_parsing(cursor, text_instruction, arg_count)){
+        char symbol = line_cursor_peek(cursor);
+
         // Skip spaces
-        if(is_ignorable_symbol(line_buf[symb_count])){
-            symb_count ++;
+        if(char_is(symbol, CHAR_IGNORABLE)){
+            line_cursor_span(cursor, CHAR_IGNORABLE);
             continue;
         }
 
+        // Fall on to many args
+        if(arg_count >= num_of_args){
+            fprintf(stderr, "To many args. For operation %s\n", text_instruction->operation.operation_name);
+            THROW(WRONG_ARG_NUM, "\0");
+        }
+
         // Parse flag
-        if((is_flag_symbol(line_buf[symb_count])) && arg_count < text_instruction->operation.num_of_args){
-            parser_state = set_arg_flag(text_instruction, &line_buf[symb_count], &arg_count,
-                                        &symb_count, parser_state);
+        if(char_is(symbol, CHAR_FLAG)){
+            parser_state = set_arg_flag(text_instruction, cursor, arg_count, parser_state);
             continue;
         }
 
         // Parse num args
-        if(is_hex_digit(line_buf[symb_count]) && arg_count < text_instruction->operation.num_of_args){
-            parser_state = set_num_arg(text_instruction, &line_buf[symb_count], arg_count,
-                                       &symb_count, parser_state);
+        if(char_is(symbol, CHAR_HEX_DIGIT)){
+            parser_state = set_num_arg(text_instruction, cursor, arg_count, parser_state);
             arg_count ++;
             continue;
         }
 
         // Parse lable
-        if(line_buf[symb_count] == ':'){
+        if(symbol == ':'){
             // Moove to firs latter symb, which must follow after. 
-            symb_count ++;
-            parser_state = set_label_arg(text_instruction, label_table, line_buf, &symb_count,
-                                         arg_count, parser_state);
+            cursor->position ++;
+            parser_state = set_label_arg(text_instruction, label_table, cursor, arg_count, parser_state);
             arg_count ++;
             continue;
         }
 
         // Fall on unknown symbols
-        if (arg_count <= text_instruction->operation.num_of_args) {
-            fprintf(stderr, "Unknown token %c while parsing line: %s", 
-                    line_buf[symb_count], &line_buf[0]);
-            THROW(UNKNOWN_TOKEN, "\0");
-        }
-
-        // Fall on to many args
-        if(arg_count >= text_instruction->operation.num_of_args && !is_ignorable_symbol(line_buf[symb_count])
-           && !is_parse_stoping_symbol(line_buf[symb_count])){
-            fprintf(stderr, "To many args. For operation %s\n", text_instruction->operation.operation_name);
-            THROW(WRONG_ARG_NUM, "\0");
-        }
+        fprintf(stderr, "Unknown token %c while parsing line: %.*s\n", symbol, (int)line.size, line.data);
+        THROW(UNKNOWN_TOKEN, "\0");
     }
 }
 
 //-------------------------STATE_MACHINE--------------------------
 
-static void parse_line(char* line_buf, LabelTable* label_table, TextInstructionArray* text_instruction_array, uint32_t* address){
-    TextInstruction* text_instruction = &text_instruction_array->text_instruction_list[text_instruction_array->count];
+typedef enum LineKind{
+    LINE_EMPTY,
+    LINE_LABEL,
+    LINE_INSTRUCTION
+}LineKind;
 
-    for(uint32_t symb_count = 0; symb_count < (uint32_t)strlen(line_buf); symb_count ++){
-        if(line_buf[symb_count] == ':'){
-            parse_label(line_buf, label_table, *address, symb_count);
-            break;
-        }
-        if(isalpha(line_buf[symb_count])){
-            //text_instruction->address = *address;
-            *address += 16;
+// Parses line into text_instruction, defined_label receives label index for label lines
+static LineKind parse_line(StringView line, LabelTable* label_table, TextInstruction* text_instruction,
+                           uint32_t address, uint32_t line_number, uint32_t* defined_label){
+    LineCursor cursor = {line.data, line.data + line.size};
 
-            text_instruction_array->count ++;
+    for(; cursor.position < cursor.end; cursor.position ++){
+        char symbol = *cursor.position;
 
-            parse_instruction(line_buf, label_table, text_instruction, symb_count);
-            break;
+        if(symbol == ':'){
+            *defined_label = parse_label(&cursor, label_table, address);
+            return LINE_LABEL;
         }
-        if(is_parse_stoping_symbol(line_buf[symb_count])){
+        if(char_is(symbol, CHAR_LETTER)){
+            text_instruction->line = line_number;
+
+            parse_instruction(line, &cursor, label_table, text_instruction);
+            return LINE_INSTRUCTION;
+        }
+        if(char_is(symbol, CHAR_STOPING)){
             break;
         }
     }
+    return LINE_EMPTY;
 }
 
 void free_text_instruction_list(TextInstructionArray* text_instruction_array){
@@ -469,32 +303,36 @@ void free_text_instruction_list(TextInstructionArray* text_instruction_array){
     THROW(NULL_PTR_TEXT_INSTRUCTION_ARRAY, "Text_instruction_array or instructions list is already NULL!");
 }
 
-static void parse_iteration(FILE *text_asm_file, LabelTable* label_table, TextInstructionArray* text_instruction_array){
-    char *line_buf = NULL;
-    size_t len = 0;
-    ssize_t read;
+static void parse_iteration(SourceFile* source_file, LabelTable* label_table, TextInstructionArray* text_instruction_array){
+    Lexer lexer;
+    lexer_init(&lexer, source_file);
+    StringView line;
 
     uint32_t address = 0;
     text_instruction_array->count = 0;
 
-    // Go to beginning of file
-    fseek(text_asm_file, 0, SEEK_SET);
-    
-    while ((read = getline(&line_buf, &len, text_asm_file)) != -1 && address < UINT32_MAX) {
+    while (lexer_next_line(&lexer, &line) && address < UINT32_MAX) {
 
         // Reallocate text_instructions buffer if needed
         if(text_instruction_array->count == text_instruction_array->capacity){
             text_instruction_array->capacity *= 1.5;
-            text_instruction_array->text_instruction_list = (TextInstruction*)calloc(text_instruction_array->capacity,
-                                                                                     sizeof(TextInstruction));
+            TextInstruction* new_list = (TextInstruction*)realloc(text_instruction_array->text_instruction_list,
+                                                                  text_instruction_array->capacity *
+                                                                  sizeof(TextInstruction));
+            if(!new_list){
+                THROW(TEXT_INSTRUCTION_ARRAY_REALLOC_FAILURE, "Error: Failed to reallocate text instructions!\n");
+            }
+            text_instruction_array->text_instruction_list = new_list;
         }
 
-        parse_line(line_buf, label_table, text_instruction_array, &address);
+        TextInstruction* text_instruction = &text_instruction_array->text_instruction_list[text_instruction_array->count];
+        uint32_t defined_label = 0;
+        if(parse_line(line, label_table, text_instruction, address, lexer.line_number, &defined_label) == LINE_INSTRUCTION){
+            text_instruction_array->count ++;
+            address += BIN_INSTRUCTION_SIZE;
+        }
     }
-    
-    free(line_buf);
 }
-
 //--------------------------------CRITICAL_ERROR--------------------------------
 
 void parser_critical_error(TextInstructionArray* text_instructions_array, 
@@ -515,35 +353,28 @@ void parser_critical_error(TextInstructionArray* text_instructions_array,
 //--------------------------------PARSER--------------------------------
 
 void parse_text_asm_file(const char* file_name, TextInstructionArray* text_instruction_array, LabelTable* label_table){
-    FILE *file = fopen(file_name, "r");
-    if (!file) {
-        THROW(FILE_OPENING_FAILURE, "Failed to open file");
-    }
-
     // Initialization struct for text asm representation storage
     text_instruction_array->count = 0;
     text_instruction_array->capacity = INIT_TEXT_INSTR_ARR_SIZE;
     text_instruction_array->text_instruction_list = (TextInstruction*)calloc(text_instruction_array->capacity,
                                                                              sizeof(TextInstruction));
 
+    // Structures are initialized before opening file, so parser_critical_error can free them
+    label_table_init(label_table);
 
-    label_table->count = 0;
-    label_table->capacity = LABEL_TABLE_INIT_SIZE;
-    label_table->label_list = (Label*)calloc(label_table->capacity, sizeof(Label));
-    
+    SourceFile source_file;
+    source_file_open(&source_file, file_name);
 
     // First iteration
-    parse_iteration(file, label_table, text_instruction_array);
+    parse_iteration(&source_file, label_table, text_instruction_array);
 
     if(DEBUG){
         printf("\nFirst pass:\n");
         print_parsed_asm(text_instruction_array);
     }
 
-    rewind(file);
-
     // Second iteration
-    parse_iteration(file, label_table, text_instruction_array);
+    parse_iteration(&source_file, label_table, text_instruction_array);
 
     if(DEBUG){
         printf("\nSecond pass:\n");
@@ -555,5 +386,441 @@ void parse_text_asm_file(const char* file_name, TextInstructionArray* text_instr
         print_label_table(label_table);
     }
     
-    fclose(file);
+    source_file_close(&source_file);
+}
+
+//--------------------------------SINGLE_PASS--------------------------------
+
+typedef struct Fixup{
+    uint32_t instruction;
+    uint32_t arg;
+    // Index + 1 of next fixup of the same label, 0 for last one
+    uint32_t next;
+}Fixup;
+
+// Resolved fixups go to free list, so pool size is bounded by number of pending forward references
+typedef struct FixupPool{
+    uint32_t count;
+    uint32_t capacity;
+    Fixup* fixup_list;
+    uint32_t free_list;
+}FixupPool;
+
+static void fixup_add(FixupPool* fixup_pool, Label* label, uint32_t instruction, uint32_t arg){
+    uint32_t fixup_index = fixup_pool->free_list;
+
+    if(fixup_index){
+        fixup_pool->free_list = fixup_pool->fixup_list[fixup_index - 1].next;
+    }
+    else{
+        if(fixup_pool->count == fixup_pool->capacity){
+            fixup_pool->capacity = fixup_pool->capacity ? fixup_pool->capacity * 2 : LABEL_TABLE_INIT_SIZE;
+            Fixup* new_list = (Fixup*)realloc(fixup_pool->fixup_list, fixup_pool->capacity * sizeof(Fixup));
+            if(!new_list){
+                THROW(FIXUP_LIST_REALLOC_FAILURE, "Error: Failed to reallocate label fixups!\n");
+            }
+            fixup_pool->fixup_list = new_list;
+        }
+        fixup_index = ++ fixup_pool->count;
+    }
+
+    Fixup* fixup = &fixup_pool->fixup_list[fixup_index - 1];
+    fixup->instruction = instruction;
+    fixup->arg = arg;
+    fixup->next = label->fixups;
+    label->fixups = fixup_index;
+}
+
+static void fixups_resolve(FixupPool* fixup_pool, Label* label, BinInstructionArray* bin_instructions_array){
+    uint32_t fixup_index = label->fixups;
+
+    while(fixup_index){
+        Fixup* fixup = &fixup_pool->fixup_list[fixup_index - 1];
+        bin_instructions_array->bin_instruction_list[fixup->instruction].arg_list[fixup->arg] = label->address;
+
+        uint32_t next = fixup->next;
+        fixup->next = fixup_pool->free_list;
+        fixup_pool->free_list = fixup_index;
+        fixup_index = next;
+    }
+
+    label->fixups = 0;
+}
+
+static void emit_instruction(BinInstructionArray* bin_instructions_array, uint32_t* bin_capacity,
+                             TextInstruction* text_instruction, LabelTable* label_table, FixupPool* fixup_pool){
+    if(bin_instructions_array->count == *bin_capacity){
+        *bin_capacity = *bin_capacity ? (uint32_t)(*bin_capacity * 1.5) : INIT_TEXT_INSTR_ARR_SIZE;
+        BinInstruction* new_list = (BinInstruction*)realloc(bin_instructions_array->bin_instruction_list,
+                                                            *bin_capacity * sizeof(BinInstruction));
+        if(!new_list){
+            THROW(BIN_INSTRUCTION_ARRAY_REALLOC_FAILURE, "Error: Failed to reallocate bin instructions!\n");
+        }
+        bin_instructions_array->bin_instruction_list = new_list;
+    }
+
+    uint32_t instruction = bin_instructions_array->count;
+    assemble_text_instruction(&bin_instructions_array->bin_instruction_list[instruction], text_instruction);
+
+    // Args are not cleared by assemble_text_instruction
+    for(uint32_t arg_count = text_instruction->operation.num_of_args; arg_count < 3; arg_count ++){
+        bin_instructions_array->bin_instruction_list[instruction].arg_list[arg_count] = 0;
+    }
+
+    for(uint32_t arg_count = 0; arg_count < text_instruction->operation.num_of_args; arg_count ++){
+        uint32_t label_index = text_instruction->imm[arg_count].label;
+        if(label_index == 0)
+            continue;
+
+        Label* label = &label_table->label_list[label_index - 1];
+        if(label->address == LABEL_UNDEFINED)
+            fixup_add(fixup_pool, label, instruction, arg_count);
+    }
+
+    bin_instructions_array->count ++;
+}
+
+void assemble_text_asm_file(const char* file_name, BinInstructionArray* bin_instructions_array,
+                            LabelTable* label_table, SymbolMap* symbol_map){
+    bin_instructions_array->count = 0;
+    bin_instructions_array->bin_instruction_list = NULL;
+    uint32_t bin_capacity = 0;
+
+    FixupPool fixup_pool = {};
+
+    // Structures are initialized before opening file, so they can be freed after error
+    label_table_init(label_table);
+
+    SourceFile source_file;
+    source_file_open(&source_file, file_name);
+
+    Lexer lexer;
+    lexer_init(&lexer, &source_file);
+    StringView line;
+
+    uint32_t address = 0;
+    TextInstruction text_instruction = {};
+
+    while (lexer_next_line(&lexer, &line) && address < UINT32_MAX) {
+        uint32_t defined_label = 0;
+        LineKind line_kind = parse_line(line, label_table, &text_instruction, address, lexer.line_number,
+                                        &defined_label);
+
+        if(line_kind == LINE_LABEL){
+            fixups_resolve(&fixup_pool, &label_table->label_list[defined_label], bin_instructions_array);
+        }
+        else if(line_kind == LINE_INSTRUCTION){
+            emit_instruction(bin_instructions_array, &bin_capacity, &text_instruction, label_table, &fixup_pool);
+            symbol_map_add_line(symbol_map, address, lexer.line_number);
+            address += BIN_INSTRUCTION_SIZE;
+        }
+    }
+
+    // Uses of labels, which are never defined, keep zero address as in two pass parser
+    free(fixup_pool.fixup_list);
+    source_file_close(&source_file);
+}
+
+//--------------------------------PARALLEL--------------------------------
+
+typedef struct LabelReference{
+    uint32_t instruction;
+    uint32_t arg;
+    uint32_t label;
+}LabelReference;
+
+// Part of source, which is parsed by one thread. Addresses, lines and labels are local to chunk
+// until chunks are merged.
+typedef struct AssemblyChunk{
+    const char* begin;
+    const char* end;
+
+    BinInstructionArray bin_instructions_array;
+    uint32_t bin_capacity;
+    uint32_t* line_list;
+
+    LabelTable label_table;
+    uint32_t references_count;
+    uint32_t references_capacity;
+    LabelReference* reference_list;
+
+    uint32_t lines_count;
+    uint32_t instruction_offset;
+    uint32_t line_offset;
+    // Global label index for every local label
+    uint32_t* label_map;
+
+    BinInstructionArray* output_bin_instructions_array;
+    LabelTable* output_label_table;
+    SymbolMap* output_symbol_map;
+
+    bool failed;
+    Exception exception;
+}AssemblyChunk;
+
+static void chunk_emit_instruction(AssemblyChunk* chunk, TextInstruction* text_instruction, uint32_t line_number){
+    BinInstructionArray* bin_instructions_array = &chunk->bin_instructions_array;
+
+    if(bin_instructions_array->count == chunk->bin_capacity){
+        chunk->bin_capacity = chunk->bin_capacity ? (uint32_t)(chunk->bin_capacity * 1.5) : INIT_TEXT_INSTR_ARR_SIZE;
+        BinInstruction* new_list = (BinInstruction*)realloc(bin_instructions_array->bin_instruction_list,
+                                                            chunk->bin_capacity * sizeof(BinInstruction));
+        uint32_t* new_line_list = (uint32_t*)realloc(chunk->line_list, chunk->bin_capacity * sizeof(uint32_t));
+        if(new_list)
+            bin_instructions_array->bin_instruction_list = new_list;
+        if(new_line_list)
+            chunk->line_list = new_line_list;
+        if(!new_list || !new_line_list){
+            THROW(BIN_INSTRUCTION_ARRAY_REALLOC_FAILURE, "Error: Failed to reallocate bin instructions!\n");
+        }
+    }
+
+    uint32_t instruction = bin_instructions_array->count;
+    assemble_text_instruction(&bin_instructions_array->bin_instruction_list[instruction], text_instruction);
+
+    // Args are not cleared by assemble_text_instruction
+    for(uint32_t arg_count = text_instruction->operation.num_of_args; arg_count < 3; arg_count ++){
+        bin_instructions_array->bin_instruction_list[instruction].arg_list[arg_count] = 0;
+    }
+
+    // Every label use is patched after merge, local addresses aren't final
+    for(uint32_t arg_count = 0; arg_count < text_instruction->operation.num_of_args; arg_count ++){
+        uint32_t label_index = text_instruction->imm[arg_count].label;
+        if(label_index == 0)
+            continue;
+
+        if(chunk->references_count == chunk->references_capacity){
+            chunk->references_capacity = chunk->references_capacity ? chunk->references_capacity * 2 :
+                                                                       LABEL_TABLE_INIT_SIZE;
+            LabelReference* new_list = (LabelReference*)realloc(chunk->reference_list, chunk->references_capacity *
+                                                                                       sizeof(LabelReference));
+            if(!new_list){
+                THROW(FIXUP_LIST_REALLOC_FAILURE, "Error: Failed to reallocate label fixups!\n");
+            }
+            chunk->reference_list = new_list;
+        }
+
+        LabelReference* reference = &chunk->reference_list[chunk->references_count ++];
+        reference->instruction = instruction;
+        reference->arg = arg_count;
+        reference->label = label_index - 1;
+    }
+
+    chunk->line_list[instruction] = line_number;
+    bin_instructions_array->count ++;
+}
+
+static void* chunk_parse(void* chunk_ptr){
+    AssemblyChunk* chunk = (AssemblyChunk*)chunk_ptr;
+
+    // Exceptions can't cross threads, they are rethrown by main thread after join
+    TRY{
+        Lexer lexer;
+        lexer_init_range(&lexer, chunk->begin, chunk->end);
+        StringView line;
+
+        TextInstruction text_instruction = {};
+
+        while (lexer_next_line(&lexer, &line)) {
+            uint32_t address = chunk->bin_instructions_array.count * BIN_INSTRUCTION_SIZE;
+            uint32_t defined_label = 0;
+
+            if(parse_line(line, &chunk->label_table, &text_instruction, address, lexer.line_number,
+                          &defined_label) == LINE_INSTRUCTION){
+                chunk_emit_instruction(chunk, &text_instruction, lexer.line_number);
+            }
+        }
+
+        chunk->lines_count = lexer.line_number;
+    }
+    CATCH_ALL{
+        chunk->failed = true;
+        chunk->exception = _context.exception;
+    }
+    END_TRY;
+
+    return NULL;
+}
+
+// Labels are merged in chunk order, so label table keeps order of first appearance
+static void chunks_merge_labels(AssemblyChunk* chunk_list, uint32_t chunks_count, LabelTable* label_table){
+    uint32_t instruction_offset = 0;
+    uint32_t line_offset = 0;
+
+    for(uint32_t chunk_index = 0; chunk_index < chunks_count; chunk_index ++){
+        AssemblyChunk* chunk = &chunk_list[chunk_index];
+        chunk->instruction_offset = instruction_offset;
+        chunk->line_offset = line_offset;
+        instruction_offset += chunk->bin_instructions_array.count;
+        line_offset += chunk->lines_count;
+
+        chunk->label_map = (uint32_t*)calloc(chunk->label_table.count + 1, sizeof(uint32_t));
+        if(!chunk->label_map){
+            THROW(LABEL_TABLE_REALLOC_FAILUR, "Error: Failed to allocate label map!\n");
+        }
+
+        for(uint32_t local_index = 0; local_index < chunk->label_table.count; local_index ++){
+            Label* local_label = &chunk->label_table.label_list[local_index];
+            Label* label = label_table_insert(label_table, local_label->name, local_label->label_size);
+            chunk->label_map[local_index] = (uint32_t)(label - label_table->label_list);
+
+            if(local_label->address == LABEL_UNDEFINED)
+                continue;
+
+            uint32_t address = local_label->address + chunk->instruction_offset * BIN_INSTRUCTION_SIZE;
+            if(label->address == LABEL_UNDEFINED){
+                label->address = address;
+            }
+            else if(label->address != address){
+                printf("Current label address: %u\n", label->address);
+                THROW(LABEL_REDEFINITION, "Error: Label redefinition!\n");
+            }
+        }
+    }
+}
+
+static void* chunk_link(void* chunk_ptr){
+    AssemblyChunk* chunk = (AssemblyChunk*)chunk_ptr;
+    BinInstruction* bin_instruction_list = chunk->output_bin_instructions_array->bin_instruction_list +
+                                           chunk->instruction_offset;
+
+    if(chunk->bin_instructions_array.count)
+        memcpy(bin_instruction_list, chunk->bin_instructions_array.bin_instruction_list,
+               chunk->bin_instructions_array.count * sizeof(BinInstruction));
+
+    // Uses of labels, which are never defined, keep zero address as in sequential assembler
+    for(uint32_t i = 0; i < chunk->references_count; i ++){
+        LabelReference* reference = &chunk->reference_list[i];
+        Label* label = &chunk->output_label_table->label_list[chunk->label_map[reference->label]];
+        bin_instruction_list[reference->instruction].arg_list[reference->arg] =
+            label->address != LABEL_UNDEFINED ? label->address : 0;
+    }
+
+    SourceLine* line_list = chunk->output_symbol_map->line_list + chunk->output_symbol_map->lines_count +
+                            chunk->instruction_offset;
+    for(uint32_t i = 0; i < chunk->bin_instructions_array.count; i ++){
+        line_list[i].address = (chunk->instruction_offset + i) * BIN_INSTRUCTION_SIZE;
+        line_list[i].line = chunk->line_offset + chunk->line_list[i];
+    }
+
+    return NULL;
+}
+
+static void chunks_run(AssemblyChunk* chunk_list, uint32_t chunks_count, void* (*chunk_job)(void*)){
+    pthread_t* thread_list = (pthread_t*)calloc(chunks_count, sizeof(pthread_t));
+    if(!thread_list){
+        fprintf(stderr, "Error: Cannot allocate assembler threads!\n");
+        abort();
+    }
+
+    // First chunk is processed by calling thread
+    for(uint32_t chunk_index = 1; chunk_index < chunks_count; chunk_index ++){
+        if(pthread_create(&thread_list[chunk_index], NULL, chunk_job, &chunk_list[chunk_index]) != 0){
+            fprintf(stderr, "Error: Cannot create assembler thread!\n");
+            abort();
+        }
+    }
+    chunk_job(&chunk_list[0]);
+
+    for(uint32_t chunk_index = 1; chunk_index < chunks_count; chunk_index ++){
+        pthread_join(thread_list[chunk_index], NULL);
+    }
+    free(thread_list);
+}
+
+static void chunks_split(SourceFile* source_file, AssemblyChunk* chunk_list, uint32_t chunks_count){
+    const char* source_end = source_file->data + source_file->size;
+    const char* begin = source_file->data;
+
+    for(uint32_t chunk_index = 0; chunk_index < chunks_count; chunk_index ++){
+        const char* end = source_end;
+
+        // Chunks end after line feed, so every chunk starts with new line
+        if(chunk_index + 1 < chunks_count){
+            end = source_file->data + source_file->size / chunks_count * (chunk_index + 1);
+            if(end < begin)
+                end = begin;
+
+            const char* line_feed = (const char*)memchr(end, '\n', source_end - end);
+            end = line_feed ? line_feed + 1 : source_end;
+        }
+
+        chunk_list[chunk_index].begin = begin;
+        chunk_list[chunk_index].end = end;
+        begin = end;
+    }
+}
+
+static void chunks_free(AssemblyChunk* chunk_list, uint32_t chunks_count){
+    for(uint32_t chunk_index = 0; chunk_index < chunks_count; chunk_index ++){
+        AssemblyChunk* chunk = &chunk_list[chunk_index];
+        free(chunk->bin_instructions_array.bin_instruction_list);
+        free(chunk->line_list);
+        free(chunk->reference_list);
+        free(chunk->label_map);
+        free_label_table(&chunk->label_table);
+    }
+    free(chunk_list);
+}
+
+void assemble_text_asm_file_parallel(const char* file_name, BinInstructionArray* bin_instructions_array,
+                                     LabelTable* label_table, SymbolMap* symbol_map, uint32_t jobs_count){
+    bin_instructions_array->count = 0;
+    bin_instructions_array->bin_instruction_list = NULL;
+
+    // Structures are initialized before opening file, so they can be freed after error
+    label_table_init(label_table);
+
+    SourceFile source_file;
+    source_file_open(&source_file, file_name);
+
+    // Small sources aren't worth of threads
+    uint32_t chunks_count = jobs_count ? jobs_count : 1;
+    if(source_file.size / PARALLEL_CHUNK_MIN_SIZE + 1 < chunks_count)
+        chunks_count = (uint32_t)(source_file.size / PARALLEL_CHUNK_MIN_SIZE + 1);
+
+    AssemblyChunk* chunk_list = (AssemblyChunk*)calloc(chunks_count, sizeof(AssemblyChunk));
+    if(!chunk_list){
+        THROW(BIN_INSTRUCTION_ARRAY_REALLOC_FAILURE, "Error: Failed to allocate source chunks!\n");
+    }
+
+    chunks_split(&source_file, chunk_list, chunks_count);
+    for(uint32_t chunk_index = 0; chunk_index < chunks_count; chunk_index ++){
+        label_table_init(&chunk_list[chunk_index].label_table);
+    }
+
+    chunks_run(chunk_list, chunks_count, chunk_parse);
+
+    // First error in source order is reported, as sequential assembler does
+    for(uint32_t chunk_index = 0; chunk_index < chunks_count; chunk_index ++){
+        if(chunk_list[chunk_index].failed){
+            Exception exception = chunk_list[chunk_index].exception;
+            chunks_free(chunk_list, chunks_count);
+            source_file_close(&source_file);
+            THROW(exception.code, exception.message);
+        }
+    }
+
+    chunks_merge_labels(chunk_list, chunks_count, label_table);
+
+    AssemblyChunk* last_chunk = &chunk_list[chunks_count - 1];
+    bin_instructions_array->count = last_chunk->instruction_offset + last_chunk->bin_instructions_array.count;
+    bin_instructions_array->bin_instruction_list = (BinInstruction*)malloc((bin_instructions_array->count + 1) *
+                                                                           sizeof(BinInstruction));
+    if(!bin_instructions_array->bin_instruction_list){
+        THROW(BIN_INSTRUCTION_ARRAY_REALLOC_FAILURE, "Error: Failed to allocate bin instructions!\n");
+    }
+    symbol_map_reserve_lines(symbol_map, bin_instructions_array->count);
+
+    for(uint32_t chunk_index = 0; chunk_index < chunks_count; chunk_index ++){
+        chunk_list[chunk_index].output_bin_instructions_array = bin_instructions_array;
+        chunk_list[chunk_index].output_label_table = label_table;
+        chunk_list[chunk_index].output_symbol_map = symbol_map;
+    }
+
+    chunks_run(chunk_list, chunks_count, chunk_link);
+    symbol_map->lines_count += bin_instructions_array->count;
+
+    chunks_free(chunk_list, chunks_count);
+    source_file_close(&source_file);
 }
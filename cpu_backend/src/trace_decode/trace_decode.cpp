@@ -0,0 +1,112 @@
+#include "instructions/instructions.h"
+#include "binary_format/binary_format.h"
+#include "disassembler/disassembler.h"
+#include "cpu_emulator/trace.h"
+#include "symbols/symbols.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+//------------------------------------PROGRAM-----------------------------------
+
+//------------------------------------DECODING-----------------------------------
+
+static void print_trace_record(TraceRecord* record, uint64_t index, BinInstructionArray* bin_instructions_array,
+                               SymbolMap* symbol_map){
+    printf("%10lu  ", index);
+
+    if(symbol_map->symbols_count != 0){
+        char location[64] = "";
+        const Symbol* symbol = symbol_map_find(symbol_map, record->pc);
+        if(symbol)
+            snprintf(location, sizeof(location), ":%s+%x", symbol->name, record->pc - symbol->address);
+        printf("%-24s  ", location);
+    }
+
+    uint32_t instruction_index = record->pc / BIN_INSTRUCTION_SIZE;
+    if(record->pc % BIN_INSTRUCTION_SIZE == 0 && instruction_index < bin_instructions_array->count){
+        TextInstruction text_instruction = {};
+        instruction_disassemble(&bin_instructions_array->bin_instruction_list[instruction_index], &text_instruction);
+        print_text_instruction(&text_instruction, record->pc);
+    }
+    else{
+        printf("%08x  op %02x (outside of program)  ", record->pc, record->op_code);
+    }
+
+    if(record->flags & TRACE_HAS_OPERANDS){
+        printf("| %08x %08x %08x", record->operand_values[0], record->operand_values[1], record->operand_values[2]);
+    }
+
+    if(record->flags & TRACE_HAS_MEMORY){
+        printf(" @ %08x", record->memory_address);
+    }
+
+    printf("\n");
+}
+
+static void decode_trace_file(const char* trace_file_name, BinInstructionArray* bin_instructions_array,
+                              SymbolMap* symbol_map){
+    FILE* trace_file = fopen(trace_file_name, "rb");
+    if(!trace_file){
+        perror("Failed to open");
+        abort();
+    }
+
+    TraceFileHeader header;
+    if(fread(&header, sizeof(header), 1, trace_file) != 1 ||
+       memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0 || header.version != TRACE_VERSION){
+        fprintf(stderr, "Error: %s is not a trace file!\n", trace_file_name);
+        fclose(trace_file);
+        abort();
+    }
+
+    if(header.record_size != TRACE_SHORT_RECORD_SIZE && header.record_size != TRACE_FULL_RECORD_SIZE){
+        fprintf(stderr, "Error: Unsupported trace record size %u!\n", header.record_size);
+        fclose(trace_file);
+        abort();
+    }
+
+    uint64_t index = header.first_record;
+    TraceRecord record = {};
+    while(fread(&record, header.record_size, 1, trace_file) == 1){
+        print_trace_record(&record, index, bin_instructions_array, symbol_map);
+        index ++;
+    }
+
+    fclose(trace_file);
+}
+
+//---------------------------------------MAIN----------------------------------------
+
+int main(int argc, char* argv[]){
+    if(argc != 3){
+        fprintf(stderr, "Usage: trace_decode trace_file program.bin\n");
+        abort();
+    }
+
+    const char* trace_file_name = argv[1];
+    const char* bin_file_name = argv[2];
+
+    BinInstructionArray bin_instructions_array;
+    binary_read_file(bin_file_name, &bin_instructions_array);
+
+    // Labels are printed, if assembler symbol file is near bin file or symbols are embedded into it
+    char* symbol_file_name = (char*)calloc(strlen(bin_file_name) + sizeof(SYMBOL_FILE_SUFFIX), sizeof(char));
+    strcpy(symbol_file_name, bin_file_name);
+    strcat(symbol_file_name, SYMBOL_FILE_SUFFIX);
+    if(access(symbol_file_name, F_OK) != 0)
+        strcpy(symbol_file_name, bin_file_name);
+
+    SymbolMap symbol_map;
+    symbol_map_init(&symbol_map);
+    binary_read_symbols(symbol_file_name, &symbol_map);
+
+    decode_trace_file(trace_file_name, &bin_instructions_array, &symbol_map);
+
+    symbol_map_free(&symbol_map);
+    free(symbol_file_name);
+    free(bin_instructions_array.bin_instruction_list);
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "verifier/verifier.h"
+#include "cpu_emulator/cpu.h"
+
+//-------------------------------ARGS-------------------------------
+
+// Returns error message or NULL if arg is valid for its role
+static const char* verify_arg(uint32_t operation, uint32_t arg, uint32_t value, ArgRole role, uint32_t code_size){
+    bool in_memory = operation & ARG_FLAG_MEMORY(arg);
+    bool in_register = operation & ARG_FLAG_REGISTER(arg);
+
+    if(in_register && value >= NUM_OF_REGISTERS)
+        return "register number is out of range";
+
+    switch(role){
+        case ARG_SOURCE:
+            return NULL;
+
+        case ARG_DESTINATION:
+            if(!in_memory && !in_register)
+                return "destination can't be immediate";
+            if(!in_memory && value == RPC)
+                return "rpc is written only by control flow instructions";
+            return NULL;
+
+        case ARG_SOURCE_REGISTER:
+        case ARG_DESTINATION_REGISTER:
+            if(in_memory || !in_register)
+                return "arg must be register";
+            if(role == ARG_DESTINATION_REGISTER && value == RPC)
+                return "rpc is written only by control flow instructions";
+            return NULL;
+
+        case ARG_TARGET:
+            if(in_memory || in_register)
+                return "target must be immediate address";
+            if(value % BIN_INSTRUCTION_SIZE != 0)
+                return "target isn't aligned on instruction";
+            if(value >= code_size)
+                return "target is out of program";
+            return NULL;
+
+        case ARG_SOURCE_ADDRESS:
+        case ARG_DESTINATION_ADDRESS:
+            if(!in_memory)
+                return "arg must be memory address";
+            return NULL;
+
+        case ARG_NONE:
+            break;
+    }
+    return "instruction has too many args";
+}
+
+//-------------------------------PROGRAM-------------------------------
+
+bool program_verify(const BinInstruction* instruction_list, uint32_t count, VerifierError* error){
+    uint32_t code_size = count * BIN_INSTRUCTION_SIZE;
+
+    for(uint32_t i = 0; i < count; i ++){
+        const BinInstruction* instruction = &instruction_list[i];
+        uint32_t op_code = instruction->operation >> 24;
+
+        error->address = i * BIN_INSTRUCTION_SIZE;
+
+        if(op_code >= INSTRUCTIONS_SET_NUMBER){
+            error->message = "unknown op code";
+            return false;
+        }
+
+        const InstructionSet* instruction_info = &instruction_set[op_code];
+        uint32_t known_flags = 0;
+
+        for(uint32_t arg = 0; arg < (uint32_t)instruction_info->num_of_args; arg ++){
+            const char* message = verify_arg(instruction->operation, arg, instruction->arg_list[arg],
+                                             instruction_info->arg_roles[arg], code_size);
+            if(message){
+                error->message = message;
+                return false;
+            }
+            known_flags |= ARG_FLAG_MEMORY(arg) | ARG_FLAG_REGISTER(arg);
+        }
+
+        if(instruction->operation & 0x00ffffff & ~known_flags){
+            error->message = "unknown flags in operation";
+            return false;
+        }
+    }
+
+    // Last instruction must not fall through, calls fall through on return
+    if(count == 0){
+        error->address = 0;
+        error->message = "program is empty";
+        return false;
+    }
+
+    InstructionFlow last_flow = instruction_set[instruction_list[count - 1].operation >> 24].flow;
+    if(last_flow != FLOW_JUMP && last_flow != FLOW_RETURN && last_flow != FLOW_HALT){
+        error->address = code_size - BIN_INSTRUCTION_SIZE;
+        error->message = "execution can run past the last instruction";
+        return false;
+    }
+
+    return true;
+}